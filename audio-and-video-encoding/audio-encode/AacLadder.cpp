@@ -0,0 +1,316 @@
+#include "AacLadder.h"
+
+#include <chrono>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+}
+
+AacLadder::AacLadder() {
+    memset(&enc_layout_, 0, sizeof(enc_layout_));
+    dispatch_frame_ = [this](int nb_samples) {
+        AudioEncoder::Result r;
+        int ret = dispatchFrame(nb_samples);
+        if (ret < 0) {
+            r.status = AudioEncoder::Status::EncodeError;
+            r.av_error = ret;
+            r.message = error_;
+        }
+        return r;
+    };
+}
+
+AacLadder::~AacLadder() {
+    for (auto &rung : rungs_) {
+        {
+            std::lock_guard<std::mutex> lock(rung->mutex);
+            rung->finished = true;
+            rung->failed = true; // 未 finish 就析构：不再编码剩余帧
+            rung->cond_not_empty.notify_one();
+        }
+        if (rung->thread.joinable()) rung->thread.join();
+        closeRung(*rung);
+    }
+    av_channel_layout_uninit(&enc_layout_);
+}
+
+int AacLadder::setError(int ret, const char *what) {
+    char err_buf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(ret, err_buf, AV_ERROR_MAX_STRING_SIZE);
+    error_ = std::string(what) + ": " + err_buf;
+    return ret;
+}
+
+int AacLadder::setError(const AudioEncoder::Result &r) {
+    if (r.ok()) return 0;
+    error_ = r.message;
+    return r.av_error < 0 ? r.av_error : AVERROR_EXTERNAL;
+}
+
+int AacLadder::openRung(RungState &rung, const AVCodec *codec, const AudioEncoder::Config &input) {
+    rung.codec_ctx = avcodec_alloc_context3(codec);
+    rung.pkt = av_packet_alloc();
+    if (!rung.codec_ctx || !rung.pkt) return AVERROR(ENOMEM);
+
+    // 除码率外所有档参数相同，保证同一份帧能送给每个编码器
+    rung.codec_ctx->bit_rate = rung.bit_rate;
+    rung.codec_ctx->sample_rate = input.sample_rate;
+    rung.codec_ctx->time_base = AVRational{1, input.sample_rate};
+    rung.codec_ctx->sample_fmt = codec->sample_fmts ? codec->sample_fmts[0] : AV_SAMPLE_FMT_FLTP;
+    av_channel_layout_default(&rung.codec_ctx->ch_layout, input.channels);
+
+    int ret = avcodec_open2(rung.codec_ctx, codec, nullptr);
+    if (ret < 0) return ret;
+
+    avformat_alloc_output_context2(&rung.fmt_ctx, nullptr, nullptr, rung.output.c_str());
+    if (!rung.fmt_ctx) return AVERROR(EINVAL);
+    rung.stream = avformat_new_stream(rung.fmt_ctx, nullptr);
+    if (!rung.stream) return AVERROR(ENOMEM);
+    avcodec_parameters_from_context(rung.stream->codecpar, rung.codec_ctx);
+
+    if (!(rung.fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
+        ret = avio_open(&rung.fmt_ctx->pb, rung.output.c_str(), AVIO_FLAG_WRITE);
+        if (ret < 0) return ret;
+    }
+    return avformat_write_header(rung.fmt_ctx, nullptr);
+}
+
+void AacLadder::closeRung(RungState &rung) {
+    for (AVFrame *f : rung.queue) {
+        av_frame_free(&f);
+    }
+    rung.queue.clear();
+    if (rung.fmt_ctx) {
+        if (!(rung.fmt_ctx->oformat->flags & AVFMT_NOFILE)) avio_closep(&rung.fmt_ctx->pb);
+        avformat_free_context(rung.fmt_ctx);
+        rung.fmt_ctx = nullptr;
+    }
+    avcodec_free_context(&rung.codec_ctx);
+    av_packet_free(&rung.pkt);
+}
+
+void AacLadder::closeRungs() {
+    for (auto &rung : rungs_) {
+        closeRung(*rung);
+    }
+    rungs_.clear();
+}
+
+int AacLadder::open(const std::vector<Rung> &rungs, const AudioEncoder::Config &input) {
+    if (rungs.empty() || input.channels <= 0 || input.channels > AudioEncoder::MAX_CHANNELS
+        || input.sample_rate <= 0) {
+        error_ = "invalid ladder or input format";
+        return AVERROR(EINVAL);
+    }
+    input_ = input;
+
+    const AVCodec *codec = input.codec_name.empty()
+                               ? avcodec_find_encoder(AV_CODEC_ID_AAC)
+                               : avcodec_find_encoder_by_name(input.codec_name.c_str());
+    if (!codec) {
+        error_ = "codec not found: " + (input.codec_name.empty() ? std::string("default AAC") : input.codec_name);
+        return AVERROR_ENCODER_NOT_FOUND;
+    }
+
+    for (const Rung &r : rungs) {
+        std::unique_ptr<RungState> rung(new RungState());
+        rung->bit_rate = r.bit_rate;
+        rung->output = r.output;
+        int ret = openRung(*rung, codec, input);
+        if (ret < 0) {
+            setError(ret, rung->output.c_str());
+            closeRung(*rung);
+            closeRungs(); // 前面已打开的档不能留着，否则 finish() 会把它们算作成功
+            return ret;
+        }
+        rungs_.push_back(std::move(rung));
+    }
+
+    // 重采样和 FIFO 只有一份，目标格式取第一档编码器的 (所有档相同)
+    const AVCodecContext *ref = rungs_[0]->codec_ctx;
+    enc_fmt_ = ref->sample_fmt;
+    av_channel_layout_copy(&enc_layout_, &ref->ch_layout);
+
+    int ret = setError(framer_.open(input, ref));
+    if (ret < 0) {
+        closeRungs();
+        return ret;
+    }
+
+    for (auto &rung : rungs_) {
+        rung->thread = std::thread(&AacLadder::rungLoop, this, rung.get());
+    }
+    return 0;
+}
+
+void AacLadder::failRung(RungState &rung, int ret, const char *what) {
+    char err_buf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(ret, err_buf, AV_ERROR_MAX_STRING_SIZE);
+
+    std::lock_guard<std::mutex> lock(rung.mutex);
+    rung.failed = true;
+    rung.error = std::string(what) + ": " + err_buf;
+    for (AVFrame *f : rung.queue) {
+        av_frame_free(&f);
+    }
+    rung.queue.clear();
+    rung.cond_not_full.notify_all(); // 读取端不再等这一档
+}
+
+int AacLadder::encodeFrame(RungState &rung, AVFrame *frame) {
+    int ret = avcodec_send_frame(rung.codec_ctx, frame);
+    if (ret < 0) {
+        failRung(rung, ret, "avcodec_send_frame");
+        return ret;
+    }
+
+    while (true) {
+        ret = avcodec_receive_packet(rung.codec_ctx, rung.pkt);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) return 0;
+        if (ret < 0) {
+            failRung(rung, ret, "avcodec_receive_packet");
+            return ret;
+        }
+
+        rung.pkt->stream_index = rung.stream->index;
+        av_packet_rescale_ts(rung.pkt, rung.codec_ctx->time_base, rung.stream->time_base);
+        rung.packets++;
+        rung.bytes += rung.pkt->size;
+
+        ret = av_interleaved_write_frame(rung.fmt_ctx, rung.pkt);
+        av_packet_unref(rung.pkt);
+        if (ret < 0) {
+            failRung(rung, ret, "av_interleaved_write_frame");
+            return ret;
+        }
+    }
+}
+
+void AacLadder::rungLoop(RungState *rung) {
+    while (true) {
+        AVFrame *frame = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(rung->mutex);
+            rung->cond_not_empty.wait(lock, [&] { return rung->finished || !rung->queue.empty(); });
+            if (rung->failed) return;
+            if (rung->queue.empty()) break; // finished 且已取完
+            frame = rung->queue.front();
+            rung->queue.pop_front();
+            rung->cond_not_full.notify_one();
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        int ret = encodeFrame(*rung, frame);
+        rung->encode_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        av_frame_free(&frame);
+        if (ret < 0) return;
+    }
+
+    // 输入结束：flush 编码器并写文件尾
+    const auto start = std::chrono::steady_clock::now();
+    if (encodeFrame(*rung, nullptr) < 0) return;
+    int ret = av_write_trailer(rung->fmt_ctx);
+    if (ret < 0) failRung(*rung, ret, "av_write_trailer");
+    rung->encode_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int AacLadder::dispatchFrame(int nb_samples) {
+    AVFrame *frame = av_frame_alloc();
+    if (!frame) return setError(AVERROR(ENOMEM), "av_frame_alloc");
+    frame->nb_samples = nb_samples;
+    frame->format = enc_fmt_;
+    frame->sample_rate = input_.sample_rate;
+    av_channel_layout_copy(&frame->ch_layout, &enc_layout_);
+
+    // 每帧一块新缓冲：编码线程持有引用期间数据不能被覆盖
+    int ret = av_frame_get_buffer(frame, 0);
+    if (ret < 0) {
+        av_frame_free(&frame);
+        return setError(ret, "av_frame_get_buffer");
+    }
+    ret = setError(framer_.read(frame, nb_samples));
+    if (ret < 0) {
+        av_frame_free(&frame);
+        return ret;
+    }
+    frame->pts = next_pts_;
+    next_pts_ += nb_samples;
+
+    int alive = 0;
+    for (auto &rung : rungs_) {
+        std::unique_lock<std::mutex> lock(rung->mutex);
+        rung->cond_not_full.wait(lock, [&] { return rung->failed || rung->queue.size() < max_queue_; });
+        if (rung->failed) continue;
+
+        // av_frame_clone 只增加数据缓冲的引用计数
+        AVFrame *ref = av_frame_clone(frame);
+        if (!ref) {
+            av_frame_free(&frame);
+            return setError(AVERROR(ENOMEM), "av_frame_clone");
+        }
+        rung->queue.push_back(ref);
+        rung->cond_not_empty.notify_one();
+        alive++;
+    }
+    av_frame_free(&frame);
+
+    if (alive == 0) {
+        error_ = "all rungs failed";
+        return AVERROR_EXTERNAL;
+    }
+    return 0;
+}
+
+int AacLadder::encode(const uint8_t *data, int samples) {
+    if (!framer_.isOpen()) return AVERROR(EINVAL);
+    return setError(framer_.write(data, samples, dispatch_frame_));
+}
+
+int AacLadder::encodeStream(FILE *in, int64_t max_bytes) {
+    if (!framer_.isOpen()) return AVERROR(EINVAL);
+    return setError(framer_.writeStream(in, max_bytes, dispatch_frame_, nullptr));
+}
+
+int AacLadder::finish() {
+    if (framer_.isOpen()) {
+        // 冲刷重采样器，剩余不足一帧的尾巴作为最后一个短帧
+        if (setError(framer_.flush(dispatch_frame_)) == 0) {
+            const int tail = framer_.buffered();
+            if (tail > 0) dispatchFrame(tail);
+        }
+    }
+
+    int ok = 0;
+    for (auto &rung : rungs_) {
+        {
+            std::lock_guard<std::mutex> lock(rung->mutex);
+            rung->finished = true;
+            rung->cond_not_empty.notify_one();
+        }
+        if (rung->thread.joinable()) rung->thread.join();
+        if (!rung->failed) ok++;
+    }
+    return ok;
+}
+
+void AacLadder::printStats(double wall_seconds) const {
+    const double duration = input_.sample_rate > 0 ? static_cast<double>(next_pts_) / input_.sample_rate : 0;
+
+    printf("%-10s %10s %10s %12s %8s  %s\n", "Target", "Actual", "Size KB", "Encode s", "x RT", "Output");
+    for (const auto &rung : rungs_) {
+        char target[32];
+        snprintf(target, sizeof(target), "%lldk", static_cast<long long>(rung->bit_rate / 1000));
+        printf("%-10s %9.1fk %10.1f %12.2f %8.1f  %s%s%s\n",
+               target,
+               duration > 0 ? rung->bytes * 8 / duration / 1000.0 : 0.0,
+               rung->bytes / 1024.0,
+               rung->encode_seconds,
+               rung->encode_seconds > 0 ? duration / rung->encode_seconds : 0.0,
+               rung->output.c_str(),
+               rung->failed ? "  FAILED: " : "",
+               rung->failed ? rung->error.c_str() : "");
+    }
+    printf("Audio %.1fs, wall %.2fs, %.1fx realtime for the whole ladder\n",
+           duration, wall_seconds, wall_seconds > 0 ? duration / wall_seconds : 0.0);
+}
@@ -0,0 +1,115 @@
+#ifndef AACLADDER_H
+#define AACLADDER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdint>
+
+#include "AudioEncoder.h"
+
+/**
+ * 多码率 AAC 阶梯：一份 PCM 同时编出多档码率 (如 64k / 128k / 256k)
+ *
+ * 输入读取、重采样和 FIFO 凑帧只做一次 (调用 encode() 的线程，与 AudioEncoder 共用 AudioEncoder::Framer)，
+ * 凑好的 frame_size 帧用 av_frame_clone 按引用分发给每一档 (数据不拷贝)，
+ * 每一档有自己的 AVCodecContext、输出文件和编码线程。
+ *
+ * 每档的帧队列有界，满了读取端等待 (所有档都要完整输出，不丢帧)；
+ * 某一档编码或写入失败只停掉这一档，其他档继续。
+ */
+class AacLadder {
+public:
+    struct Rung {
+        int64_t bit_rate;
+        std::string output;
+    };
+
+    AacLadder();
+
+    ~AacLadder();
+
+    // 打开每一档的编码器和输出并启动编码线程，input 给出输入格式和编码器名 (bit_rate 字段不用)
+    // 返回 0 成功，负数为 AVERROR
+    int open(const std::vector<Rung> &rungs, const AudioEncoder::Config &input);
+
+    // 推入 PCM，布局与 AudioEncoder::encode 相同
+    int encode(const uint8_t *data, int samples);
+
+    // 从文件读取 PCM 直到 EOF (或读满 max_bytes)
+    int encodeStream(FILE *in, int64_t max_bytes = -1);
+
+    // 冲刷重采样器和尾帧，等待各档编码线程结束并写文件尾；返回成功完成的档数
+    int finish();
+
+    // 打印每一档的实际码率、编码耗时和错误
+    void printStats(double wall_seconds) const;
+
+    const std::string &error() const { return error_; }
+
+private:
+    struct RungState {
+        int64_t bit_rate = 0;
+        std::string output;
+        AVCodecContext *codec_ctx = nullptr;
+        AVFormatContext *fmt_ctx = nullptr;
+        AVStream *stream = nullptr;
+        AVPacket *pkt = nullptr;
+
+        std::deque<AVFrame *> queue;
+        std::mutex mutex;
+        std::condition_variable cond_not_empty;
+        std::condition_variable cond_not_full;
+        bool finished = false;
+        bool failed = false;
+        std::string error;
+
+        int64_t packets = 0;
+        int64_t bytes = 0;
+        double encode_seconds = 0; // 编码线程在 send/receive/write 上花的时间
+        std::thread thread;
+    };
+
+    int openRung(RungState &rung, const AVCodec *codec, const AudioEncoder::Config &input);
+
+    void closeRung(RungState &rung);
+    // open 中途失败时关闭已打开的档并清空，线程尚未启动
+    void closeRungs();
+
+    // 编码线程
+    void rungLoop(RungState *rung);
+
+    // frame 为 nullptr 时 flush 编码器
+    int encodeFrame(RungState &rung, AVFrame *frame);
+
+    void failRung(RungState &rung, int ret, const char *what);
+
+    // 从 FIFO 取 nb_samples 个样本组成一帧，按引用放进每一档的队列
+    int dispatchFrame(int nb_samples);
+
+    int setError(int ret, const char *what);
+
+    // Framer 返回的 Result 转成 AVERROR，错误描述记到 error_
+    int setError(const AudioEncoder::Result &r);
+
+    std::vector<std::unique_ptr<RungState>> rungs_;
+    AudioEncoder::Config input_;
+    size_t max_queue_ = 32;
+
+    AudioEncoder::Framer framer_; // 重采样 + FIFO 凑帧，只有一份
+    AudioEncoder::Framer::FrameSink dispatch_frame_; // 绑定 dispatchFrame
+
+    // 编码器格式 (所有档相同)
+    AVSampleFormat enc_fmt_ = AV_SAMPLE_FMT_NONE;
+    AVChannelLayout enc_layout_;
+    int64_t next_pts_ = 0;
+
+    std::string error_;
+};
+
+#endif // AACLADDER_H
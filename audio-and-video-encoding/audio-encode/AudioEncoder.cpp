@@ -0,0 +1,407 @@
+#include "AudioEncoder.h"
+
+#include <iostream>
+#include <vector>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+#include <libavutil/opt.h>
+}
+
+const int AudioEncoder::READ_CHUNK_SAMPLES;
+const int AudioEncoder::MAX_CHANNELS;
+
+// ================= Framer =================
+
+AudioEncoder::Result AudioEncoder::Framer::open(const Config &input, const AVCodecContext *enc) {
+    close();
+    input_ = input;
+    enc_channels_ = enc->ch_layout.nb_channels;
+    enc_fmt_ = enc->sample_fmt;
+    // 编码器要求每帧恰好 frame_size 个样本 (AAC 为 1024)；可变帧长的编码器没有这个限制，按 1024 取
+    frame_size_ = enc->frame_size > 0 ? enc->frame_size : 1024;
+
+    // 无论输入是什么格式(S16/F32)，都转为编码器需要的格式
+    AVChannelLayout in_ch_layout;
+    av_channel_layout_default(&in_ch_layout, input.channels);
+    int ret = swr_alloc_set_opts2(&swr_ctx_,
+                                  &enc->ch_layout, enc->sample_fmt, enc->sample_rate,
+                                  &in_ch_layout, input.input_fmt, input.sample_rate,
+                                  0, nullptr);
+    if (ret < 0) return fail(Status::ResampleError, ret, "swr_alloc_set_opts2");
+    ret = swr_init(swr_ctx_);
+    if (ret < 0) return fail(Status::ResampleError, ret, "swr_init");
+
+    // FIFO 里存放已转换为编码器格式的样本；一次推入的量不限，FIFO 会按需增长
+    fifo_ = av_audio_fifo_alloc(enc_fmt_, enc_channels_, frame_size_ + READ_CHUNK_SAMPLES);
+    if (!fifo_) return fail(Status::OutOfMemory, AVERROR(ENOMEM), "av_audio_fifo_alloc");
+    return Result();
+}
+
+AudioEncoder::Result AudioEncoder::Framer::restart() {
+    // swr_init 会清掉上次冲刷留下的内部状态
+    int ret = swr_init(swr_ctx_);
+    if (ret < 0) return fail(Status::ResampleError, ret, "swr_init");
+    av_audio_fifo_reset(fifo_);
+    return Result();
+}
+
+void AudioEncoder::Framer::close() {
+    swr_free(&swr_ctx_);
+    if (fifo_) av_audio_fifo_free(fifo_);
+    fifo_ = nullptr;
+    if (conv_data_) {
+        av_freep(&conv_data_[0]);
+        av_freep(&conv_data_);
+    }
+    conv_capacity_ = 0;
+}
+
+AudioEncoder::Result AudioEncoder::Framer::write(const uint8_t *data, int samples, const FrameSink &sink) {
+    if (!swr_ctx_) return fail(Status::InvalidArgument, 0, "resampler not open");
+    if (samples == 0) return Result();
+    if (!data || samples < 0) return fail(Status::InvalidArgument, 0, "invalid input buffer");
+
+    // 把一整块数据拆成各声道的指针 (packed 格式只有一个平面)
+    uint8_t *in_data[MAX_CHANNELS] = {nullptr};
+    int ret = av_samples_fill_arrays(in_data, nullptr, data, input_.channels, samples, input_.input_fmt, 1);
+    if (ret < 0) return fail(Status::InvalidArgument, ret, "av_samples_fill_arrays");
+    return feed(const_cast<const uint8_t **>(in_data), samples, sink);
+}
+
+AudioEncoder::Result AudioEncoder::Framer::writeStream(FILE *in, int64_t max_bytes, const FrameSink &sink,
+                                                       int *partial_bytes) {
+    // 按固定大小分块读取，不要求输入长度是 frame_size 的整数倍
+    const int bytes_per_sample = input_.channels * av_get_bytes_per_sample(input_.input_fmt); // 一个采样点 (所有声道)
+    std::vector<uint8_t> input_buf(READ_CHUNK_SAMPLES * bytes_per_sample);
+
+    int64_t total_bytes = 0;
+    size_t n;
+    while (true) {
+        size_t want = input_buf.size();
+        if (max_bytes >= 0 && static_cast<int64_t>(want) > max_bytes - total_bytes)
+            want = static_cast<size_t>(max_bytes - total_bytes);
+        if (want == 0 || (n = fread(input_buf.data(), 1, want, in)) == 0) break;
+
+        total_bytes += n;
+        // fread 只有在 EOF 时才会返回不足量，此时末尾不足一个采样点的字节丢弃
+        Result r = write(input_buf.data(), static_cast<int>(n / bytes_per_sample), sink);
+        if (!r.ok()) return r;
+    }
+    if (partial_bytes) *partial_bytes = static_cast<int>(total_bytes % bytes_per_sample);
+    return Result();
+}
+
+AudioEncoder::Result AudioEncoder::Framer::flush(const FrameSink &sink) {
+    if (!swr_ctx_) return fail(Status::InvalidArgument, 0, "resampler not open");
+    return feed(nullptr, 0, sink);
+}
+
+AudioEncoder::Result AudioEncoder::Framer::read(AVFrame *frame, int nb_samples) {
+    if (av_audio_fifo_read(fifo_, reinterpret_cast<void **>(frame->data), nb_samples) < nb_samples) {
+        return fail(Status::EncodeError, AVERROR_BUG, "av_audio_fifo_read");
+    }
+    return Result();
+}
+
+AudioEncoder::Result AudioEncoder::Framer::ensureConvCapacity(int nb_samples) {
+    if (nb_samples <= conv_capacity_) return Result();
+    if (conv_data_) {
+        av_freep(&conv_data_[0]);
+        av_freep(&conv_data_);
+    }
+    conv_capacity_ = 0;
+    int ret = av_samples_alloc_array_and_samples(&conv_data_, nullptr, enc_channels_, nb_samples, enc_fmt_, 0);
+    if (ret < 0) return fail(Status::OutOfMemory, ret, "av_samples_alloc_array_and_samples");
+    conv_capacity_ = nb_samples;
+    return Result();
+}
+
+AudioEncoder::Result AudioEncoder::Framer::feed(const uint8_t **in_data, int nb_samples, const FrameSink &sink) {
+    while (true) {
+        // 输出样本数不一定等于输入 (采样率不同或 swr 内部有缓存)，按 swr 给出的上限分配
+        const int out_cap = swr_get_out_samples(swr_ctx_, nb_samples);
+        if (out_cap <= 0) break;
+        Result r = ensureConvCapacity(out_cap);
+        if (!r.ok()) return r;
+
+        const int converted = swr_convert(swr_ctx_, conv_data_, out_cap, in_data, nb_samples);
+        if (converted < 0) return fail(Status::ResampleError, converted, "swr_convert");
+        if (converted > 0 && av_audio_fifo_write(fifo_, reinterpret_cast<void **>(conv_data_), converted) < converted) {
+            return fail(Status::OutOfMemory, AVERROR(ENOMEM), "av_audio_fifo_write");
+        }
+
+        while (av_audio_fifo_size(fifo_) >= frame_size_) {
+            r = sink(frame_size_);
+            if (!r.ok()) return r;
+        }
+
+        // 正常输入只转换一次；冲刷时反复调用直到 swr 吐完
+        if (in_data || converted == 0) break;
+    }
+    return Result();
+}
+
+// ================= AudioEncoder =================
+
+AudioEncoder::AudioEncoder() {
+    pkt_ = av_packet_alloc();
+    send_frame_ = [this](int nb_samples) { return sendFifoFrame(nb_samples); };
+}
+
+AudioEncoder::~AudioEncoder() {
+    closeOutput();
+    releaseCodec();
+    av_packet_free(&pkt_);
+}
+
+AudioEncoder::Result AudioEncoder::fail(Status status, int av_error, const std::string &what) {
+    Result r;
+    r.status = status;
+    r.av_error = av_error;
+    r.message = what;
+    if (av_error < 0) {
+        char err_buf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(av_error, err_buf, AV_ERROR_MAX_STRING_SIZE);
+        r.message += std::string(": ") + err_buf + " (Error code: " + std::to_string(av_error) + ")";
+    }
+    return r;
+}
+
+AudioEncoder::Result AudioEncoder::openCodec(const AVCodec *codec, const Config &config) {
+    codec_ctx_ = avcodec_alloc_context3(codec);
+    if (!codec_ctx_) return fail(Status::OutOfMemory, AVERROR(ENOMEM), "avcodec_alloc_context3");
+
+    // 设置编码参数
+    codec_ctx_->bit_rate = config.bit_rate;
+    codec_ctx_->sample_rate = config.sample_rate; // 简单起见，输出采样率=输入采样率
+    codec_ctx_->time_base = AVRational{1, config.sample_rate}; // PTS 以样本为单位
+    // 自动选择编码器支持的第一个采样格式 (AAC通常是 FLTP, libfdk_aac可能是 S16)
+    codec_ctx_->sample_fmt = codec->sample_fmts ? codec->sample_fmts[0] : AV_SAMPLE_FMT_FLTP;
+    // FFmpeg 6.1: 设置通道布局
+    av_channel_layout_default(&codec_ctx_->ch_layout, config.channels);
+
+    int ret = avcodec_open2(codec_ctx_, codec, nullptr);
+    if (ret < 0) return fail(Status::CodecError, ret, "avcodec_open2");
+    return Result();
+}
+
+AudioEncoder::Result AudioEncoder::setupCodec(const Config &config) {
+    const bool same_codec = codec_ctx_ && config.codec_name == config_.codec_name
+                            && config.bit_rate == config_.bit_rate
+                            && config.sample_rate == config_.sample_rate
+                            && config.channels == config_.channels;
+
+    if (same_codec) {
+        // 上一个任务已经 drain 过编码器，需要重置后才能接收新数据
+        if (codec_ctx_->codec->capabilities & AV_CODEC_CAP_ENCODER_FLUSH) {
+            avcodec_flush_buffers(codec_ctx_);
+        } else {
+            const AVCodec *codec = codec_ctx_->codec;
+            avcodec_free_context(&codec_ctx_);
+            Result r = openCodec(codec, config);
+            if (!r.ok()) return r;
+        }
+
+        Result r = config.input_fmt == config_.input_fmt ? framer_.restart() : framer_.open(config, codec_ctx_);
+        if (!r.ok()) return r;
+        config_ = config;
+        return Result();
+    }
+
+    releaseCodec();
+    config_ = config;
+
+    // 查找编码器
+    const AVCodec *codec = config.codec_name.empty()
+                               ? avcodec_find_encoder(AV_CODEC_ID_AAC)
+                               : avcodec_find_encoder_by_name(config.codec_name.c_str());
+    if (!codec) {
+        return fail(Status::CodecError, 0,
+                    "codec not found: " + (config.codec_name.empty() ? std::string("default AAC") : config.codec_name));
+    }
+
+    Result r = openCodec(codec, config);
+    if (!r.ok()) return r;
+    r = framer_.open(config, codec_ctx_);
+    if (!r.ok()) return r;
+
+    frame_ = av_frame_alloc();
+    if (!frame_) return fail(Status::OutOfMemory, AVERROR(ENOMEM), "av_frame_alloc");
+
+    frame_->nb_samples = framer_.frameSize();
+    frame_->format = codec_ctx_->sample_fmt;
+    av_channel_layout_copy(&frame_->ch_layout, &codec_ctx_->ch_layout);
+    int ret = av_frame_get_buffer(frame_, 0);
+    if (ret < 0) return fail(Status::OutOfMemory, ret, "av_frame_get_buffer");
+    return Result();
+}
+
+void AudioEncoder::releaseCodec() {
+    avcodec_free_context(&codec_ctx_);
+    framer_.close();
+    av_frame_free(&frame_);
+}
+
+AudioEncoder::Result AudioEncoder::openOutput(const char *output) {
+    // "-" 表示写到 stdout：无法从文件名推断格式，固定用 ADTS
+    const bool to_stdout = strcmp(output, "-") == 0;
+    if (to_stdout) output = "pipe:1";
+
+    // 创建封装上下文 (会根据文件名自动识别格式)，负责写入文件和 ADTS 头
+    avformat_alloc_output_context2(&fmt_ctx_, nullptr, to_stdout ? "adts" : nullptr, output);
+    if (!fmt_ctx_) return fail(Status::OutputError, 0, std::string("could not create output context for ") + output);
+
+    stream_ = avformat_new_stream(fmt_ctx_, nullptr);
+    if (!stream_) return fail(Status::OutOfMemory, AVERROR(ENOMEM), "avformat_new_stream");
+    stream_->id = fmt_ctx_->nb_streams - 1;
+    avcodec_parameters_from_context(stream_->codecpar, codec_ctx_);
+
+    if (!(fmt_ctx_->oformat->flags & AVFMT_NOFILE)) {
+        int ret = avio_open(&fmt_ctx_->pb, output, AVIO_FLAG_WRITE);
+        if (ret < 0) return fail(Status::OutputError, ret, std::string("avio_open ") + output);
+    }
+
+    int ret = avformat_write_header(fmt_ctx_, nullptr);
+    if (ret < 0) return fail(Status::OutputError, ret, "avformat_write_header");
+    return Result();
+}
+
+void AudioEncoder::closeOutput() {
+    if (!fmt_ctx_) return;
+    if (!(fmt_ctx_->oformat->flags & AVFMT_NOFILE)) avio_closep(&fmt_ctx_->pb);
+    avformat_free_context(fmt_ctx_);
+    fmt_ctx_ = nullptr;
+    stream_ = nullptr;
+}
+
+AudioEncoder::Result AudioEncoder::open(const char *output, const Config &config) {
+    if (fmt_ctx_) return fail(Status::InvalidArgument, 0, "previous job not finished");
+
+    // 先清掉上一个任务的计数，参数错误提前返回时 samplesEncoded() 也不会报上一个任务的值
+    next_pts_ = 0;
+    frames_sent_ = 0;
+
+    if (!output || config.sample_rate <= 0 || config.channels <= 0 || config.channels > MAX_CHANNELS
+        || av_get_bytes_per_sample(config.input_fmt) <= 0) {
+        return fail(Status::InvalidArgument, 0, "invalid output or input format");
+    }
+    if (!pkt_) return fail(Status::OutOfMemory, AVERROR(ENOMEM), "av_packet_alloc");
+
+    Result r = setupCodec(config);
+    if (r.ok()) r = openOutput(output);
+    if (!r.ok()) {
+        abort();
+        return r;
+    }
+
+    if (verbose_) {
+        // 日志走 stderr，stdout 可能就是 AAC 码流
+        std::clog << "---------------- Config ----------------" << std::endl;
+        std::clog << "Encoder: " << codec_ctx_->codec->name << std::endl;
+        std::clog << "Bitrate: " << codec_ctx_->bit_rate << std::endl;
+        std::clog << "Input Fmt: " << av_get_sample_fmt_name(config.input_fmt) << std::endl;
+        std::clog << "Output Fmt: " << av_get_sample_fmt_name(codec_ctx_->sample_fmt) << std::endl;
+        std::clog << "Frame Size: " << codec_ctx_->frame_size << std::endl;
+        std::clog << "----------------------------------------" << std::endl;
+    }
+    return r;
+}
+
+AudioEncoder::Result AudioEncoder::encode(const uint8_t *data, int samples) {
+    if (!fmt_ctx_) return fail(Status::InvalidArgument, 0, "encode() called without open()");
+
+    Result r = framer_.write(data, samples, send_frame_);
+    // 输入缓冲参数错误不影响当前任务，其他错误后编码器状态未知
+    if (!r.ok() && r.status != Status::InvalidArgument) abort();
+    return r;
+}
+
+AudioEncoder::Result AudioEncoder::encodeStream(FILE *in, int64_t max_bytes) {
+    if (!fmt_ctx_) return fail(Status::InvalidArgument, 0, "encodeStream() called without open()");
+
+    int partial_bytes = 0;
+    Result r = framer_.writeStream(in, max_bytes, send_frame_, &partial_bytes);
+    if (!r.ok()) {
+        abort();
+        return r;
+    }
+    if (verbose_ && partial_bytes) {
+        std::cerr << "Warning: input ends with " << partial_bytes
+                  << " bytes of an incomplete sample, ignored" << std::endl;
+    }
+    return r;
+}
+
+AudioEncoder::Result AudioEncoder::finish() {
+    if (!fmt_ctx_) return fail(Status::InvalidArgument, 0, "finish() called without open()");
+
+    // 冲刷重采样器内部缓存的样本
+    Result r = framer_.flush(send_frame_);
+
+    // 剩余不足一帧的尾巴作为最后一个短帧送入 (不支持短帧的编码器由 libavcodec 补静音)
+    const int tail = framer_.buffered();
+    if (r.ok() && tail > 0) r = sendFifoFrame(tail);
+
+    // Flush 编码器
+    if (r.ok()) r = encodeFrame(nullptr);
+
+    // 写入文件尾 (Trailer)
+    if (r.ok()) {
+        int ret = av_write_trailer(fmt_ctx_);
+        if (ret < 0) r = fail(Status::OutputError, ret, "av_write_trailer");
+    }
+    if (!r.ok()) {
+        abort();
+        return r;
+    }
+    closeOutput();
+
+    if (verbose_) {
+        std::clog << "Encoded samples: " << next_pts_
+                  << ", frames: " << frames_sent_ << " (last frame " << (tail > 0 ? tail : framer_.frameSize()) << " samples)"
+                  << std::endl;
+    }
+    return r;
+}
+
+void AudioEncoder::abort() {
+    closeOutput();
+    // 编码器停在未知状态，下次 open() 时完整重建
+    releaseCodec();
+}
+
+AudioEncoder::Result AudioEncoder::sendFifoFrame(int nb_samples) {
+    int ret = av_frame_make_writable(frame_);
+    if (ret < 0) return fail(Status::OutOfMemory, ret, "av_frame_make_writable");
+    frame_->nb_samples = nb_samples;
+    Result r = framer_.read(frame_, nb_samples);
+    if (!r.ok()) return r;
+    frame_->pts = next_pts_;
+    next_pts_ += nb_samples;
+    frames_sent_++;
+    return encodeFrame(frame_);
+}
+
+AudioEncoder::Result AudioEncoder::encodeFrame(AVFrame *frame) {
+    // 1. 发送给编码器
+    int ret = avcodec_send_frame(codec_ctx_, frame);
+    if (ret < 0) return fail(Status::EncodeError, ret, "avcodec_send_frame");
+
+    // 2. 接收并封装数据包
+    while (true) {
+        ret = avcodec_receive_packet(codec_ctx_, pkt_);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) return Result();
+        if (ret < 0) return fail(Status::EncodeError, ret, "avcodec_receive_packet");
+
+        pkt_->stream_index = stream_->index;
+        // 时间基转换 (Codec TB -> Stream TB)
+        av_packet_rescale_ts(pkt_, codec_ctx_->time_base, stream_->time_base);
+
+        // 写入文件 (自动处理 ADTS)
+        ret = av_interleaved_write_frame(fmt_ctx_, pkt_);
+        av_packet_unref(pkt_);
+        if (ret < 0) return fail(Status::OutputError, ret, "av_interleaved_write_frame");
+    }
+}
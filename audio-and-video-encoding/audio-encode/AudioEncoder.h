@@ -0,0 +1,187 @@
+#ifndef AUDIOENCODER_H
+#define AUDIOENCODER_H
+
+#include <string>
+#include <functional>
+#include <cstdio>
+#include <cstdint>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/audio_fifo.h>
+#include <libavutil/samplefmt.h>
+#include <libswresample/swresample.h>
+}
+
+/**
+ * PCM -> AAC (或其他音频编码器) 编码库
+ *
+ * 用法：open() 开始一个任务 -> 多次 encode() 推入 PCM -> finish() 结束并写文件尾，之后可以再 open()。
+ * 所有操作返回 Result，失败不会退出进程，只影响当前任务。
+ *
+ * 同一个实例可以反复使用 (服务进程里每个 worker 持有一个常驻实例)：
+ * 参数不变时重采样器、FIFO、Frame/Packet 和转换缓冲全部复用；
+ * 编码器支持 AV_CODEC_CAP_ENCODER_FLUSH 时连编码器上下文也复用 (avcodec_flush_buffers)，
+ * 否则 (如原生 aac) 编码器 drain 之后无法重启，只重建编码器上下文。
+ */
+class AudioEncoder {
+public:
+    enum class Status {
+        Ok,
+        InvalidArgument, // 参数错误或调用顺序错误 (如未 open 就 encode)
+        CodecError,      // 找不到编码器 / 打开编码器失败
+        OutputError,     // 创建或写入输出失败
+        ResampleError,   // 重采样失败
+        EncodeError,     // 编码失败
+        OutOfMemory
+    };
+
+    struct Result {
+        Status status = Status::Ok;
+        int av_error = 0;    // FFmpeg 错误码 (AVERROR)，没有时为 0
+        std::string message; // 可读的错误描述
+
+        bool ok() const { return status == Status::Ok; }
+    };
+
+    struct Config {
+        std::string codec_name;                  // 空表示默认 AAC 编码器
+        int64_t bit_rate = 128000;
+        int sample_rate = 48000;                 // 输入采样率 (输出采样率与输入相同)
+        int channels = 2;
+        AVSampleFormat input_fmt = AV_SAMPLE_FMT_S16;
+    };
+
+    // encodeStream 每次读取的样本数 (每声道)
+    static const int READ_CHUNK_SAMPLES = 4096;
+
+    // swr 支持的最大声道数，encode() 里按声道拆分 planar 数据用
+    static const int MAX_CHANNELS = 64;
+
+    /**
+     * 输入 PCM -> 重采样为编码器格式 -> FIFO 凑够 frame_size 个样本
+     *
+     * AudioEncoder 和 AacLadder 共用这一段：每凑够一帧调用一次 sink(样本数)，
+     * 由 sink 用 read() 从 FIFO 取走样本再送编码器 (或分发给多个编码器)。
+     */
+    class Framer {
+    public:
+        typedef std::function<Result(int nb_samples)> FrameSink;
+
+        Framer() = default;
+
+        ~Framer() { close(); }
+
+        Framer(const Framer &) = delete;
+
+        Framer &operator=(const Framer &) = delete;
+
+        // 按输入格式和编码器的采样格式 / 声道布局 / frame_size 创建重采样器和 FIFO，已打开时重建
+        Result open(const Config &input, const AVCodecContext *enc);
+
+        // 参数不变时开始新任务：清掉重采样器上次冲刷留下的状态和 FIFO
+        Result restart();
+
+        void close();
+
+        bool isOpen() const { return swr_ctx_ != nullptr; }
+
+        // 推入 samples 个 (每声道) 输入样本，布局同 AudioEncoder::encode
+        Result write(const uint8_t *data, int samples, const FrameSink &sink);
+
+        // 从文件读取 PCM 直到 EOF (或读满 max_bytes) 并逐块 write()
+        // partial_bytes 返回末尾不足一个采样点而丢弃的字节数
+        Result writeStream(FILE *in, int64_t max_bytes, const FrameSink &sink, int *partial_bytes);
+
+        // 冲刷重采样器内部缓存的样本；不足一帧的尾巴留在 FIFO 里，由调用方决定怎么送
+        Result flush(const FrameSink &sink);
+
+        // 从 FIFO 取 nb_samples 个样本写入 frame->data
+        Result read(AVFrame *frame, int nb_samples);
+
+        // FIFO 里剩余的样本数
+        int buffered() const { return fifo_ ? av_audio_fifo_size(fifo_) : 0; }
+
+        int frameSize() const { return frame_size_; }
+
+    private:
+        Result ensureConvCapacity(int nb_samples);
+
+        // in_data 为 nullptr 时冲刷重采样器
+        Result feed(const uint8_t **in_data, int nb_samples, const FrameSink &sink);
+
+        Config input_;
+        SwrContext *swr_ctx_ = nullptr; // 重采样器
+        AVAudioFifo *fifo_ = nullptr; // 编码器格式的样本缓冲，凑整 frame_size 用
+        uint8_t **conv_data_ = nullptr; // swr_convert 的输出缓冲 (编码器格式)
+        int conv_capacity_ = 0;
+        int enc_channels_ = 0;
+        AVSampleFormat enc_fmt_ = AV_SAMPLE_FMT_NONE;
+        int frame_size_ = 0;
+    };
+
+    AudioEncoder();
+
+    ~AudioEncoder();
+
+    // 关闭后不向 stderr 打印配置、统计和警告 (批量/服务模式下多个线程同时编码)
+    void setVerbose(bool verbose) { verbose_ = verbose; }
+
+    // 开始一个编码任务，output 为文件名、任意 avio URL，或 "-" 表示 stdout (ADTS)
+    Result open(const char *output, const Config &config);
+
+    // 推入 samples 个 (每声道) 输入样本：packed 格式为交错数据，planar 格式为各声道依次排列
+    Result encode(const uint8_t *data, int samples);
+
+    // 从文件读取 PCM 直到 EOF (或读满 max_bytes) 并逐块 encode()，不包含 finish()
+    Result encodeStream(FILE *in, int64_t max_bytes = -1);
+
+    // 结束当前任务：冲刷重采样器和不足一帧的尾巴、flush 编码器、写文件尾并关闭输出
+    Result finish();
+
+    // 放弃当前任务 (出错后调用)：关闭输出，下次 open() 时重建编码器
+    void abort();
+
+    // 当前任务已送入编码器的样本数 (每声道)
+    int64_t samplesEncoded() const { return next_pts_; }
+
+    // 是否有正在进行的任务
+    bool isOpen() const { return fmt_ctx_ != nullptr; }
+
+    // 生成一个失败结果，av_error < 0 时把 FFmpeg 错误描述拼进 message
+    static Result fail(Status status, int av_error, const std::string &what);
+
+private:
+    // 按 config 创建 (或复用) 编码器、重采样器和缓冲
+    Result setupCodec(const Config &config);
+
+    Result openCodec(const AVCodec *codec, const Config &config);
+
+    void releaseCodec();
+
+    Result openOutput(const char *output);
+
+    void closeOutput();
+
+    // 从 Framer 的 FIFO 取一帧送编码器
+    Result sendFifoFrame(int nb_samples);
+
+    // frame 为 nullptr 时 flush 编码器
+    Result encodeFrame(AVFrame *frame);
+
+    Config config_;
+    bool verbose_ = true;
+
+    AVFormatContext *fmt_ctx_ = nullptr; // 封装上下文 (每个任务一个)
+    AVStream *stream_ = nullptr;
+    AVCodecContext *codec_ctx_ = nullptr; // 编码器上下文
+    Framer framer_; // 重采样 + FIFO 凑帧
+    Framer::FrameSink send_frame_; // 绑定 sendFifoFrame，避免每次 encode() 构造 std::function
+    AVFrame *frame_ = nullptr;
+    AVPacket *pkt_ = nullptr;
+    int64_t next_pts_ = 0;
+    int64_t frames_sent_ = 0;
+};
+
+#endif // AUDIOENCODER_H
@@ -2,6 +2,11 @@
  * @projectName   PCM to AAC Encoder (FFmpeg 6.1 Optimized C++)
  * @brief         将 PCM 数据编码为 AAC (自动处理 ADTS 封装与重采样)
  * @optimization  使用 libswresample 替代手动格式转换；使用 libavformat 替代手动 ADTS 头拼接。
+ *                流式处理：PCM 分块读入 -> 重采样 -> AVAudioFifo -> 每次取恰好 frame_size 个样本送编码器，
+ *                内存占用与输入长度无关；输入/输出可以是 "-" (stdin/stdout)，方便放进 shell 管道。
+ *                --batch：按清单批量编码，工作窃取线程池并行跑多个 AudioEncoder，单个文件失败不影响整批。
+ *                --ladder：一次读取和重采样，多个码率的编码器各自一个线程同时输出 (AacLadder.h)。
+ *                编码器本身见 AudioEncoder.h (返回状态码、可复用的库)，这里只负责输入解析和命令行。
  */
 
 #include <iostream>
@@ -9,282 +14,489 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <atomic>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+#include "AudioEncoder.h"
+#include "AacLadder.h"
 
 extern "C" {
-#include <libavcodec/avcodec.h>
-#include <libavformat/avformat.h>
-#include <libavutil/channel_layout.h>
-#include <libavutil/common.h>
-#include <libavutil/frame.h>
 #include <libavutil/samplefmt.h>
-#include <libavutil/opt.h>
-#include <libswresample/swresample.h>
 }
 
-// 错误检查辅助函数
-static void check_ret(int ret, const std::string& func_name)
+// 输入 PCM 的参数；WAV 文件从头部解析，裸 PCM 用命令行给的默认值
+struct PcmFormat
 {
-    if (ret < 0)
-    {
-        char err_buf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, err_buf, AV_ERROR_MAX_STRING_SIZE);
-        std::cerr << "[Error] " << func_name << ": " << err_buf << " (Error code: " << ret << ")" << std::endl;
-        exit(1);
-    }
+    int sample_rate = 48000;
+    int channels = 2;
+    AVSampleFormat fmt = AV_SAMPLE_FMT_S16;
+    int64_t data_bytes = -1; // WAV data 块长度，-1 表示读到文件尾
+};
+
+static uint32_t read_le32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
 }
 
-class AudioEncoder
+static uint16_t read_le16(const uint8_t* p)
 {
-public:
-    AudioEncoder() = default;
-    ~AudioEncoder() { cleanup(); }
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
 
-    void init(const char* output_file, const char* codec_name,
-              const int input_rate, const int input_channels, const AVSampleFormat input_fmt)
+// 解析 WAV (RIFF) 头，成功时文件指针停在 data 块的起始处
+static bool read_wav_header(FILE* f, PcmFormat& pcm, std::string& err)
+{
+    uint8_t riff[12];
+    if (fread(riff, 1, sizeof(riff), f) != sizeof(riff) || memcmp(riff, "RIFF", 4) || memcmp(riff + 8, "WAVE", 4))
     {
-        // 1. 初始化封装上下文 (Format Context) - 负责写入文件和 ADTS 头
-        /**
-         * 创建一个可用于编码输出的封装上下文，并自动匹配合适的输出格式
-         * oformat: 封装器上下文
-         * format_name: 封装器名称
-         * filename: 文件名
-         * 会根据filename自动识别格式
-         */
-        int ret = avformat_alloc_output_context2(&fmt_ctx, nullptr, nullptr, output_file);
-        if (!fmt_ctx)
+        err = "not a RIFF/WAVE file";
+        return false;
+    }
+
+    bool have_fmt = false;
+    uint8_t chunk[8];
+    while (fread(chunk, 1, sizeof(chunk), f) == sizeof(chunk))
+    {
+        const uint32_t size = read_le32(chunk + 4);
+        if (memcmp(chunk, "fmt ", 4) == 0)
         {
-            std::cerr << "Could not create output context for " << output_file << std::endl;
-            exit(1);
+            uint8_t fmt[40] = {0};
+            const uint32_t want = size < sizeof(fmt) ? size : sizeof(fmt);
+            if (size < 16 || fread(fmt, 1, want, f) != want)
+            {
+                err = "truncated fmt chunk";
+                return false;
+            }
+            int tag = read_le16(fmt);
+            const int bits = read_le16(fmt + 14);
+            // WAVE_FORMAT_EXTENSIBLE: 实际格式在 SubFormat GUID 的前两个字节
+            if (tag == 0xFFFE && want >= 26) tag = read_le16(fmt + 24);
+
+            pcm.channels = read_le16(fmt + 2);
+            pcm.sample_rate = static_cast<int>(read_le32(fmt + 4));
+            if (tag == 1 && bits == 8) pcm.fmt = AV_SAMPLE_FMT_U8;
+            else if (tag == 1 && bits == 16) pcm.fmt = AV_SAMPLE_FMT_S16;
+            else if (tag == 1 && bits == 32) pcm.fmt = AV_SAMPLE_FMT_S32;
+            else if (tag == 3 && bits == 32) pcm.fmt = AV_SAMPLE_FMT_FLT;
+            else if (tag == 3 && bits == 64) pcm.fmt = AV_SAMPLE_FMT_DBL;
+            else
+            {
+                err = "unsupported WAV format (tag " + std::to_string(tag) + ", " + std::to_string(bits) + " bit)";
+                return false;
+            }
+            fseek(f, static_cast<long>(size - want + (size & 1)), SEEK_CUR);
+            have_fmt = true;
         }
-
-        // 2. 查找编码器
-        const AVCodec* codec = nullptr; // 编解码器
-        if (codec_name)
+        else if (memcmp(chunk, "data", 4) == 0)
         {
-            codec = avcodec_find_encoder_by_name(codec_name);
+            if (!have_fmt)
+            {
+                err = "data chunk before fmt chunk";
+                return false;
+            }
+            pcm.data_bytes = size;
+            return true;
         }
         else
         {
-            codec = avcodec_find_encoder(AV_CODEC_ID_AAC);
+            // LIST / fact 等块跳过 (块长度为奇数时有 1 字节填充)
+            fseek(f, static_cast<long>(size + (size & 1)), SEEK_CUR);
         }
+    }
+    err = "no data chunk";
+    return false;
+}
 
-        if (!codec)
+// 打开输入："-" 为 stdin (只支持裸 PCM)，文件以 RIFF 开头时按 WAV 解析头部
+static FILE* open_input(const char* path, PcmFormat& pcm, std::string& err)
+{
+    if (strcmp(path, "-") == 0)
+    {
+        if (pcm.sample_rate <= 0 || pcm.channels <= 0)
         {
-            std::cerr << "Codec not found: " << (codec_name ? codec_name : "default AAC") << std::endl;
-            exit(1);
+            err = "invalid sample rate or channel count";
+            return nullptr;
         }
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY); // Windows 下 stdin 默认是文本模式，会改写 0x0D 0x0A
+#endif
+        return stdin;
+    }
 
-        // 3. 分配并配置编码器上下文
-        /**
-         * 为编解码器分配并配置编码器上下文，可以关联编码器
-         * 得到编解码器上下文
-         */
-        codec_ctx = avcodec_alloc_context3(codec);
-        if (!codec_ctx) exit(1);
-
-        // 设置编码参数
-        codec_ctx->bit_rate = 128000; // 128 kbps
-        codec_ctx->sample_rate = input_rate; // 简单起见，输出采样率=输入采样率
-        // 自动选择编码器支持的第一个采样格式 (AAC通常是 FLTP, libfdk_aac可能是 S16)
-        codec_ctx->sample_fmt = codec->sample_fmts ? codec->sample_fmts[0] : AV_SAMPLE_FMT_FLTP;
-
-        // FFmpeg 6.1: 设置通道布局
-        av_channel_layout_default(&codec_ctx->ch_layout, input_channels);
-
-        // 打开编码器:将 AVCodecContext 与指定的 AVCodec 关联
-        check_ret(avcodec_open2(codec_ctx, codec, nullptr), "avcodec_open2");
-
-        // 4. 添加流到封装器
-        /**
-         * 为输出文件添加流
-         */
-        stream = avformat_new_stream(fmt_ctx, nullptr);
-        stream->id = fmt_ctx->nb_streams - 1;
-        avcodec_parameters_from_context(stream->codecpar, codec_ctx);
-
-        // 5. 打开输出文件
-        if (!(fmt_ctx->oformat->flags & AVFMT_NOFILE))
-        {
-            check_ret(avio_open(&fmt_ctx->pb, output_file, AVIO_FLAG_WRITE), "avio_open");
-        }
+    FILE* f = fopen(path, "rb");
+    if (!f)
+    {
+        err = std::string("cannot open input file: ") + path;
+        return nullptr;
+    }
 
-        // 写入文件头
-        check_ret(avformat_write_header(fmt_ctx, nullptr), "avformat_write_header");
-
-        // 6. 初始化重采样器 (SwrContext)
-        // 无论输入是什么格式(S16/F32)，都转为编码器需要的格式
-        AVChannelLayout in_ch_layout;
-        av_channel_layout_default(&in_ch_layout, input_channels);
-
-        check_ret(swr_alloc_set_opts2(&swr_ctx,
-                                      &codec_ctx->ch_layout, codec_ctx->sample_fmt, codec_ctx->sample_rate,
-                                      &in_ch_layout, input_fmt, input_rate,
-                                      0, nullptr), "swr_alloc_set_opts2");
-        swr_init(swr_ctx);
-
-        // 7. 分配 Frame 和 Packet
-        pkt = av_packet_alloc();
-        frame = av_frame_alloc();
-        frame->nb_samples = codec_ctx->frame_size;
-        frame->format = codec_ctx->sample_fmt;
-        av_channel_layout_copy(&frame->ch_layout, &codec_ctx->ch_layout);
-        check_ret(av_frame_get_buffer(frame, 0), "av_frame_get_buffer");
-
-        // 打印调试信息
-        std::cout << "---------------- Config ----------------" << std::endl;
-        std::cout << "Encoder: " << codec->name << std::endl;
-        std::cout << "Bitrate: " << codec_ctx->bit_rate << std::endl;
-        std::cout << "Input Fmt: " << av_get_sample_fmt_name(input_fmt) << std::endl;
-        std::cout << "Output Fmt: " << av_get_sample_fmt_name(codec_ctx->sample_fmt) << std::endl;
-        std::cout << "Frame Size: " << codec_ctx->frame_size << std::endl;
-        std::cout << "----------------------------------------" << std::endl;
+    char magic[4] = {0};
+    const bool is_wav = fread(magic, 1, 4, f) == 4 && memcmp(magic, "RIFF", 4) == 0;
+    fseek(f, 0, SEEK_SET);
+    if (is_wav && !read_wav_header(f, pcm, err))
+    {
+        fclose(f);
+        return nullptr;
+    }
+    // WAV 头里的值可能是 0，后面要拿采样率做除数
+    if (pcm.sample_rate <= 0 || pcm.channels <= 0)
+    {
+        err = "invalid sample rate or channel count";
+        fclose(f);
+        return nullptr;
     }
+    return f;
+}
+
+// ---------------- 批量编码 ----------------
+
+struct BatchJob
+{
+    std::string input;
+    std::string output;
+    bool ok = false;
+    std::string error;
+    double audio_seconds = 0;
+    double encode_seconds = 0;
+};
+
+// 清单每行: <input> [output]，空白分隔；省略 output 时把输入扩展名换成 .aac；空行和 # 开头的行忽略
+static bool load_manifest(const char* path, std::vector<BatchJob>& jobs)
+{
+    std::ifstream in(path);
+    if (!in) return false;
 
-    // 核心处理函数
-    void process(const char* input_file, int input_channels, AVSampleFormat input_fmt)
+    std::string line;
+    while (std::getline(in, line))
     {
-        std::ifstream infile(input_file, std::ios::binary);
-        if (!infile)
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+
+        std::istringstream fields(line);
+        BatchJob job;
+        fields >> job.input >> job.output;
+        if (job.output.empty())
         {
-            std::cerr << "Cannot open input file: " << input_file << std::endl;
-            return;
+            const size_t dot = job.input.find_last_of('.');
+            const size_t slash = job.input.find_last_of("/\\");
+            job.output = (dot != std::string::npos && (slash == std::string::npos || dot > slash)
+                              ? job.input.substr(0, dot)
+                              : job.input) + ".aac";
         }
+        jobs.push_back(job);
+    }
+    return true;
+}
 
-        // 计算输入缓冲大小
-        // 我们每次需要凑够 frame_size 个样本给编码器
-        // 比如 AAC 一帧 1024 样本。不管输入是 S16 还是 F32，Swr 会帮我们凑。
-        // 这里简单起见，我们按照编码器需要的样本数来读取输入数据进行 1:1 转换尝试
-        const int input_bytes_per_sample = av_get_bytes_per_sample(input_fmt);
-        const int read_size = codec_ctx->frame_size * input_channels * input_bytes_per_sample;
-        std::vector<uint8_t> input_buf(read_size);
-
-        int64_t pts = 0;
+// 每个工作线程一个任务队列：先从自己的队头取，空了就从别的线程队尾偷
+struct WorkQueue
+{
+    std::deque<size_t> jobs;
+    std::mutex mutex;
+};
 
-        while (infile.read(reinterpret_cast<char*>(input_buf.data()), read_size))
+static bool next_job(std::vector<std::unique_ptr<WorkQueue>>& queues, size_t self, size_t& job)
+{
+    {
+        std::lock_guard<std::mutex> lock(queues[self]->mutex);
+        if (!queues[self]->jobs.empty())
         {
-            encode_frame(input_buf.data(), codec_ctx->frame_size, pts);
-            pts += codec_ctx->frame_size;
+            job = queues[self]->jobs.front();
+            queues[self]->jobs.pop_front();
+            return true;
         }
+    }
+    for (size_t i = 1; i < queues.size(); ++i)
+    {
+        WorkQueue& victim = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            job = victim.jobs.back();
+            victim.jobs.pop_back();
+            return true;
+        }
+    }
+    return false; // 任务不会再增加，所有队列都空了就结束
+}
 
-        // 处理最后剩余不足一帧的数据 (可选，通常直接 Flush 即可，音频对齐要求不高)
+static AudioEncoder::Config make_config(const char* codec_name, const PcmFormat& pcm)
+{
+    AudioEncoder::Config config;
+    config.codec_name = codec_name ? codec_name : "";
+    config.sample_rate = pcm.sample_rate;
+    config.channels = pcm.channels;
+    config.input_fmt = pcm.fmt;
+    return config;
+}
 
-        // Flush 编码器
-        encode_frame(nullptr, 0, pts);
+// 编码一个文件：open -> encodeStream -> finish，任一步失败编码器都已自行 abort，可以直接接下一个任务
+static AudioEncoder::Result encode_file(AudioEncoder& encoder, FILE* infile, const char* output,
+                                        const char* codec_name, const PcmFormat& pcm)
+{
+    AudioEncoder::Result r = encoder.open(output, make_config(codec_name, pcm));
+    if (r.ok()) r = encoder.encodeStream(infile, pcm.data_bytes);
+    if (r.ok()) r = encoder.finish();
+    return r;
+}
 
-        // 写入文件尾 (Trailer)
-        av_write_trailer(fmt_ctx);
-    }
+// encoder 由工作线程持有，跨任务复用
+static void encode_job(AudioEncoder& encoder, BatchJob& job, const char* codec_name, const PcmFormat& default_pcm)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    PcmFormat pcm = default_pcm;
+    FILE* infile = open_input(job.input.c_str(), pcm, job.error);
+    if (!infile) return;
 
-private:
-    AVFormatContext* fmt_ctx = nullptr; // 封装上下文
-    AVCodecContext* codec_ctx = nullptr; // 编码器上下文
-    AVStream* stream = nullptr; // 流
-    SwrContext* swr_ctx = nullptr; // 重采样器
-    AVFrame* frame = nullptr; // 是 FFmpeg 中存储原始音视频数据的核心结构体。
-    AVPacket* pkt = nullptr; // Packet
+    AudioEncoder::Result r = encode_file(encoder, infile, job.output.c_str(), codec_name, pcm);
+    if (infile != stdin) fclose(infile);
 
-    void encode_frame(const uint8_t* data, int nb_samples, int64_t pts)
+    job.ok = r.ok();
+    if (job.ok) job.audio_seconds = static_cast<double>(encoder.samplesEncoded()) / pcm.sample_rate;
+    else job.error = r.message;
+    job.encode_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static int run_batch(const char* manifest, int num_threads, const char* codec_name, const PcmFormat& default_pcm)
+{
+    std::vector<BatchJob> jobs;
+    if (!load_manifest(manifest, jobs))
+    {
+        std::cerr << "Cannot open manifest: " << manifest << std::endl;
+        return 1;
+    }
+    if (jobs.empty())
     {
-        int ret;
+        std::cerr << "Manifest is empty: " << manifest << std::endl;
+        return 1;
+    }
 
-        // 1. 重采样 / 格式转换 (即使格式相同，swr_convert 也是最安全的拷贝方式)
-        if (data)
+    if (num_threads <= 0) num_threads = static_cast<int>(std::thread::hardware_concurrency());
+    if (num_threads <= 0) num_threads = 1;
+    if (num_threads > static_cast<int>(jobs.size())) num_threads = static_cast<int>(jobs.size());
+
+    // 按清单顺序轮流分给各线程
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    for (int i = 0; i < num_threads; ++i) queues.emplace_back(new WorkQueue());
+    for (size_t i = 0; i < jobs.size(); ++i) queues[i % num_threads]->jobs.push_back(i);
+
+    std::cout << "Batch: " << jobs.size() << " files, " << num_threads << " threads" << std::endl;
+
+    std::mutex print_mutex;
+    std::atomic<int> done(0);
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < num_threads; ++t)
+    {
+        workers.emplace_back([&, t]()
         {
-            // 确保 Frame 可写
-            ret = av_frame_make_writable(frame);
-            const uint8_t* in_data[1] = {data};
-
-            // 将 PCM 数据转入 Frame
-            // 注意：swr_convert 第三个参数是输出的样本数上限，第四个是输入数据，第五个是输入样本数
-            const int dst_nb_samples = swr_convert(swr_ctx,
-                                                   frame->data, frame->nb_samples,
-                                                   (const uint8_t**)in_data, nb_samples);
-            if (dst_nb_samples < 0)
+            AudioEncoder encoder; // 每个线程一个常驻编码器
+            encoder.setVerbose(false);
+
+            size_t idx;
+            while (next_job(queues, static_cast<size_t>(t), idx))
             {
-                std::cerr << "Error during resampling" << std::endl;
-                return;
+                BatchJob& job = jobs[idx];
+                encode_job(encoder, job, codec_name, default_pcm);
+
+                std::lock_guard<std::mutex> lock(print_mutex);
+                char line[64];
+                snprintf(line, sizeof(line), "[%d/%zu] %s", ++done, jobs.size(), job.ok ? "OK  " : "FAIL");
+                std::cout << line << " " << job.input;
+                if (job.ok)
+                {
+                    snprintf(line, sizeof(line), "  %.1fs audio in %.2fs (%.1fx)", job.audio_seconds,
+                             job.encode_seconds, job.encode_seconds > 0 ? job.audio_seconds / job.encode_seconds : 0.0);
+                    std::cout << line;
+                }
+                else
+                {
+                    std::cout << "  " << job.error;
+                }
+                std::cout << std::endl;
             }
+        });
+    }
+    for (auto& w : workers) w.join();
 
-            // 设置 PTS 和 实际样本数
-            frame->pts = pts;
-            // 实际上对于 AAC，每一帧必须填满 1024，除非是最后一帧 flush
-            // swrContext 内部有缓存，这里简化处理，假设每次读取都填满了
-        }
-
-        // 2. 发送给编码器
-        // data 为 nullptr 时，send_frame(nullptr) 会触发 flush
-        ret = avcodec_send_frame(codec_ctx, data ? frame : nullptr);
-        if (ret < 0) check_ret(ret, "avcodec_send_frame");
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    // 只有成功的任务有 audio_seconds，失败任务编到一半的音频不计入总量和实时倍率
+    double audio_total = 0, encode_total = 0;
+    int failed = 0;
+    for (const auto& job : jobs)
+    {
+        audio_total += job.audio_seconds;
+        encode_total += job.encode_seconds;
+        if (!job.ok) failed++;
+    }
 
-        // 3. 接收并封装数据包
-        while (ret >= 0)
+    printf("\n---------------- Batch Summary ----------------\n");
+    printf("Files:          %zu ok, %d failed\n", jobs.size() - failed, failed);
+    printf("Audio:          %.1f s\n", audio_total);
+    printf("Wall time:      %.2f s (%d threads, sum of per-file time %.2f s)\n", wall, num_threads, encode_total);
+    printf("Realtime factor %.1fx aggregate\n", wall > 0 ? audio_total / wall : 0.0);
+    if (failed > 0)
+    {
+        printf("Failed:\n");
+        for (const auto& job : jobs)
         {
-            ret = avcodec_receive_packet(codec_ctx, pkt);
-            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
-                return;
-            else if (ret < 0) check_ret(ret, "avcodec_receive_packet");
+            if (!job.ok) printf("  %s: %s\n", job.input.c_str(), job.error.c_str());
+        }
+    }
+    return failed > 0 ? 2 : 0;
+}
 
-            // 设置流索引
-            pkt->stream_index = stream->index;
+static AVSampleFormat parse_input_fmt(const std::string& fmt_str, AVSampleFormat def)
+{
+    if (fmt_str == "s16") return AV_SAMPLE_FMT_S16;
+    if (fmt_str == "f32") return AV_SAMPLE_FMT_FLT; // F32LE Packed
+    if (fmt_str == "fltp") return AV_SAMPLE_FMT_FLTP;
+    return def;
+}
 
-            // 时间基转换 (Codec TB -> Stream TB)
-            av_packet_rescale_ts(pkt, codec_ctx->time_base, stream->time_base);
+// ---------------- 多码率阶梯 ----------------
 
-            // 写入文件 (自动处理 ADTS)
-            ret = av_interleaved_write_frame(fmt_ctx, pkt);
+// "64k" / "128000" -> 比特率
+static int64_t parse_bitrate(const std::string& s)
+{
+    char* end = nullptr;
+    double v = strtod(s.c_str(), &end);
+    if (end && (*end == 'k' || *end == 'K')) v *= 1000;
+    else if (end && (*end == 'm' || *end == 'M')) v *= 1000000;
+    return static_cast<int64_t>(v);
+}
 
-            av_packet_unref(pkt);
+// out.aac + 64000 -> out_64k.aac
+static std::string rung_output(const std::string& base, int64_t bit_rate)
+{
+    const std::string tag = "_" + std::to_string(bit_rate / 1000) + "k";
+    const size_t dot = base.find_last_of('.');
+    const size_t slash = base.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return base + tag + ".aac";
+    return base.substr(0, dot) + tag + base.substr(dot);
+}
+
+static int run_ladder(const std::string& bitrates, const char* in_file, const char* out_base,
+                      const char* codec_name, PcmFormat pcm)
+{
+    std::vector<AacLadder::Rung> rungs;
+    std::istringstream list(bitrates);
+    std::string item;
+    while (std::getline(list, item, ','))
+    {
+        const int64_t bit_rate = parse_bitrate(item);
+        if (bit_rate <= 0)
+        {
+            std::cerr << "Invalid bitrate: " << item << std::endl;
+            return 1;
         }
+        rungs.push_back({bit_rate, rung_output(out_base, bit_rate)});
     }
 
-    void cleanup()
+    std::string err;
+    FILE* infile = open_input(in_file, pcm, err);
+    if (!infile)
     {
-        if (fmt_ctx && !(fmt_ctx->oformat->flags & AVFMT_NOFILE))
-            avio_closep(&fmt_ctx->pb);
+        std::cerr << "[Error] " << err << std::endl;
+        return 1;
+    }
 
-        if (fmt_ctx) avformat_free_context(fmt_ctx);
-        if (codec_ctx) avcodec_free_context(&codec_ctx);
-        if (frame) av_frame_free(&frame);
-        if (pkt) av_packet_free(&pkt);
-        if (swr_ctx) swr_free(&swr_ctx);
+    const auto start = std::chrono::steady_clock::now();
+    AacLadder ladder;
+    int ret = ladder.open(rungs, make_config(codec_name, pcm));
+    if (ret >= 0) ret = ladder.encodeStream(infile, pcm.data_bytes);
+    if (ret < 0) std::cerr << "[Error] " << ladder.error() << std::endl;
+    const int ok = ladder.finish();
+    if (infile != stdin) fclose(infile);
 
-        std::cout << "Resources cleaned up." << std::endl;
-    }
-};
+    ladder.printStats(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    return (ret < 0 || ok < static_cast<int>(rungs.size())) ? 1 : 0;
+}
 
 int main(int argc, char** argv)
 {
     if (argc < 3)
     {
-        std::cout << "Usage: " << argv[0] << " <input_pcm> <output_aac> [codec_name] [fmt:s16/f32]" << std::endl;
+        std::cout << "Usage: " << argv[0] << " <input_pcm|wav|-> <output_aac|-> [codec_name] [fmt:s16/f32]" << std::endl;
+        std::cout << "       " << argv[0] << " --batch <manifest> [-j threads] [--codec name] [--fmt s16/f32]" << std::endl;
+        std::cout << "       " << argv[0] << " --ladder 64k,128k,256k <input_pcm|wav|-> <output_aac> [codec_name] [fmt:s16/f32]" << std::endl;
         std::cout << "Example: " << argv[0] << " input.pcm output.aac libfdk_aac s16" << std::endl;
+        std::cout << "Pipe:    ffmpeg -i in.wav -f s16le -ac 2 -ar 48000 - | " << argv[0] << " - - > out.aac" << std::endl;
+        std::cout << "Manifest lines: <input> [output]; WAV inputs use the rate/channels/format from their header," << std::endl;
+        std::cout << "raw PCM inputs use 48000 Hz stereo and --fmt (default s16)." << std::endl;
+        std::cout << "Ladder outputs are named after the bitrate, e.g. out.aac -> out_64k.aac, out_128k.aac." << std::endl;
         return 1;
     }
 
+    // 默认输入参数 (根据你的需求修改)，WAV 文件以文件头为准
+    PcmFormat pcm;
+    pcm.sample_rate = 48000;
+    pcm.channels = 2;
+    pcm.fmt = AV_SAMPLE_FMT_S16; // 交错格式（适合播放）;位深16;
+
+    if (std::string(argv[1]) == "--batch")
+    {
+        const char* manifest = argv[2];
+        const char* codec_name = nullptr;
+        int threads = 0; // 0 = CPU 核数
+        for (int i = 3; i + 1 < argc; i += 2)
+        {
+            std::string opt = argv[i];
+            if (opt == "-j") threads = atoi(argv[i + 1]);
+            else if (opt == "--codec") codec_name = argv[i + 1];
+            else if (opt == "--fmt") pcm.fmt = parse_input_fmt(argv[i + 1], pcm.fmt);
+            else std::cerr << "Unknown option: " << opt << std::endl;
+        }
+        return run_batch(manifest, threads, codec_name, pcm);
+    }
+
+    if (std::string(argv[1]) == "--ladder")
+    {
+        if (argc < 5)
+        {
+            std::cerr << "Usage: " << argv[0] << " --ladder <bitrates> <input> <output_aac> [codec_name] [fmt]" << std::endl;
+            return 1;
+        }
+        if (argc > 6) pcm.fmt = parse_input_fmt(argv[6], pcm.fmt);
+        return run_ladder(argv[2], argv[3], argv[4], argc > 5 ? argv[5] : nullptr, pcm);
+    }
+
     const char* in_file = argv[1];
     const char* out_file = argv[2];
     const char* codec_name = (argc > 3) ? argv[3] : nullptr; // 默认 nullptr (auto select)
 
-    // 默认输入参数 (根据你的需求修改)
-    const int sample_rate = 48000;
-    const int channels = 2;
-    AVSampleFormat input_fmt = AV_SAMPLE_FMT_S16; // 交错格式（适合播放）;位深16;
-
     // 简单的命令行参数解析来切换输入格式
-    if (argc > 4)
+    if (argc > 4) pcm.fmt = parse_input_fmt(argv[4], pcm.fmt);
+
+    std::string err;
+    FILE* infile = open_input(in_file, pcm, err);
+    if (!infile)
     {
-        std::string fmt_str = argv[4];
-        if (fmt_str == "f32") input_fmt = AV_SAMPLE_FMT_FLT; // F32LE Packed
-        if (fmt_str == "fltp") input_fmt = AV_SAMPLE_FMT_FLTP;
+        std::cerr << "[Error] " << err << std::endl;
+        return 1;
     }
 
     AudioEncoder encoder;
+    AudioEncoder::Result r = encode_file(encoder, infile, out_file, codec_name, pcm);
+    if (infile != stdin) fclose(infile);
 
-    // 初始化
-    encoder.init(out_file, codec_name, sample_rate, channels, input_fmt);
-
-    // 执行编码
-    encoder.process(in_file, channels, input_fmt);
-
+    if (!r.ok())
+    {
+        std::cerr << "[Error] " << r.message << std::endl;
+        return 1;
+    }
     return 0;
 }
@@ -0,0 +1,191 @@
+#ifndef ENCODERPROFILE_H
+#define ENCODERPROFILE_H
+
+/**
+ * 视频编码参数模板 (encode_mp4 / encode_video 共用)
+ *
+ * 一个 profile 用一行 "key=value,key=value" 描述，例如：
+ *   name=live,rc=cbr,bitrate=2000000,preset=veryfast,tune=zerolatency,gop=60,bf=0,lookahead=0
+ *
+ * 支持的 key:
+ *   name       profile 名称，用于 sweep 报表
+ *   rc         码控模式: crf / abr / cbr
+ *   bitrate    目标码率 (bps)，abr/cbr 使用
+ *   crf        质量因子 (0-51)，crf 模式使用
+ *   preset     x264 preset: ultrafast ... veryslow
+ *   tune       x264 tune: zerolatency / film / ...，空表示不设置
+ *   gop        关键帧间隔
+ *   bf         最大 B 帧数，-1 表示用编码器默认
+ *   lookahead  x264 rc-lookahead 帧数，-1 表示用编码器默认
+ *   threads    编码线程数，0 自动，-1 表示用编码器默认
+ *
+ * 命令行里也可以用 "--key value" 逐项覆盖，或者用 --profiles <file> 一行一个 profile。
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/opt.h>
+}
+
+enum class RateControl {
+    CRF, // 恒定质量
+    ABR, // 平均码率
+    CBR  // 恒定码率 (VBV 约束 + nal-hrd)
+};
+
+struct EncoderProfile {
+    std::string name = "default";
+    RateControl rc = RateControl::ABR;
+    int64_t bitrate = 2000000;
+    int crf = 23;
+    std::string preset = "medium";
+    std::string tune;
+    int gop = 12;
+    int b_frames = -1;
+    int lookahead = -1;
+    int threads = -1;
+};
+
+inline const char *rc_name(RateControl rc) {
+    switch (rc) {
+        case RateControl::CRF: return "crf";
+        case RateControl::CBR: return "cbr";
+        default: return "abr";
+    }
+}
+
+// 解析单个 key=value，成功返回 true
+inline bool set_profile_option(EncoderProfile &p, const std::string &key, const std::string &value) {
+    char *end = nullptr;
+    long long num = strtoll(value.c_str(), &end, 10);
+    bool is_num = !value.empty() && *end == '\0';
+
+    if (key == "name") {
+        p.name = value;
+    } else if (key == "rc") {
+        if (value == "crf") p.rc = RateControl::CRF;
+        else if (value == "abr") p.rc = RateControl::ABR;
+        else if (value == "cbr") p.rc = RateControl::CBR;
+        else return false;
+    } else if (key == "preset") {
+        p.preset = value;
+    } else if (key == "tune") {
+        p.tune = value;
+    } else if (!is_num) {
+        return false;
+    } else if (key == "bitrate") {
+        p.bitrate = num;
+    } else if (key == "crf") {
+        p.crf = static_cast<int>(num);
+    } else if (key == "gop") {
+        p.gop = static_cast<int>(num);
+    } else if (key == "bf") {
+        p.b_frames = static_cast<int>(num);
+    } else if (key == "lookahead") {
+        p.lookahead = static_cast<int>(num);
+    } else if (key == "threads") {
+        p.threads = static_cast<int>(num);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// 解析 "key=value,key=value"，未出现的 key 保持 p 原值 (通常先拷贝一份默认 profile 再解析)
+inline bool parse_profile(const std::string &spec, EncoderProfile &p) {
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        size_t eq = item.find('=');
+        if (eq == std::string::npos || !set_profile_option(p, item.substr(0, eq), item.substr(eq + 1))) {
+            fprintf(stderr, "无效的 profile 参数: '%s'\n", item.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// 从文件加载多个 profile，一行一个，# 开头为注释
+inline bool load_profiles(const std::string &path, const EncoderProfile &base, std::vector<EncoderProfile> &out) {
+    std::ifstream file(path);
+    if (!file) {
+        fprintf(stderr, "无法打开 profile 文件: %s\n", path.c_str());
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        EncoderProfile p = base;
+        if (!parse_profile(line, p)) return false;
+        out.push_back(p);
+    }
+    return true;
+}
+
+// 内置的 sweep 列表：从快到慢覆盖常用 preset，外加一个直播 CBR 配置
+inline std::vector<EncoderProfile> builtin_sweep_profiles(const EncoderProfile &base) {
+    const char *specs[] = {
+        "name=ultrafast_abr,rc=abr,preset=ultrafast",
+        "name=veryfast_crf23,rc=crf,crf=23,preset=veryfast",
+        "name=fast_crf23,rc=crf,crf=23,preset=fast",
+        "name=medium_crf23,rc=crf,crf=23,preset=medium",
+        "name=slow_crf23,rc=crf,crf=23,preset=slow",
+        "name=live_cbr,rc=cbr,preset=veryfast,tune=zerolatency,bf=0,lookahead=0",
+    };
+    std::vector<EncoderProfile> list;
+    for (const char *spec : specs) {
+        EncoderProfile p = base;
+        parse_profile(spec, p);
+        list.push_back(p);
+    }
+    return list;
+}
+
+inline std::string describe_profile(const EncoderProfile &p) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s: rc=%s bitrate=%lld crf=%d preset=%s tune=%s gop=%d bf=%d lookahead=%d threads=%d",
+             p.name.c_str(), rc_name(p.rc), static_cast<long long>(p.bitrate), p.crf, p.preset.c_str(),
+             p.tune.empty() ? "-" : p.tune.c_str(), p.gop, p.b_frames, p.lookahead, p.threads);
+    return buf;
+}
+
+// 把 profile 应用到编码器上下文，必须在 avcodec_open2 之前调用
+inline void apply_profile(AVCodecContext *c, const EncoderProfile &p) {
+    c->gop_size = p.gop;
+    if (p.b_frames >= 0) c->max_b_frames = p.b_frames;
+    if (p.threads >= 0) c->thread_count = p.threads;
+
+    switch (p.rc) {
+        case RateControl::CRF:
+            c->bit_rate = 0;
+            av_opt_set_int(c->priv_data, "crf", p.crf, 0);
+            break;
+        case RateControl::ABR:
+            c->bit_rate = p.bitrate;
+            break;
+        case RateControl::CBR:
+            // 码率上下限相同 + 1 秒 VBV 缓冲，x264 再打开 nal-hrd=cbr 填充
+            c->bit_rate = p.bitrate;
+            c->rc_min_rate = p.bitrate;
+            c->rc_max_rate = p.bitrate;
+            c->rc_buffer_size = static_cast<int>(p.bitrate);
+            av_opt_set(c->priv_data, "nal-hrd", "cbr", 0);
+            break;
+    }
+
+    // 以下是 libx264 私有选项，其他编码器没有这些选项时 av_opt_set 会返回错误，直接忽略
+    av_opt_set(c->priv_data, "preset", p.preset.c_str(), 0);
+    if (!p.tune.empty()) av_opt_set(c->priv_data, "tune", p.tune.c_str(), 0);
+    if (p.lookahead >= 0) av_opt_set_int(c->priv_data, "rc-lookahead", p.lookahead, 0);
+}
+
+#endif // ENCODERPROFILE_H
@@ -0,0 +1,105 @@
+#ifndef GOPREPORT_H
+#define GOPREPORT_H
+
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <cstdint>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+}
+
+/**
+ * GOP 报告：关键帧位置、每个 GOP 的长度和大小、各帧类型的比特数
+ *
+ * 帧类型取自 libx264 输出包的 AV_PKT_DATA_QUALITY_STATS 附加数据 (第 5 字节是 pict_type)。
+ */
+class GopReport {
+public:
+    // 预留 n 帧的记录空间，编码循环里 add() 不再分配内存
+    void reserve(size_t n) { frames_.reserve(n); }
+
+    // 记录一个输出包，frame_idx 为显示顺序的帧号 (pts)
+    void add(const AVPacket *pkt) {
+        FrameInfo f;
+        f.idx = pkt->pts;
+        f.size = pkt->size;
+        f.key = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
+        f.type = f.key ? 'I' : '?';
+
+        size_t sd_size = 0;
+        const uint8_t *sd = av_packet_get_side_data(pkt, AV_PKT_DATA_QUALITY_STATS, &sd_size);
+        if (sd && sd_size >= 5) {
+            f.type = av_get_picture_type_char(static_cast<AVPictureType>(sd[4]));
+        }
+        frames_.push_back(f);
+    }
+
+    void print(int fps) const {
+        if (frames_.empty()) return;
+
+        // 包是解码顺序，按帧号排序后再切 GOP
+        std::map<int64_t, FrameInfo> by_idx;
+        for (const auto &f : frames_) by_idx[f.idx] = f;
+
+        struct Gop {
+            int64_t start;
+            int length;
+            int64_t bytes;
+        };
+        std::vector<Gop> gops;
+        std::map<char, std::pair<int, int64_t>> types; // 类型 -> (帧数, 字节数)
+        int64_t total = 0;
+        for (const auto &kv : by_idx) {
+            const FrameInfo &f = kv.second;
+            if (f.key || gops.empty()) gops.push_back({f.idx, 0, 0});
+            gops.back().length++;
+            gops.back().bytes += f.size;
+            types[f.type].first++;
+            types[f.type].second += f.size;
+            total += f.size;
+        }
+
+        int min_len = gops[0].length, max_len = gops[0].length;
+        for (const auto &g : gops) {
+            if (g.length < min_len) min_len = g.length;
+            if (g.length > max_len) max_len = g.length;
+        }
+        printf("---------------- GOP Report ----------------\n");
+        printf("%zu frames, %zu GOPs, length min %d / avg %.1f / max %d frames\n",
+               by_idx.size(), gops.size(), min_len, static_cast<double>(by_idx.size()) / gops.size(), max_len);
+
+        const size_t MAX_ROWS = 50;
+        printf("%8s %8s %8s %10s %10s\n", "Key@", "Time s", "Length", "Bytes", "kbps");
+        for (size_t i = 0; i < gops.size() && i < MAX_ROWS; ++i) {
+            const Gop &g = gops[i];
+            printf("%8lld %8.2f %8d %10lld %10.1f\n",
+                   static_cast<long long>(g.start), static_cast<double>(g.start) / fps, g.length,
+                   static_cast<long long>(g.bytes), g.bytes * 8.0 * fps / g.length / 1000.0);
+        }
+        if (gops.size() > MAX_ROWS) printf("  ... %zu more GOPs\n", gops.size() - MAX_ROWS);
+
+        printf("%6s %8s %12s %12s %8s\n", "Type", "Frames", "Avg bytes", "Avg kbit", "Share");
+        for (const auto &kv : types) {
+            const int count = kv.second.first;
+            const int64_t bytes = kv.second.second;
+            printf("%6c %8d %12.0f %12.1f %7.1f%%\n", kv.first, count,
+                   static_cast<double>(bytes) / count, bytes * 8.0 / count / 1000.0,
+                   total > 0 ? 100.0 * bytes / total : 0.0);
+        }
+    }
+
+private:
+    struct FrameInfo {
+        int64_t idx = 0;
+        int size = 0;
+        bool key = false;
+        char type = '?';
+    };
+
+    std::vector<FrameInfo> frames_;
+};
+
+#endif // GOPREPORT_H
@@ -0,0 +1,124 @@
+#include "SceneDetector.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCENE_USE_SSE2 1
+#endif
+
+// 一行像素的 SAD
+static uint64_t row_sad(const uint8_t *a, const uint8_t *b, int n) {
+    uint64_t sum = 0;
+    int i = 0;
+#ifdef SCENE_USE_SSE2
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        // psadbw: 16 个字节差的绝对值分两组求和，结果在两个 64 位通道里
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+    }
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+    sum = lanes[0] + lanes[1];
+#endif
+    for (; i < n; ++i) {
+        sum += static_cast<uint64_t>(abs(a[i] - b[i]));
+    }
+    return sum;
+}
+
+SceneDetector::SceneDetector(int width, int height, const SceneCutOptions &options)
+    : width_(width), height_(height), options_(options) {
+    prev_.resize(static_cast<size_t>(width) * ((height + 1) / 2));
+    memset(prev_hist_, 0, sizeof(prev_hist_));
+    if (options_.min_gop < 1) options_.min_gop = 1;
+    if (options_.max_gop < options_.min_gop) options_.max_gop = options_.min_gop;
+}
+
+bool SceneDetector::push(const uint8_t *luma, int linesize) {
+    const int rows = (height_ + 1) / 2;
+    uint32_t hist[64] = {0};
+    uint64_t sad = 0;
+
+    for (int r = 0; r < rows; ++r) {
+        const uint8_t *src = luma + static_cast<size_t>(r) * 2 * linesize;
+        uint8_t *prev = prev_.data() + static_cast<size_t>(r) * width_;
+        if (frame_idx_ > 0) sad += row_sad(src, prev, width_);
+        for (int x = 0; x < width_; ++x) {
+            hist[src[x] >> 2]++;
+        }
+        memcpy(prev, src, width_);
+    }
+
+    const double pixels = static_cast<double>(rows) * width_;
+    const double sad_mean = sad / pixels;
+    uint64_t hist_diff = 0;
+    for (int i = 0; i < 64; ++i) {
+        hist_diff += static_cast<uint64_t>(abs(static_cast<int>(hist[i]) - static_cast<int>(prev_hist_[i])));
+    }
+    memcpy(prev_hist_, hist, sizeof(hist));
+
+    bool cut = false;
+    if (frame_idx_ > 0) {
+        const double hist_norm = hist_diff / (2.0 * pixels); // 0 = 相同分布, 1 = 完全不重叠
+        cut = hist_norm >= options_.hist_threshold
+              || (sad_mean >= options_.sad_min && avg_sad_ >= 0 && sad_mean >= options_.sad_ratio * avg_sad_);
+
+        // 切换帧不计入均值，否则切换后的一段时间阈值偏高
+        if (!cut) avg_sad_ = avg_sad_ < 0 ? sad_mean : avg_sad_ * 0.9 + sad_mean * 0.1;
+    }
+
+    const int since_key = frame_idx_ - last_key_;
+    bool key = false;
+    if (frame_idx_ == 0) {
+        key = true;
+    } else if (cut) {
+        scene_cuts_++;
+        if (since_key >= options_.min_gop) key = true;
+        else suppressed_++;
+    }
+    if (!key && since_key >= options_.max_gop) {
+        key = true;
+        forced_++;
+    }
+
+    if (key) {
+        last_key_ = frame_idx_;
+        keyframes_++;
+    }
+    frame_idx_++;
+    return key;
+}
+
+bool SceneDetector::analyzeFile(const char *path, int width, int height, const SceneCutOptions &options,
+                                std::vector<uint8_t> &keyframes) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    SceneDetector detector(width, height, options);
+    std::vector<uint8_t> luma(static_cast<size_t>(width) * height);
+    const long chroma_size = static_cast<long>(width) * height / 2;
+    keyframes.clear();
+    while (fread(luma.data(), 1, luma.size(), f) == luma.size()) {
+        keyframes.push_back(detector.push(luma.data(), width) ? 1 : 0);
+        if (fseek(f, chroma_size, SEEK_CUR) != 0) break; // 色度不参与分析
+    }
+    fclose(f);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Scene analysis: %d frames in %.2fs (%.0f fps), %d scene cuts, %d keyframes "
+           "(%d cuts within min GOP %d skipped, %d forced by max GOP %d)\n",
+           detector.frames(), seconds, seconds > 0 ? detector.frames() / seconds : 0.0,
+           detector.sceneCuts(), detector.keyframes(), detector.suppressedCuts(), options.min_gop,
+           detector.forcedByMaxGop(), options.max_gop);
+    return true;
+}
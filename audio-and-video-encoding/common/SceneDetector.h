@@ -0,0 +1,65 @@
+#ifndef SCENEDETECTOR_H
+#define SCENEDETECTOR_H
+
+#include <cstdint>
+#include <vector>
+
+// 场景切换检测参数
+struct SceneCutOptions {
+    int min_gop = 12;            // 两个关键帧至少相隔的帧数，防止闪烁画面连续出 I 帧
+    int max_gop = 50;            // 最长 GOP，到了就强制关键帧
+    double hist_threshold = 0.35; // 亮度直方图差异 (0~1) 超过它视为切换
+    double sad_ratio = 3.0;      // 平均 SAD 超过近期均值的倍数视为切换
+    double sad_min = 8.0;        // 平均每像素 SAD 低于它不算切换 (过滤静止画面的小抖动)
+};
+
+/**
+ * 场景切换预分析：逐帧比较亮度平面，决定哪些帧应该是关键帧
+ *
+ * 只看 Y 分量，且只取偶数行 (降低一半计算量)：
+ *  - SAD：与上一帧逐像素差的绝对值之和，SSE2 的 psadbw 一次处理 16 像素
+ *  - 直方图：64 档亮度直方图的差异，对亮度整体变化 (淡入淡出、硬切) 更敏感
+ *
+ * 在 min_gop / max_gop 约束下放置关键帧。
+ */
+class SceneDetector {
+public:
+    SceneDetector(int width, int height, const SceneCutOptions &options);
+
+    // 输入下一帧的亮度平面，返回这一帧是否应该编成关键帧
+    bool push(const uint8_t *luma, int linesize);
+
+    int frames() const { return frame_idx_; }
+
+    int keyframes() const { return keyframes_; }
+
+    int sceneCuts() const { return scene_cuts_; }
+
+    // 检测到切换但离上个关键帧不足 min_gop 而放弃的次数
+    int suppressedCuts() const { return suppressed_; }
+
+    // 因为达到 max_gop 强制插入的关键帧数
+    int forcedByMaxGop() const { return forced_; }
+
+    // 预分析整个 YUV420P 文件 (只读亮度平面)，keyframes[i] 为 1 表示第 i 帧应该是关键帧，结束时打印统计
+    static bool analyzeFile(const char *path, int width, int height, const SceneCutOptions &options,
+                            std::vector<uint8_t> &keyframes);
+
+private:
+    int width_;
+    int height_;
+    SceneCutOptions options_;
+
+    std::vector<uint8_t> prev_;   // 上一帧的采样行 (紧凑排列)
+    uint32_t prev_hist_[64];
+    double avg_sad_ = -1;         // 近期非切换帧的平均 SAD (指数滑动平均)
+
+    int frame_idx_ = 0;
+    int last_key_ = 0;
+    int keyframes_ = 0;
+    int scene_cuts_ = 0;
+    int suppressed_ = 0;
+    int forced_ = 0;
+};
+
+#endif // SCENEDETECTOR_H
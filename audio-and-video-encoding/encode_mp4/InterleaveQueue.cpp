@@ -0,0 +1,106 @@
+#include "InterleaveQueue.h"
+
+// 包的排序时间戳：优先用 DTS，编码器没给 DTS 时退回 PTS
+static int64_t packet_ts(const AVPacket *pkt) {
+    return pkt->dts != AV_NOPTS_VALUE ? pkt->dts : pkt->pts;
+}
+
+InterleaveQueue::InterleaveQueue(int nb_streams, size_t max_packets_per_stream)
+    : streams_(nb_streams), max_packets_(max_packets_per_stream) {
+    for (auto &sq : streams_) {
+        sq.slots.resize(max_packets_);
+        for (auto &slot : sq.slots) {
+            slot = av_packet_alloc();
+        }
+    }
+}
+
+InterleaveQueue::~InterleaveQueue() {
+    for (auto &sq : streams_) {
+        for (AVPacket *&slot : sq.slots) {
+            av_packet_free(&slot);
+        }
+    }
+}
+
+void InterleaveQueue::setTimeBase(int stream_index, AVRational time_base) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_[stream_index].time_base = time_base;
+}
+
+bool InterleaveQueue::push(AVPacket *pkt) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    StreamQueue &sq = streams_[pkt->stream_index];
+
+    // 自己这一路满了就等封装线程消费，避免某一路编码过快把内存吃光
+    cond_not_full_.wait(lock, [&] { return aborted_ || sq.count < max_packets_; });
+    if (aborted_) {
+        av_packet_unref(pkt);
+        return false;
+    }
+
+    av_packet_move_ref(sq.slots[(sq.head + sq.count) % max_packets_], pkt);
+    sq.count++;
+    if (sq.count > max_depth_) max_depth_ = sq.count;
+    cond_not_empty_.notify_one();
+    return true;
+}
+
+void InterleaveQueue::finish(int stream_index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_[stream_index].finished = true;
+    cond_not_empty_.notify_one();
+}
+
+int InterleaveQueue::selectStream() const {
+    int best = -1;
+    bool all_done = true;
+
+    for (size_t i = 0; i < streams_.size(); ++i) {
+        const StreamQueue &sq = streams_[i];
+        if (sq.count == 0) {
+            // 还没结束却没有包：它的下一个包可能比其他流的都早，只能等
+            if (!sq.finished) return -1;
+            continue;
+        }
+        all_done = false;
+
+        if (best < 0) {
+            best = static_cast<int>(i);
+            continue;
+        }
+        const StreamQueue &bq = streams_[best];
+        if (av_compare_ts(packet_ts(sq.slots[sq.head]), sq.time_base,
+                          packet_ts(bq.slots[bq.head]), bq.time_base) < 0) {
+            best = static_cast<int>(i);
+        }
+    }
+    return all_done ? -2 : best;
+}
+
+int InterleaveQueue::pop(AVPacket *pkt) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    int index = -1;
+    cond_not_empty_.wait(lock, [&] {
+        if (aborted_) return true;
+        index = selectStream();
+        return index != -1;
+    });
+
+    if (aborted_) return AVERROR_EXIT;
+    if (index == -2) return 0;
+
+    StreamQueue &sq = streams_[index];
+    av_packet_move_ref(pkt, sq.slots[sq.head]);
+    sq.head = (sq.head + 1) % max_packets_;
+    sq.count--;
+    cond_not_full_.notify_all();
+    return 1;
+}
+
+void InterleaveQueue::abort() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    aborted_ = true;
+    cond_not_full_.notify_all();
+    cond_not_empty_.notify_all();
+}
@@ -0,0 +1,77 @@
+#ifndef INTERLEAVEQUEUE_H
+#define INTERLEAVEQUEUE_H
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/mathematics.h>
+}
+
+/**
+ * 多路编码线程 -> 单个封装线程 之间的交错队列
+ *
+ * 每路流一个有界 FIFO：
+ *  - 生产者 (编码线程) 调用 push()，自己那一路满了就阻塞，内存上限 = 流数 * max_packets
+ *  - 消费者 (封装线程) 调用 pop()，只有当所有未结束的流都至少有一个包时，
+ *    才取出 DTS 最小的那个，保证送给 av_interleaved_write_frame 的包已按时间排好序
+ *
+ * 生产者只会等自己的队列，消费者只会等"还没结束且为空"的队列，所以不会互相死锁。
+ *
+ * 所有 AVPacket 槽位在构造时一次性分配成环形缓冲，push/pop 只做 av_packet_move_ref，
+ * 运行期间不再分配内存。
+ */
+class InterleaveQueue {
+public:
+    InterleaveQueue(int nb_streams, size_t max_packets_per_stream);
+
+    ~InterleaveQueue();
+
+    // 设置某路流的时间基 (push 进来的包必须已经是该时间基)
+    void setTimeBase(int stream_index, AVRational time_base);
+
+    // 放入一个包，接管 pkt 的引用 (调用后 pkt 为空)
+    // 返回 false 表示队列已被 abort，生产者应停止
+    bool push(AVPacket *pkt);
+
+    // 标记某路流不会再有新包 (编码器 flush 完毕后调用)
+    void finish(int stream_index);
+
+    // 取出下一个应写入的包 (引用转移到 pkt)
+    // 返回: 1 取到包, 0 所有流都已结束, AVERROR_EXIT 已被 abort
+    int pop(AVPacket *pkt);
+
+    // 出错时调用，唤醒所有等待中的线程
+    void abort();
+
+    // 运行期间某一路出现过的最大排队深度，用于观察内存占用
+    size_t maxDepth() const { return max_depth_; }
+
+    // 构造时预分配的 AVPacket 数量 (计入初始化阶段的分配统计)
+    size_t preallocated() const { return streams_.size() * max_packets_; }
+
+private:
+    struct StreamQueue {
+        std::vector<AVPacket *> slots; // 预分配的环形缓冲，容量 max_packets_
+        size_t head = 0;               // 队头槽位
+        size_t count = 0;              // 当前排队的包数
+        AVRational time_base{1, 1};
+        bool finished = false;
+    };
+
+    // 需在持锁状态下调用: 返回可以出队的流索引，-1 表示还需要等待，-2 表示全部结束
+    int selectStream() const;
+
+    std::vector<StreamQueue> streams_;
+    size_t max_packets_;
+    size_t max_depth_ = 0;
+    bool aborted_ = false;
+
+    std::mutex mutex_;
+    std::condition_variable cond_not_full_;
+    std::condition_variable cond_not_empty_;
+};
+
+#endif // INTERLEAVEQUEUE_H
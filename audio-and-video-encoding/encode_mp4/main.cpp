@@ -2,6 +2,20 @@
 #include <cstdio>
 #include <cstring>
 #include <cerrno>
+#include <thread>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include "InterleaveQueue.h"
+#include "EncoderProfile.h"
+#include "SceneDetector.h"
+#include "GopReport.h"
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -21,15 +35,19 @@ const char *OUT_FILENAME = "../output.mp4";
 const int V_WIDTH = 1280;
 const int V_HEIGHT = 720;
 const int V_FPS = 30;
-const int V_BITRATE = 2000000; // 2Mbps
+const int V_BITRATE = 2000000; // 2Mbps (默认 profile 的码率，可用 --bitrate 覆盖)
 
 // 音频参数 (必须与输入 PCM 严格一致)
 const int A_SAMPLE_RATE = 48000;
 const int A_CHANNELS = 2;
+
+// 交错队列中每路流最多缓存的包数 (限制内存占用)
+const size_t MAX_QUEUED_PACKETS = 64;
 // ====================================================================
 
 void add_stream(AVFormatContext *oc, AVStream **st, AVCodecContext **enc_ctx,
-                AVCodecID codec_id, int width, int height, int fps, int sample_rate) {
+                AVCodecID codec_id, int width, int height, int fps, int sample_rate,
+                const EncoderProfile *profile = nullptr) {
     const AVCodec *codec = avcodec_find_encoder(codec_id);
     if (!codec) {
         fprintf(stderr, "Codec not found. ID: %d\n", codec_id);
@@ -51,19 +69,15 @@ void add_stream(AVFormatContext *oc, AVStream **st, AVCodecContext **enc_ctx,
 
     if (codec->type == AVMEDIA_TYPE_VIDEO) {
         (*enc_ctx)->codec_id = codec_id;
-        (*enc_ctx)->bit_rate = V_BITRATE;
         (*enc_ctx)->width = width;
         (*enc_ctx)->height = height;
         (*enc_ctx)->time_base = (AVRational){1, fps};
         (*enc_ctx)->framerate = (AVRational){fps, 1};
-        (*enc_ctx)->gop_size = 12;
         (*enc_ctx)->pix_fmt = AV_PIX_FMT_YUV420P;
 
-        if ((*enc_ctx)->codec_id == AV_CODEC_ID_H264) {
-            // preset: ultrafast(最快/体积大) -> medium -> veryslow(最慢/体积小)
-            // Debug 模式下建议用 ultrafast，否则会感觉像死机
-            av_opt_set((*enc_ctx)->priv_data, "preset", "ultrafast", 0);
-        }
+        // 码控 / preset / tune / GOP / B 帧 / lookahead / 线程数 全部来自 profile
+        // preset: ultrafast(最快/体积大) -> medium -> veryslow(最慢/体积小)
+        if (profile) apply_profile(*enc_ctx, *profile);
         (*st)->time_base = (*enc_ctx)->time_base;
     } else if (codec->type == AVMEDIA_TYPE_AUDIO) {
         (*enc_ctx)->sample_fmt = codec->sample_fmts ? codec->sample_fmts[0] : AV_SAMPLE_FMT_FLTP;
@@ -82,7 +96,82 @@ void add_stream(AVFormatContext *oc, AVStream **st, AVCodecContext **enc_ctx,
         (*enc_ctx)->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
 }
 
-int write_frame(AVFormatContext *fmt_ctx, AVCodecContext *c, AVStream *st, AVFrame *frame) {
+// ================= 分配计数 =================
+// 只统计本程序自己发起的分配 (av_frame_alloc / av_packet_alloc / av_malloc / 帧缓冲重分配等)，
+// 每处调用旁边手动 count_alloc()。libavcodec / libavformat / 封装器内部的分配看不到，不在统计范围内，
+// 所以编码循环计数为 0 只说明本程序的循环没有分配，不代表整个进程没有分配。
+// 编码线程启动前的分配记为"初始化"，启动后的记为"编码循环"。
+static std::atomic<bool> g_steady_state(false);
+static std::atomic<int> g_setup_allocs(0);
+static std::atomic<int> g_loop_allocs(0);
+
+static void count_alloc(int n = 1) {
+    if (g_steady_state) g_loop_allocs += n;
+    else g_setup_allocs += n;
+}
+
+// 单路编码所需的全部对象，在启动编码线程前一次性分配好，循环中复用
+struct StreamEncoder {
+    AVCodecContext *ctx = nullptr;
+    AVStream *st = nullptr;
+    FILE *in = nullptr;
+    AVFrame *frame = nullptr;     // 复用的输入帧
+    AVPacket *pkt = nullptr;      // 复用的输出包 (push 后引用转移给队列)
+    uint8_t *pcm_buf = nullptr;   // 音频: 一帧 PCM 读缓冲
+    SwrContext *swr = nullptr;    // 音频: 重采样器
+    const std::vector<uint8_t> *keyframes = nullptr; // 视频: 场景预分析给出的关键帧 (--scene-cut)
+    GopReport *report = nullptr;  // 视频: GOP 统计 (--gop-report)
+    int result = 0;
+};
+
+int alloc_stream_buffers(StreamEncoder &enc) {
+    AVCodecContext *c = enc.ctx;
+    enc.frame = av_frame_alloc();
+    enc.pkt = av_packet_alloc();
+    count_alloc(2);
+    if (!enc.frame || !enc.pkt) return AVERROR(ENOMEM);
+
+    if (c->codec_type == AVMEDIA_TYPE_VIDEO) {
+        enc.frame->format = c->pix_fmt;
+        enc.frame->width = c->width;
+        enc.frame->height = c->height;
+        count_alloc();
+        return av_frame_get_buffer(enc.frame, 32);
+    }
+
+    enc.frame->nb_samples = c->frame_size;
+    enc.frame->format = c->sample_fmt;
+#if LIBAVCODEC_VERSION_MAJOR >= 60
+    av_channel_layout_copy(&enc.frame->ch_layout, &c->ch_layout);
+#else
+    enc.frame->channel_layout = c->channel_layout;
+#endif
+    count_alloc();
+    int ret = av_frame_get_buffer(enc.frame, 0);
+    if (ret < 0) return ret;
+
+    enc.pcm_buf = static_cast<uint8_t *>(av_malloc(c->frame_size * 2 * A_CHANNELS));
+    count_alloc();
+    return enc.pcm_buf ? 0 : AVERROR(ENOMEM);
+}
+
+void free_stream_buffers(StreamEncoder &enc) {
+    av_frame_free(&enc.frame);
+    av_packet_free(&enc.pkt);
+    av_freep(&enc.pcm_buf);
+}
+
+// 编码器还持有上一帧的引用时 av_frame_make_writable 会重新分配缓冲，这里把这种情况计入统计
+int make_frame_writable(AVFrame *frame) {
+    if (!av_frame_is_writable(frame)) count_alloc();
+    return av_frame_make_writable(frame);
+}
+
+// 编码一帧并把得到的包放入交错队列 (frame 为 nullptr 时 flush 编码器)
+int encode_frame(StreamEncoder &enc, AVFrame *frame, InterleaveQueue &queue) {
+    AVCodecContext *c = enc.ctx;
+    AVPacket *pkt = enc.pkt;
+
     int ret = avcodec_send_frame(c, frame);
     if (ret < 0) {
         fprintf(stderr, "Error sending frame to encoder: %s\n", av_err2str(ret));
@@ -90,32 +179,260 @@ int write_frame(AVFormatContext *fmt_ctx, AVCodecContext *c, AVStream *st, AVFra
     }
 
     while (ret >= 0) {
-        AVPacket *pkt = av_packet_alloc();
         ret = avcodec_receive_packet(c, pkt);
         if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-            av_packet_free(&pkt);
             return 0;
         } else if (ret < 0) {
-            fprintf(stderr, "Error encoding audio frame: %s\n", av_err2str(ret));
-            av_packet_free(&pkt);
+            fprintf(stderr, "Error encoding frame: %s\n", av_err2str(ret));
             return ret;
         }
 
-        av_packet_rescale_ts(pkt, c->time_base, st->time_base);
-        pkt->stream_index = st->index;
+        // pts 还是编码器时间基 (1/fps)，即帧号
+        if (enc.report) enc.report->add(pkt);
+        av_packet_rescale_ts(pkt, c->time_base, enc.st->time_base);
+        pkt->stream_index = enc.st->index;
 
-        ret = av_interleaved_write_frame(fmt_ctx, pkt);
-        av_packet_free(&pkt);
-        if (ret < 0) {
-            fprintf(stderr, "Error writing packet: %s\n", av_err2str(ret));
-            return ret;
-        }
+        // push 会接管 pkt 的引用；返回 false 说明封装线程已出错退出
+        if (!queue.push(pkt)) return AVERROR_EXIT;
     }
     return 0;
 }
 
-int main() {
+// 视频编码线程：读 YUV -> H.264 -> 交错队列
+void video_encode_thread(StreamEncoder *enc, InterleaveQueue *queue) {
+    AVFrame *v_frame = enc->frame;
+    int64_t v_pts = 0;
+    int y_size = V_WIDTH * V_HEIGHT;
+    int ret = 0;
+
+    while (true) {
+        if ((ret = make_frame_writable(v_frame)) < 0) break;
+
+        // 注意：这里简化处理，假设 linesize = width。严谨项目需按行拷贝。
+        int read_y = fread(v_frame->data[0], 1, y_size, enc->in);
+        int read_u = fread(v_frame->data[1], 1, y_size / 4, enc->in);
+        int read_v = fread(v_frame->data[2], 1, y_size / 4, enc->in);
+
+        if (read_y <= 0 || read_u <= 0 || read_v <= 0) {
+            printf("\n视频数据读取完毕!\n");
+            break;
+        }
+
+        // 场景切换处强制关键帧，其余帧由编码器自己决定
+        const bool force_key = enc->keyframes && v_pts < static_cast<int64_t>(enc->keyframes->size())
+                               && (*enc->keyframes)[v_pts];
+        v_frame->pict_type = force_key ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
+        v_frame->pts = v_pts++;
+        if ((ret = encode_frame(*enc, v_frame, *queue)) < 0) break;
+
+        // --- 进度打印 (防止看起来像死机) ---
+        if (v_pts % 10 == 0) {
+            printf("\n 正在编码视频帧: %lld (时间: %.2fs)\r", v_pts, v_pts / static_cast<double>(V_FPS));
+            fflush(stdout); // 必须 flush，否则控制台看不到动态变化
+        }
+    }
+
+    // 刷新编码器缓冲区
+    if (ret >= 0) ret = encode_frame(*enc, nullptr, *queue);
+    queue->finish(enc->st->index);
+    enc->result = ret;
+}
+
+// 音频编码线程：读 PCM -> 重采样 -> AAC -> 交错队列
+void audio_encode_thread(StreamEncoder *enc, InterleaveQueue *queue) {
+    AVFrame *a_frame = enc->frame;
+    const int sample_size_bytes = 2 * A_CHANNELS;
+    const int samples_per_frame = enc->ctx->frame_size;
+    int64_t a_pts = 0;
+    bool a_finished = false;
+    int ret = 0;
+
+    while (!a_finished) {
+        if ((ret = make_frame_writable(a_frame)) < 0) break;
+
+        int read_bytes = fread(enc->pcm_buf, 1, samples_per_frame * sample_size_bytes, enc->in);
+        int read_samples = read_bytes / sample_size_bytes;
+
+        if (read_samples < samples_per_frame) {
+            a_finished = true;
+            printf("\n音频数据读取完毕!\n");
+        }
+
+        if (read_samples > 0) {
+            const uint8_t *in_data[1] = {enc->pcm_buf};
+            swr_convert(enc->swr, a_frame->data, samples_per_frame, in_data, read_samples);
+            a_frame->nb_samples = read_samples;
+            a_frame->pts = a_pts;
+            a_pts += read_samples;
+            if ((ret = encode_frame(*enc, a_frame, *queue)) < 0) break;
+        }
+    }
+
+    if (ret >= 0) ret = encode_frame(*enc, nullptr, *queue);
+    queue->finish(enc->st->index);
+    enc->result = ret;
+}
+
+// ================= 分段输出 (--segment fmp4|hls|dash) =================
+// 默认输出单个 MP4，moov 在文件尾，av_write_trailer 之前无法播放。
+// 分段模式下 GOP 固定为一个分片的长度且关闭场景切换插帧，保证每个分片/分段都从 IDR 开始:
+//  - fmp4: 单个分片 MP4 (empty_moov + 每个关键帧一个 moof)，边写边可播
+//  - hls : fMP4 分段 + 滚动 index.m3u8，只保留最近 window 个分段
+//  - dash: fMP4 分段 + 滚动 manifest.mpd
+struct SegmentOptions {
+    std::string mode;              // 空表示普通 MP4
+    int frag_ms = 2000;            // 分片时长，也是 GOP 时长
+    int seg_ms = 4000;             // 分段时长 (hls/dash)，向上取整到分片的整数倍
+    int window = 5;                // 播放列表中保留的分段数
+    std::string dir = "../live";   // hls/dash 输出目录
+};
+
+static int make_dir(const std::string &dir) {
+#ifdef _WIN32
+    int ret = _mkdir(dir.c_str());
+#else
+    int ret = mkdir(dir.c_str(), 0755);
+#endif
+    return (ret == 0 || errno == EEXIST) ? 0 : -1;
+}
+
+// 按分段模式创建输出上下文并填好封装器参数，out_path 返回实际输出的文件/清单路径
+int open_output(AVFormatContext **oc, const SegmentOptions &seg, AVDictionary **opts, std::string &out_path) {
+    char buf[64];
+
+    if (seg.mode.empty()) {
+        out_path = OUT_FILENAME;
+        return avformat_alloc_output_context2(oc, nullptr, nullptr, out_path.c_str());
+    }
+
+    if (seg.mode == "fmp4") {
+        out_path = OUT_FILENAME;
+        av_dict_set(opts, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+        return avformat_alloc_output_context2(oc, nullptr, "mp4", out_path.c_str());
+    }
+
+    if (make_dir(seg.dir) < 0) {
+        fprintf(stderr, "无法创建输出目录 '%s': %s\n", seg.dir.c_str(), strerror(errno));
+        return AVERROR(errno);
+    }
+
+    // 分段时长取分片的整数倍，让分段边界一定落在 GOP 边界上
+    int frags_per_seg = (seg.seg_ms + seg.frag_ms - 1) / seg.frag_ms;
+    snprintf(buf, sizeof(buf), "%.3f", frags_per_seg * seg.frag_ms / 1000.0);
+
+    if (seg.mode == "hls") {
+        out_path = seg.dir + "/index.m3u8";
+        av_dict_set(opts, "hls_segment_type", "fmp4", 0);
+        av_dict_set(opts, "hls_time", buf, 0);
+        av_dict_set_int(opts, "hls_list_size", seg.window, 0);
+        av_dict_set(opts, "hls_flags", "delete_segments+independent_segments", 0);
+        av_dict_set(opts, "hls_fmp4_init_filename", "init.mp4", 0);
+        av_dict_set(opts, "hls_segment_filename", (seg.dir + "/seg_%05d.m4s").c_str(), 0);
+        return avformat_alloc_output_context2(oc, nullptr, "hls", out_path.c_str());
+    }
+
+    if (seg.mode == "dash") {
+        out_path = seg.dir + "/manifest.mpd";
+        av_dict_set(opts, "seg_duration", buf, 0);
+        snprintf(buf, sizeof(buf), "%.3f", seg.frag_ms / 1000.0);
+        av_dict_set(opts, "frag_duration", buf, 0);
+        av_dict_set(opts, "frag_type", "duration", 0);
+        av_dict_set_int(opts, "window_size", seg.window, 0);
+        av_dict_set_int(opts, "extra_window_size", 2, 0);
+        av_dict_set(opts, "streaming", "1", 0);
+        av_dict_set(opts, "use_template", "1", 0);
+        av_dict_set(opts, "use_timeline", "1", 0);
+        return avformat_alloc_output_context2(oc, nullptr, "dash", out_path.c_str());
+    }
+
+    fprintf(stderr, "未知的分段模式: %s (可选 fmp4 / hls / dash)\n", seg.mode.c_str());
+    return AVERROR(EINVAL);
+}
+
+// 文件长度，读写位置回到开头；YUV 文件常常超过 2GB
+static int64_t get_file_size(FILE *f) {
+#ifdef _WIN32
+    if (_fseeki64(f, 0, SEEK_END) != 0) return 0;
+    const int64_t size = _ftelli64(f);
+#else
+    if (fseeko(f, 0, SEEK_END) != 0) return 0;
+    const int64_t size = ftello(f);
+#endif
+    rewind(f);
+    return size > 0 ? size : 0;
+}
+
+int main(int argc, char *argv[]) {
     setbuf(stdout, nullptr);
+
+    // 默认 profile 与之前写死的参数一致: 2Mbps ABR, GOP 12, preset=ultrafast
+    // Debug 模式下建议用 ultrafast，否则会感觉像死机
+    EncoderProfile v_profile;
+    v_profile.bitrate = V_BITRATE;
+    v_profile.gop = 12;
+    v_profile.preset = "ultrafast";
+
+    SegmentOptions seg;
+
+    // 场景切换预分析 / GOP 报告，参数与 encode_video 相同
+    bool scene_cut = false;
+    bool gop_report = false;
+    SceneCutOptions sc;
+    sc.min_gop = V_FPS / 2;
+    sc.max_gop = V_FPS * 2;
+
+    // 命令行: --profile "rc=crf,crf=23,preset=veryfast" 或 --<key> <value> 逐项覆盖
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--scene-cut") {
+            scene_cut = true;
+            continue;
+        }
+        if (arg == "--gop-report") {
+            gop_report = true;
+            continue;
+        }
+        if (arg.compare(0, 2, "--") != 0 || i + 1 >= argc) {
+            fprintf(stderr, "Usage: %s [--profile <spec>] [--rc crf|abr|cbr] [--bitrate N] [--crf N] [--preset P]"
+                            " [--tune T] [--gop N] [--bf N] [--lookahead N] [--threads N]\n"
+                            "          [--segment fmp4|hls|dash] [--frag-ms N] [--seg-ms N] [--window N] [--out-dir D]\n"
+                            "          [--scene-cut] [--min-gop N] [--max-gop N] [--scene-threshold X] [--gop-report]\n",
+                    argv[0]);
+            return -1;
+        }
+        std::string value = argv[++i];
+        bool ok = true;
+        if (arg == "--segment") seg.mode = value;
+        else if (arg == "--min-gop") ok = (sc.min_gop = atoi(value.c_str())) > 0;
+        else if (arg == "--max-gop") ok = (sc.max_gop = atoi(value.c_str())) > 0;
+        else if (arg == "--scene-threshold") ok = (sc.hist_threshold = atof(value.c_str())) > 0;
+        else if (arg == "--frag-ms") ok = (seg.frag_ms = atoi(value.c_str())) > 0;
+        else if (arg == "--seg-ms") ok = (seg.seg_ms = atoi(value.c_str())) > 0;
+        else if (arg == "--window") ok = (seg.window = atoi(value.c_str())) > 0;
+        else if (arg == "--out-dir") seg.dir = value;
+        else if (arg == "--profile") ok = parse_profile(value, v_profile);
+        else ok = set_profile_option(v_profile, arg.substr(2), value);
+        if (!ok) {
+            fprintf(stderr, "无效参数: %s %s\n", arg.c_str(), value.c_str());
+            return -1;
+        }
+    }
+
+    // 分段要求固定 GOP 与分片对齐，和按场景放关键帧矛盾
+    if (scene_cut && !seg.mode.empty()) {
+        fprintf(stderr, "--scene-cut 不能与 --segment 同时使用\n");
+        return -1;
+    }
+    if (sc.max_gop < sc.min_gop) sc.max_gop = sc.min_gop;
+
+    // 分段模式下 GOP 由分片时长决定 (覆盖 profile 里的 gop)
+    if (!seg.mode.empty()) {
+        v_profile.gop = std::max(1, V_FPS * seg.frag_ms / 1000);
+        printf("分段输出: mode=%s 分片=%dms 分段=%dms 窗口=%d 个\n",
+               seg.mode.c_str(), seg.frag_ms, seg.seg_ms, seg.window);
+    }
+    printf("视频 profile %s\n", describe_profile(v_profile).c_str());
+
     // 0. 打开输入文件 (增加详细错误检查)
     FILE *f_yuv = fopen(IN_FILENAME_VIDEO, "rb");
     if (!f_yuv) {
@@ -133,16 +450,34 @@ int main() {
 
     printf("成功打开输入文件，准备开始...\n");
 
-    AVFormatContext *oc;
-    avformat_alloc_output_context2(&oc, nullptr, nullptr, OUT_FILENAME);
+    std::vector<uint8_t> keyframes;
+    if (scene_cut && !SceneDetector::analyzeFile(IN_FILENAME_VIDEO, V_WIDTH, V_HEIGHT, sc, keyframes)) return -1;
+
+    AVFormatContext *oc = nullptr;
+    AVDictionary *mux_opts = nullptr;
+    std::string out_path;
+    open_output(&oc, seg, &mux_opts, out_path);
     if (!oc) return -1;
 
     AVStream *v_st = nullptr, *a_st = nullptr;
     AVCodecContext *v_ctx = nullptr, *a_ctx = nullptr;
 
-    add_stream(oc, &v_st, &v_ctx, AV_CODEC_ID_H264, V_WIDTH, V_HEIGHT, V_FPS, 0);
+    add_stream(oc, &v_st, &v_ctx, AV_CODEC_ID_H264, V_WIDTH, V_HEIGHT, V_FPS, 0, &v_profile);
     add_stream(oc, &a_st, &a_ctx, AV_CODEC_ID_AAC, 0, 0, 0, A_SAMPLE_RATE);
 
+    if (!seg.mode.empty()) {
+        // 固定 GOP、封闭 GOP、禁止场景切换插入额外 IDR，分片边界才能与 GOP 对齐
+        v_ctx->keyint_min = v_ctx->gop_size;
+        v_ctx->flags |= AV_CODEC_FLAG_CLOSED_GOP;
+        av_opt_set(v_ctx->priv_data, "x264-params", "scenecut=0", 0);
+    } else if (scene_cut) {
+        // 关键帧由 frame->pict_type = I 强制给出，max_gop 只是兜底
+        v_ctx->gop_size = sc.max_gop;
+        v_ctx->keyint_min = sc.min_gop;
+        av_opt_set_int(v_ctx->priv_data, "forced-idr", 1, 0);
+        av_opt_set(v_ctx->priv_data, "x264-params", "scenecut=0", 0);
+    }
+
     // 打开编码器
     if (avcodec_open2(v_ctx, v_ctx->codec, nullptr) < 0) return -1;
     if (avcodec_open2(a_ctx, a_ctx->codec, nullptr) < 0) return -1;
@@ -152,30 +487,19 @@ int main() {
     avcodec_parameters_from_context(a_st->codecpar, a_ctx);
 
     if (!(oc->oformat->flags & AVFMT_NOFILE)) {
-        if (avio_open(&oc->pb, OUT_FILENAME, AVIO_FLAG_WRITE) < 0) {
-            fprintf(stderr, "Could not open output file '%s'", OUT_FILENAME);
+        if (avio_open(&oc->pb, out_path.c_str(), AVIO_FLAG_WRITE) < 0) {
+            fprintf(stderr, "Could not open output file '%s'", out_path.c_str());
             return -1;
         }
     }
 
-    if (avformat_write_header(oc, nullptr) < 0) return -1;
-
-    // Frame Allocations
-    AVFrame *v_frame = av_frame_alloc();
-    v_frame->format = v_ctx->pix_fmt;
-    v_frame->width = v_ctx->width;
-    v_frame->height = v_ctx->height;
-    av_frame_get_buffer(v_frame, 32);
-
-    AVFrame *a_frame = av_frame_alloc();
-    a_frame->nb_samples = a_ctx->frame_size;
-    a_frame->format = a_ctx->sample_fmt;
-#if LIBAVCODEC_VERSION_MAJOR >= 60
-    av_channel_layout_copy(&a_frame->ch_layout, &a_ctx->ch_layout);
-#else
-    a_frame->channel_layout = a_ctx->channel_layout;
-#endif
-    av_frame_get_buffer(a_frame, 0);
+    int header_ret = avformat_write_header(oc, &mux_opts);
+    AVDictionaryEntry *unused = nullptr;
+    while ((unused = av_dict_get(mux_opts, "", unused, AV_DICT_IGNORE_SUFFIX))) {
+        fprintf(stderr, "警告: 封装器未识别参数 %s=%s\n", unused->key, unused->value);
+    }
+    av_dict_free(&mux_opts);
+    if (header_ret < 0) return -1;
 
     // Swr Init
     SwrContext *swr_ctx = swr_alloc();
@@ -194,84 +518,95 @@ int main() {
     av_opt_set_sample_fmt(swr_ctx, "out_sample_fmt", a_ctx->sample_fmt, 0);
     swr_init(swr_ctx);
 
-    int64_t v_pts = 0;
-    int64_t a_pts = 0;
-    bool v_finished = false;
-    bool a_finished = false;
-    int y_size = V_WIDTH * V_HEIGHT;
+    // 每路流最多缓存 MAX_QUEUED_PACKETS 个包，编码快的一路会被阻塞等待封装线程
+    InterleaveQueue queue(oc->nb_streams, MAX_QUEUED_PACKETS);
+    queue.setTimeBase(v_st->index, v_st->time_base);
+    queue.setTimeBase(a_st->index, a_st->time_base);
+    count_alloc(static_cast<int>(queue.preallocated()));
+
+    // 所有帧/包/PCM 缓冲都在这里一次性分配，编码循环中只复用
+    StreamEncoder v_enc, a_enc;
+    v_enc.ctx = v_ctx;
+    v_enc.st = v_st;
+    v_enc.in = f_yuv;
+    a_enc.ctx = a_ctx;
+    a_enc.st = a_st;
+    a_enc.in = f_pcm;
+    a_enc.swr = swr_ctx;
+    GopReport report;
+    if (scene_cut || gop_report) {
+        // 帧数由文件大小推算，记录空间一次预留好
+        const int64_t frame_bytes = static_cast<int64_t>(V_WIDTH) * V_HEIGHT * 3 / 2;
+        report.reserve(static_cast<size_t>(get_file_size(f_yuv) / frame_bytes));
+        count_alloc();
+        v_enc.report = &report;
+    }
+    if (scene_cut) v_enc.keyframes = &keyframes;
+    if (alloc_stream_buffers(v_enc) < 0 || alloc_stream_buffers(a_enc) < 0) {
+        fprintf(stderr, "Could not allocate frame buffers\n");
+        return -1;
+    }
+
+    AVPacket *out_pkt = av_packet_alloc();
+    count_alloc();
+
+    printf("开始编码 (音视频并行)...\n");
+    int64_t start_time = av_gettime_relative();
+    g_steady_state = true;
 
-    printf("开始编码...\n");
-
-    while (!v_finished || !a_finished) {
-        double v_time = v_finished ? 1e9 : av_q2d(v_st->time_base) * v_pts;
-        double a_time = a_finished ? 1e9 : av_q2d(a_st->time_base) * a_pts;
-
-        if (!v_finished && v_time <= a_time) {
-            // Video
-            if (av_frame_make_writable(v_frame) < 0) break;
-
-            // 注意：这里简化处理，假设 linesize = width。严谨项目需按行拷贝。
-            int read_y = fread(v_frame->data[0], 1, y_size, f_yuv);
-            int read_u = fread(v_frame->data[1], 1, y_size / 4, f_yuv);
-            int read_v = fread(v_frame->data[2], 1, y_size / 4, f_yuv);
-
-            if (read_y <= 0 || read_u <= 0 || read_v <= 0) {
-                v_finished = true;
-                printf("\n视频数据读取完毕!\n");
-            } else {
-                v_frame->pts = v_pts++;
-                write_frame(oc, v_ctx, v_st, v_frame);
-
-                // --- 进度打印 (防止看起来像死机) ---
-                if (v_pts % 10 == 0) {
-                    printf("\n 正在编码视频帧: %lld (时间: %.2fs)\r", v_pts, v_pts / static_cast<double>(V_FPS));
-                    fflush(stdout); // 必须 flush，否则控制台看不到动态变化
-                }
-            }
-        } else if (!a_finished) {
-            // Audio
-            if (av_frame_make_writable(a_frame) < 0) break;
-
-            const int sample_size_bytes = 2 * A_CHANNELS;
-            const int samples_per_frame = a_ctx->frame_size;
-            uint8_t *pcm_buf = (uint8_t *) malloc(samples_per_frame * sample_size_bytes);
-
-            int read_bytes = fread(pcm_buf, 1, samples_per_frame * sample_size_bytes, f_pcm);
-            int read_samples = read_bytes / sample_size_bytes;
-
-            if (read_samples < samples_per_frame) {
-                a_finished = true;
-                printf("\n音频数据读取完毕!\n");
-            }
-
-            if (read_samples > 0) {
-                const uint8_t *in_data[1] = {pcm_buf};
-                swr_convert(swr_ctx, a_frame->data, samples_per_frame, in_data, read_samples);
-                a_frame->nb_samples = read_samples;
-                a_frame->pts = a_pts;
-                a_pts += read_samples;
-                write_frame(oc, a_ctx, a_st, a_frame);
-            }
-            free(pcm_buf);
+    std::thread v_thread(video_encode_thread, &v_enc, &queue);
+    std::thread a_thread(audio_encode_thread, &a_enc, &queue);
+
+    // 主线程负责封装：按 DTS 顺序从队列取包写入文件
+    int ret;
+    bool failed = false;
+    while ((ret = queue.pop(out_pkt)) > 0) {
+        ret = av_interleaved_write_frame(oc, out_pkt);
+        if (ret < 0) {
+            fprintf(stderr, "Error writing packet: %s\n", av_err2str(ret));
+            queue.abort();
+            failed = true;
+            break;
         }
     }
 
-    printf("\n正在刷新编码器缓冲区...\n");
-    write_frame(oc, v_ctx, v_st, nullptr);
-    write_frame(oc, a_ctx, a_st, nullptr);
+    v_thread.join();
+    a_thread.join();
+    g_steady_state = false;
+
+    printf("\n编码耗时: %.2fs, 队列最大深度: %zu\n",
+           (av_gettime_relative() - start_time) / 1000000.0, queue.maxDepth());
+    printf("内存分配统计 (仅本程序, 不含 libav* 内部): 初始化 %d 次, 编码循环 %d 次\n",
+           g_setup_allocs.load(), g_loop_allocs.load());
+    if (v_enc.report) report.print(V_FPS);
+    if (v_enc.result < 0 || a_enc.result < 0) {
+        fprintf(stderr, "编码线程出错: video=%d audio=%d\n", v_enc.result, a_enc.result);
+        failed = true;
+    }
+
+    av_packet_free(&out_pkt);
+    free_stream_buffers(v_enc);
+    free_stream_buffers(a_enc);
 
-    av_write_trailer(oc);
+    // 出错时也写文件尾，已经写出的部分还能播放
+    ret = av_write_trailer(oc);
+    if (ret < 0) {
+        fprintf(stderr, "Error writing trailer: %s\n", av_err2str(ret));
+        failed = true;
+    }
 
     if (!(oc->oformat->flags & AVFMT_NOFILE)) avio_closep(&oc->pb);
     avformat_free_context(oc);
     avcodec_free_context(&v_ctx);
     avcodec_free_context(&a_ctx);
-    av_frame_free(&v_frame);
-    av_frame_free(&a_frame);
     swr_free(&swr_ctx);
     fclose(f_yuv);
     fclose(f_pcm);
 
-    printf("? 全部完成! 输出文件: %s\n", OUT_FILENAME);
+    if (failed) {
+        fprintf(stderr, "编码失败，输出文件不完整: %s\n", out_path.c_str());
+        return -1;
+    }
+    printf("? 全部完成! 输出文件: %s\n", out_path.c_str());
     return 0;
 }
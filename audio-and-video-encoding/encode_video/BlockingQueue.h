@@ -0,0 +1,64 @@
+#ifndef BLOCKINGQUEUE_H
+#define BLOCKINGQUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * 有界阻塞队列，用于读取线程 / 编码线程 / 写入线程之间传递帧和包
+ *
+ * push 在队列满时等待；pop 在队列空时等待，close() 之后取完剩余元素返回 false。
+ */
+template <typename T>
+class BlockingQueue {
+public:
+    explicit BlockingQueue(size_t capacity) : capacity_(capacity) {
+    }
+
+    // 队列已关闭时返回 false (元素未放入)
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_not_full_.wait(lock, [&] { return closed_ || items_.size() < capacity_; });
+        if (closed_) return false;
+        items_.push_back(item);
+        cond_not_empty_.notify_one();
+        return true;
+    }
+
+    // 关闭且已取空时返回 false
+    bool pop(T &item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_not_empty_.wait(lock, [&] { return closed_ || !items_.empty(); });
+        if (items_.empty()) return false;
+        item = items_.front();
+        items_.pop_front();
+        cond_not_full_.notify_one();
+        return true;
+    }
+
+    // 不再接收新元素，唤醒所有等待者
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        cond_not_empty_.notify_all();
+        cond_not_full_.notify_all();
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    size_t capacity_;
+    std::deque<T> items_;
+    std::mutex mutex_;
+    std::condition_variable cond_not_empty_;
+    std::condition_variable cond_not_full_;
+    bool closed_ = false;
+};
+
+#endif // BLOCKINGQUEUE_H
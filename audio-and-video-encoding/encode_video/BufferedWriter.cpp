@@ -0,0 +1,54 @@
+#include "BufferedWriter.h"
+
+#include <cstring>
+
+BufferedWriter::BufferedWriter(size_t capacity) : buf_(capacity) {
+}
+
+BufferedWriter::~BufferedWriter() {
+    close();
+}
+
+bool BufferedWriter::open(const char *path) {
+    file_ = fopen(path, "wb");
+    if (!file_) return false;
+    // 缓冲由我们自己管理，关掉 stdio 的缓冲避免二次拷贝
+    setvbuf(file_, nullptr, _IONBF, 0);
+    used_ = 0;
+    bytes_written_ = 0;
+    write_calls_ = 0;
+    return true;
+}
+
+bool BufferedWriter::flush() {
+    if (used_ == 0) return true;
+    write_calls_++;
+    bool ok = fwrite(buf_.data(), 1, used_, file_) == used_;
+    used_ = 0;
+    return ok;
+}
+
+bool BufferedWriter::write(const uint8_t *data, size_t size) {
+    if (!file_) return false;
+    bytes_written_ += size;
+
+    if (used_ + size > buf_.size()) {
+        if (!flush()) return false;
+        if (size >= buf_.size()) {
+            // 比整个缓冲还大，直接写出
+            write_calls_++;
+            return fwrite(data, 1, size, file_) == size;
+        }
+    }
+    memcpy(buf_.data() + used_, data, size);
+    used_ += size;
+    return true;
+}
+
+bool BufferedWriter::close() {
+    if (!file_) return true;
+    bool ok = flush();
+    ok = fclose(file_) == 0 && ok;
+    file_ = nullptr;
+    return ok;
+}
@@ -0,0 +1,42 @@
+#ifndef BUFFEREDWRITER_H
+#define BUFFEREDWRITER_H
+
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+
+/**
+ * 大块缓冲写文件：小包先攒在用户态缓冲里，满了再一次性写出
+ *
+ * 关闭了 stdio 自带的缓冲 (_IONBF)，每次 flush 就是一次大块 write，
+ * 避免每个 NALU 一次 fwrite 带来的系统调用和锁开销。比缓冲还大的数据直接写出。
+ */
+class BufferedWriter {
+public:
+    explicit BufferedWriter(size_t capacity);
+
+    ~BufferedWriter();
+
+    bool open(const char *path);
+
+    bool write(const uint8_t *data, size_t size);
+
+    // 写出剩余数据并关闭文件
+    bool close();
+
+    int64_t bytesWritten() const { return bytes_written_; }
+
+    // 实际调用 fwrite 的次数
+    int64_t writeCalls() const { return write_calls_; }
+
+private:
+    bool flush();
+
+    FILE *file_ = nullptr;
+    std::vector<uint8_t> buf_;
+    size_t used_ = 0;
+    int64_t bytes_written_ = 0;
+    int64_t write_calls_ = 0;
+};
+
+#endif // BUFFEREDWRITER_H
@@ -0,0 +1,74 @@
+#ifndef LATENCYSTATS_H
+#define LATENCYSTATS_H
+
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <cstdio>
+
+/**
+ * 逐帧编码延迟统计 (send_frame -> receive_packet)
+ *
+ * 保存全部样本用来算分位数，另外按固定的毫秒区间画直方图。
+ */
+class LatencyStats {
+public:
+    explicit LatencyStats(size_t expected = 0) {
+        samples_.reserve(expected);
+    }
+
+    void record(double ms) {
+        samples_.push_back(ms);
+    }
+
+    size_t count() const { return samples_.size(); }
+
+    void print(const char *title) const {
+        if (samples_.empty()) {
+            printf("%s: no samples\n", title);
+            return;
+        }
+
+        std::vector<double> sorted = samples_;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0;
+        for (double v : sorted) sum += v;
+
+        printf("%s (%zu frames)\n", title, sorted.size());
+        printf("  avg %.2f  p50 %.2f  p90 %.2f  p99 %.2f  max %.2f  (ms)\n",
+               sum / sorted.size(), percentile(sorted, 0.50), percentile(sorted, 0.90),
+               percentile(sorted, 0.99), sorted.back());
+
+        // 区间上界 (ms)，最后一档是其余全部
+        static const double BOUNDS[] = {1, 2, 5, 10, 20, 50, 100, 200};
+        static const int NUM_BOUNDS = sizeof(BOUNDS) / sizeof(BOUNDS[0]);
+        size_t buckets[NUM_BOUNDS + 1] = {0};
+        for (double v : sorted) {
+            int b = 0;
+            while (b < NUM_BOUNDS && v >= BOUNDS[b]) b++;
+            buckets[b]++;
+        }
+
+        size_t peak = *std::max_element(buckets, buckets + NUM_BOUNDS + 1);
+        for (int b = 0; b <= NUM_BOUNDS; ++b) {
+            char label[32];
+            if (b == 0) snprintf(label, sizeof(label), "< %g", BOUNDS[0]);
+            else if (b == NUM_BOUNDS) snprintf(label, sizeof(label), ">= %g", BOUNDS[NUM_BOUNDS - 1]);
+            else snprintf(label, sizeof(label), "%g - %g", BOUNDS[b - 1], BOUNDS[b]);
+
+            int width = peak ? static_cast<int>(buckets[b] * 40 / peak) : 0;
+            printf("  %10s ms %7zu %5.1f%% %s\n", label, buckets[b],
+                   100.0 * buckets[b] / sorted.size(), std::string(width, '#').c_str());
+        }
+    }
+
+private:
+    static double percentile(const std::vector<double> &sorted, double p) {
+        size_t idx = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(idx, sorted.size() - 1)];
+    }
+
+    std::vector<double> samples_;
+};
+
+#endif // LATENCYSTATS_H
@@ -1,6 +1,19 @@
 #include <iostream>
+#include <iomanip>
 #include <fstream>
 #include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+
+#include "EncoderProfile.h"
+#include "BlockingQueue.h"
+#include "BufferedWriter.h"
+#include "LatencyStats.h"
+#include "SceneDetector.h"
+#include "GopReport.h"
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -13,9 +26,26 @@ extern "C" {
 constexpr int WIDTH = 1920;
 constexpr int HEIGHT = 1080;
 constexpr int FPS = 25;
-const int BITRATE = 400000; // 400kbps
+const int BITRATE = 400000; // 400kbps (默认 profile 的码率，可用 --bitrate 覆盖)
 const char* INPUT_FILE = R"(D:\cxx\audio-and-video-streaming-development\resource\output.yuv)";
 const char* OUTPUT_FILE = "../output.h264";
+const int SWEEP_FRAMES = 250; // sweep 模式下每个 profile 编码的帧数 (10 秒)
+
+// 吞吐模式 (--throughput) 的参数：读取 / 编码 / 写入三个线程流水线，用于压测编码参数
+struct ThroughputOptions {
+    int threads = 0;            // x264 线程数，0 = 自动
+    bool sliced = false;        // true: 切片线程 (一帧切成多片并行)，false: 帧线程 (多帧并行)
+    int lookahead_threads = 0;  // x264 lookahead 线程数，0 = 自动
+    int pool_frames = 16;       // 预读帧池大小
+    int write_buffer_mb = 8;    // 写缓冲大小
+};
+
+// 低延迟模式 (--low-latency) 的参数：交互式推流用，编码器不缓存帧
+struct LowLatencyOptions {
+    int slices = 4;             // 每帧切片数，解码端收到一片就能开始解码
+    int slice_max_size = 0;     // 每片最大字节数 (如 1200 适配 MTU)，0 = 不限制
+    int refresh_period = 0;     // 帧内刷新周期 (帧)，0 = 1 秒
+};
 
 // 辅助函数：将编码后的 Packet 写入文件
 void write_packet(FILE* f, AVPacket* pkt) {
@@ -24,8 +54,9 @@ void write_packet(FILE* f, AVPacket* pkt) {
     }
 }
 
-// 核心编码循环
-void encode(AVCodecContext* enc_ctx, const AVFrame* frame, AVPacket* pkt, FILE* outfile) {
+// 核心编码循环，出错返回 false
+bool encode(AVCodecContext* enc_ctx, const AVFrame* frame, AVPacket* pkt, FILE* outfile,
+            int64_t* out_bytes, bool verbose, GopReport* report = nullptr) {
     int ret;
 
     // 1. 发送原始帧给编码器
@@ -33,7 +64,7 @@ void encode(AVCodecContext* enc_ctx, const AVFrame* frame, AVPacket* pkt, FILE*
     ret = avcodec_send_frame(enc_ctx, frame);
     if (ret < 0) {
         std::cerr << "Error sending a frame for encoding" << std::endl;
-        exit(1);
+        return false;
     }
 
     // 2. 循环接收编码后的数据包
@@ -42,79 +73,141 @@ void encode(AVCodecContext* enc_ctx, const AVFrame* frame, AVPacket* pkt, FILE*
         if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
             // EAGAIN: 需要更多输入帧才能输出 Packet
             // EOF: 编码结束
-            return;
+            return true;
         } else if (ret < 0) {
             std::cerr << "Error during encoding" << std::endl;
-            exit(1);
+            return false;
         }
 
         // 写入文件
-        std::cout << "Write packet: pts=" << pkt->pts << " size=" << pkt->size << std::endl;
+        if (verbose) {
+            std::cout << "Write packet: pts=" << pkt->pts << " size=" << pkt->size << std::endl;
+        }
         write_packet(outfile, pkt);
+        *out_bytes += pkt->size;
+        if (report) report->add(pkt);
 
         // 释放 packet 引用，为下一次使用重置
         av_packet_unref(pkt);
     }
 }
 
-int main() {
-    const AVCodec* codec = nullptr;
-    AVCodecContext* c = nullptr;
-    FILE* f_in = nullptr;
-    FILE* f_out = nullptr;
-    AVFrame* frame = nullptr;
-    AVPacket* pkt = nullptr;
-    int ret;
+// 一次编码的统计结果
+struct EncodeResult {
+    int frames = 0;       // 编码帧数
+    int64_t bytes = 0;    // 输出码流大小
+    double seconds = 0;   // 编码耗时 (不含打开编码器)
+};
 
+// 按 profile 创建并打开 libx264 编码器
+// tp 不为空时按吞吐模式显式配置线程，ll 不为空时按低延迟模式配置，
+// sc 不为空时关键帧完全由场景预分析决定 (关掉 x264 自己的 scenecut)
+AVCodecContext* open_encoder(const EncoderProfile& profile, const ThroughputOptions* tp,
+                             const LowLatencyOptions* ll = nullptr, const SceneCutOptions* sc = nullptr) {
     // 1. 查找 H.264 编码器 (libx264)
-    codec = avcodec_find_encoder_by_name("libx264");
+    const AVCodec* codec = avcodec_find_encoder_by_name("libx264");
     if (!codec) {
         std::cerr << "Codec 'libx264' not found" << std::endl;
-        return 1;
+        return nullptr;
     }
 
     // 2. 分配编码器上下文
-    c = avcodec_alloc_context3(codec);
+    AVCodecContext* c = avcodec_alloc_context3(codec);
     if (!c) {
         std::cerr << "Could not allocate video codec context" << std::endl;
-        return 1;
+        return nullptr;
     }
 
     // 3. 设置编码参数
-    c->bit_rate = BITRATE;
     c->width = WIDTH;
     c->height = HEIGHT;
     // 时间基数 (Timebase) 和 帧率
     c->time_base = (AVRational){1, FPS};
     c->framerate = (AVRational){FPS, 1};
-
-    // 关键帧间隔 (GOP size), 这里设为 10 帧一个 I 帧
-    c->gop_size = 10;
-    c->max_b_frames = 1;
     c->pix_fmt = AV_PIX_FMT_YUV420P;
 
-    //如果是 libx264，通常需要设置 preset (速度/质量权衡)
-    if (codec->id == AV_CODEC_ID_H264) {
-        av_opt_set(c->priv_data, "preset", "slow", 0);
+    // 码控 / preset / tune / GOP / B 帧 / lookahead / 线程数 全部来自 profile
+    apply_profile(c, profile);
+
+    std::string x264_params; // 没有对应 AVOption 的 x264 参数，最后一次性设置
+
+    if (tp) {
+        // x264 只能二选一：帧线程 (吞吐高，每个线程多一帧延迟) 或切片线程 (sliced-threads)
+        if (tp->threads > 0) c->thread_count = tp->threads;
+        c->thread_type = tp->sliced ? FF_THREAD_SLICE : FF_THREAD_FRAME;
+        if (tp->lookahead_threads > 0) {
+            x264_params += "lookahead-threads=" + std::to_string(tp->lookahead_threads) + ":";
+        }
+    }
+
+    if (ll) {
+        // zerolatency: 关 lookahead / sync-lookahead，改用切片线程，编码器不再积压帧
+        av_opt_set(c->priv_data, "tune", "zerolatency", 0);
+        av_opt_set_int(c->priv_data, "rc-lookahead", 0, 0);
+        c->max_b_frames = 0;
+        c->thread_type = FF_THREAD_SLICE;
+
+        // 帧内刷新：一列 intra 宏块在 refresh_period 帧内扫过整个画面，代替周期性 IDR 的码率尖峰
+        av_opt_set_int(c->priv_data, "intra-refresh", 1, 0);
+        c->gop_size = ll->refresh_period > 0 ? ll->refresh_period : FPS;
+
+        c->slices = ll->slices;
+        if (ll->slice_max_size > 0) {
+            x264_params += "slice-max-size=" + std::to_string(ll->slice_max_size) + ":";
+        }
+    }
+
+    if (sc) {
+        // 关键帧由 frame->pict_type = I 强制给出，max_gop 只是兜底
+        c->gop_size = sc->max_gop;
+        c->keyint_min = sc->min_gop;
+        av_opt_set_int(c->priv_data, "forced-idr", 1, 0);
+        x264_params += "scenecut=0:";
+    }
+
+    if (!x264_params.empty()) {
+        x264_params.pop_back(); // 去掉末尾的 ':'
+        av_opt_set(c->priv_data, "x264-params", x264_params.c_str(), 0);
     }
 
     // 4. 打开编码器
-    ret = avcodec_open2(c, codec, nullptr);
-    if (ret < 0) {
+    if (avcodec_open2(c, codec, nullptr) < 0) {
         std::cerr << "Could not open codec" << std::endl;
-        return 1;
+        avcodec_free_context(&c);
+        return nullptr;
     }
+    return c;
+}
+
+// 用指定 profile 把 YUV 文件编码成 H.264 裸流
+// max_frames <= 0 表示编码整个文件
+// sc / keyframes 不为空时按预分析结果强制关键帧，report 不为空时收集 GOP 统计
+bool encode_file(const EncoderProfile& profile, const char* input_file, const char* output_file,
+                 int max_frames, bool verbose, EncodeResult& result,
+                 const SceneCutOptions* sc = nullptr, const std::vector<uint8_t>* keyframes = nullptr,
+                 GopReport* report = nullptr) {
+    FILE* f_in = nullptr;
+    FILE* f_out = nullptr;
+    AVFrame* frame = nullptr;
+    AVPacket* pkt = nullptr;
+    int ret;
+
+    AVCodecContext* c = open_encoder(profile, nullptr, nullptr, sc);
+    if (!c) return false;
 
     // 5. 打开输入输出文件
-    f_in = fopen(INPUT_FILE, "rb");
+    f_in = fopen(input_file, "rb");
     if (!f_in) {
-        std::cerr << "Could not open " << INPUT_FILE << std::endl;
-        return 1;
+        std::cerr << "Could not open " << input_file << std::endl;
+        avcodec_free_context(&c);
+        return false;
     }
-    f_out = fopen(OUTPUT_FILE, "wb");
+    f_out = fopen(output_file, "wb");
     if (!f_out) {
-        std::cerr << "Could not open " << OUTPUT_FILE << std::endl;
-        return 1;
+        std::cerr << "Could not open " << output_file << std::endl;
+        fclose(f_in);
+        avcodec_free_context(&c);
+        return false;
     }
 
     // 6. 分配 Packet 和 Frame
@@ -122,7 +215,12 @@ int main() {
     frame = av_frame_alloc();
     if (!pkt || !frame) {
         std::cerr << "Could not allocate packet or frame" << std::endl;
-        return 1;
+        fclose(f_in);
+        fclose(f_out);
+        av_frame_free(&frame);
+        av_packet_free(&pkt);
+        avcodec_free_context(&c);
+        return false;
     }
 
     frame->format = c->pix_fmt;
@@ -133,17 +231,25 @@ int main() {
     ret = av_frame_get_buffer(frame, 32);
     if (ret < 0) {
         std::cerr << "Could not allocate the video frame data" << std::endl;
-        return 1;
+        fclose(f_in);
+        fclose(f_out);
+        av_frame_free(&frame);
+        av_packet_free(&pkt);
+        avcodec_free_context(&c);
+        return false;
     }
 
     // 计算每帧 YUV 大小 (Y=w*h, U=w/2*h/2, V=w/2*h/2 => Total = w*h*1.5)
     int y_size = c->width * c->height;
     int uv_size = y_size / 4;
     int frame_idx = 0;
+    bool ok = true;
+    result = EncodeResult();
+    auto start = std::chrono::steady_clock::now();
 
     // 7. 循环读取 YUV 数据并编码
     // 注意：这里假设输入文件是紧凑的 YUV420P (无 padding)
-    while (true) {
+    while (max_frames <= 0 || frame_idx < max_frames) {
         // 确保 Frame 数据可写
         ret = av_frame_make_writable(frame);
         if (ret < 0) break;
@@ -155,23 +261,484 @@ int main() {
         // 读取 V 分量
         if (fread(frame->data[2], 1, uv_size, f_in) != static_cast<size_t>(uv_size)) break;
 
+        // 场景切换处强制关键帧，其余帧由编码器自己决定
+        const bool force_key = keyframes && frame_idx < static_cast<int>(keyframes->size()) && (*keyframes)[frame_idx];
+        frame->pict_type = force_key ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
         frame->pts = frame_idx++;
 
         // 编码当前帧
-        encode(c, frame, pkt, f_out);
+        if (!encode(c, frame, pkt, f_out, &result.bytes, verbose, report)) {
+            ok = false;
+            break;
+        }
     }
 
     // 8. 冲刷编码器 (Flush)
     // 发送 NULL 告诉编码器已经没有新数据了，把剩余缓存的帧都输出来
-    encode(c, nullptr, pkt, f_out);
+    if (ok) ok = encode(c, nullptr, pkt, f_out, &result.bytes, verbose, report);
+
+    result.frames = frame_idx;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 
     // 9. 释放资源
-    std::cout << "Encoding finished." << std::endl;
     fclose(f_in);
     fclose(f_out);
     avcodec_free_context(&c);
     av_frame_free(&frame);
     av_packet_free(&pkt);
+    return ok;
+}
 
+// 读入一帧紧凑排列的 YUV420P，frame 的 linesize 带对齐填充时逐行读
+static bool read_yuv_frame(FILE* f, AVFrame* frame) {
+    for (int plane = 0; plane < 3; ++plane) {
+        const int w = plane ? frame->width / 2 : frame->width;
+        const int h = plane ? frame->height / 2 : frame->height;
+        uint8_t* dst = frame->data[plane];
+        if (frame->linesize[plane] == w) {
+            if (fread(dst, 1, static_cast<size_t>(w) * h, f) != static_cast<size_t>(w) * h) return false;
+            continue;
+        }
+        for (int y = 0; y < h; ++y) {
+            if (fread(dst + static_cast<size_t>(y) * frame->linesize[plane], 1, w, f) != static_cast<size_t>(w)) return false;
+        }
+    }
+    return true;
+}
+
+// 取出编码器当前能给的所有包，交给写入线程；返回 false 表示编码出错
+static bool drain_packets(AVCodecContext* c, AVPacket* pkt, BlockingQueue<AVPacket*>& packets, int64_t& bytes) {
+    while (true) {
+        int ret = avcodec_receive_packet(c, pkt);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) return true;
+        if (ret < 0) return false;
+
+        AVPacket* out = av_packet_alloc();
+        if (!out) return false;
+        av_packet_move_ref(out, pkt);
+        bytes += out->size;
+        if (!packets.push(out)) {
+            av_packet_free(&out);
+            return false;
+        }
+    }
+}
+
+// 吞吐模式：读取线程把 YUV 预读进帧池，本线程只管送编码器，写入线程经大缓冲写盘
+// 编码器线程数显式配置，日志只有每秒一行
+bool encode_file_throughput(const EncoderProfile& profile, const ThroughputOptions& tp,
+                            const char* input_file, const char* output_file, EncodeResult& result) {
+    AVCodecContext* c = open_encoder(profile, &tp);
+    if (!c) return false;
+
+    FILE* f_in = fopen(input_file, "rb");
+    if (!f_in) {
+        std::cerr << "Could not open " << input_file << std::endl;
+        avcodec_free_context(&c);
+        return false;
+    }
+    BufferedWriter writer(static_cast<size_t>(tp.write_buffer_mb) << 20);
+    if (!writer.open(output_file)) {
+        std::cerr << "Could not open " << output_file << std::endl;
+        fclose(f_in);
+        avcodec_free_context(&c);
+        return false;
+    }
+
+    // 帧池：空闲帧在 free_frames，读好的帧在 filled，编码器送完再还回 free_frames
+    const int pool_size = tp.pool_frames > 0 ? tp.pool_frames : 1;
+    std::vector<AVFrame*> pool;
+    BlockingQueue<AVFrame*> free_frames(pool_size);
+    BlockingQueue<AVFrame*> filled(pool_size);
+    BlockingQueue<AVPacket*> packets(256);
+    AVPacket* pkt = av_packet_alloc();
+    for (int i = 0; i < pool_size && pkt; ++i) {
+        AVFrame* f = av_frame_alloc();
+        if (!f) break;
+        pool.push_back(f);
+        f->format = c->pix_fmt;
+        f->width = c->width;
+        f->height = c->height;
+        if (av_frame_get_buffer(f, 32) < 0) break;
+        free_frames.push(f);
+    }
+    if (!pkt || static_cast<int>(free_frames.size()) < pool_size) {
+        std::cerr << "Could not allocate the video frame data" << std::endl;
+        for (AVFrame* frame : pool) av_frame_free(&frame);
+        av_packet_free(&pkt);
+        writer.close();
+        fclose(f_in);
+        avcodec_free_context(&c);
+        return false;
+    }
+
+    std::atomic<bool> write_failed(false);
+    std::thread reader([&]() {
+        int64_t idx = 0;
+        AVFrame* f;
+        while (free_frames.pop(f)) {
+            // 编码器可能还持有上一轮的引用，不可写时 make_writable 会换一块新缓冲
+            if (av_frame_make_writable(f) < 0 || !read_yuv_frame(f_in, f)) break;
+            f->pts = idx++;
+            if (!filled.push(f)) break;
+        }
+        filled.close();
+    });
+    std::thread writer_thread([&]() {
+        AVPacket* p;
+        while (packets.pop(p)) {
+            if (!write_failed && !writer.write(p->data, p->size)) write_failed = true;
+            av_packet_free(&p);
+        }
+    });
+
+    result = EncodeResult();
+    auto start = std::chrono::steady_clock::now();
+    auto last_report = start;
+    int last_frames = 0;
+    bool ok = true;
+
+    AVFrame* f;
+    while (filled.pop(f)) {
+        int ret = avcodec_send_frame(c, f);
+        free_frames.push(f);
+        if (ret < 0 || !drain_packets(c, pkt, packets, result.bytes)) {
+            std::cerr << "Error during encoding" << std::endl;
+            ok = false;
+            break;
+        }
+        result.frames++;
+
+        auto now = std::chrono::steady_clock::now();
+        double since = std::chrono::duration<double>(now - last_report).count();
+        if (since >= 1.0) {
+            double total = std::chrono::duration<double>(now - start).count();
+            printf("[throughput] %d frames  %.1f fps (avg %.1f)  %.1f MB  read queue %zu/%d  write queue %zu\n",
+                   result.frames, (result.frames - last_frames) / since, result.frames / total,
+                   result.bytes / (1024.0 * 1024.0), filled.size(), pool_size, packets.size());
+            last_report = now;
+            last_frames = result.frames;
+        }
+    }
+
+    // 停掉读取线程 (出错提前退出时它可能还在等空闲帧)
+    free_frames.close();
+    filled.close();
+    reader.join();
+
+    // 冲刷编码器
+    if (ok && (avcodec_send_frame(c, nullptr) < 0 || !drain_packets(c, pkt, packets, result.bytes))) ok = false;
+    packets.close();
+    writer_thread.join();
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!writer.close() || write_failed) {
+        std::cerr << "Error writing " << output_file << std::endl;
+        ok = false;
+    }
+    printf("[throughput] %lld bytes in %lld writes (%d MB buffer)\n",
+           static_cast<long long>(writer.bytesWritten()), static_cast<long long>(writer.writeCalls()),
+           tp.write_buffer_mb);
+
+    fclose(f_in);
+    for (AVFrame* frame : pool) av_frame_free(&frame);
+    av_packet_free(&pkt);
+    avcodec_free_context(&c);
+    return ok;
+}
+
+// 低延迟模式：逐帧测量 send_frame -> receive_packet 的延迟，以及包晚出来了几帧
+bool encode_file_low_latency(const EncoderProfile& profile, const LowLatencyOptions& ll,
+                             const char* input_file, const char* output_file, EncodeResult& result) {
+    AVCodecContext* c = open_encoder(profile, nullptr, &ll);
+    if (!c) return false;
+
+    FILE* f_in = fopen(input_file, "rb");
+    FILE* f_out = f_in ? fopen(output_file, "wb") : nullptr;
+    AVFrame* frame = av_frame_alloc();
+    AVPacket* pkt = av_packet_alloc();
+    if (!f_in || !f_out || !frame || !pkt) {
+        std::cerr << "Could not open " << (f_in ? output_file : input_file) << std::endl;
+        if (f_in) fclose(f_in);
+        if (f_out) fclose(f_out);
+        av_frame_free(&frame);
+        av_packet_free(&pkt);
+        avcodec_free_context(&c);
+        return false;
+    }
+    frame->format = c->pix_fmt;
+    frame->width = c->width;
+    frame->height = c->height;
+    if (av_frame_get_buffer(frame, 32) < 0) {
+        std::cerr << "Could not allocate the video frame data" << std::endl;
+        fclose(f_in);
+        fclose(f_out);
+        av_frame_free(&frame);
+        av_packet_free(&pkt);
+        avcodec_free_context(&c);
+        return false;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    std::vector<Clock::time_point> send_times; // 下标即 pts
+    LatencyStats latency(1024);
+    int max_delay_frames = 0;  // 包比它的帧晚了多少帧才出来
+    int64_t keyframes = 0;
+    result = EncodeResult();
+    auto start = Clock::now();
+    bool ok = true;
+
+    // frame 为 nullptr 时 flush
+    auto send = [&](AVFrame* in) -> bool {
+        if (avcodec_send_frame(c, in) < 0) return false;
+        while (true) {
+            int ret = avcodec_receive_packet(c, pkt);
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) return true;
+            if (ret < 0) return false;
+
+            if (pkt->pts >= 0 && pkt->pts < static_cast<int64_t>(send_times.size())) {
+                latency.record(std::chrono::duration<double, std::milli>(Clock::now() - send_times[pkt->pts]).count());
+                int delay = static_cast<int>(send_times.size() - 1 - pkt->pts);
+                if (delay > max_delay_frames) max_delay_frames = delay;
+            }
+            if (pkt->flags & AV_PKT_FLAG_KEY) keyframes++;
+            fwrite(pkt->data, 1, pkt->size, f_out);
+            result.bytes += pkt->size;
+            av_packet_unref(pkt);
+        }
+    };
+
+    while (av_frame_make_writable(frame) >= 0 && read_yuv_frame(f_in, frame)) {
+        frame->pts = result.frames++;
+        send_times.push_back(Clock::now());
+        if (!send(frame)) {
+            ok = false;
+            break;
+        }
+    }
+    if (ok && !send(nullptr)) ok = false;
+    if (!ok) std::cerr << "Error during encoding" << std::endl;
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    latency.print("Encode latency send_frame -> receive_packet");
+    printf("  max delay %d frames, %lld keyframes (intra refresh every %d frames, %d slices%s)\n",
+           max_delay_frames, static_cast<long long>(keyframes), c->gop_size, ll.slices,
+           ll.slice_max_size > 0 ? (", max " + std::to_string(ll.slice_max_size) + " bytes/slice").c_str() : "");
+
+    fclose(f_in);
+    fclose(f_out);
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    avcodec_free_context(&c);
+    return ok;
+}
+
+// sweep 模式：同一段输入依次用每个 profile 编码，输出速度/体积对比表
+void run_sweep(const std::vector<EncoderProfile>& profiles, const char* input_file,
+               const std::string& output_prefix, int max_frames) {
+    std::cout << "Sweep: " << profiles.size() << " profiles, " << max_frames << " frames each" << std::endl;
+
+    std::cout << std::string(78, '-') << std::endl;
+    std::cout << std::left << std::setw(20) << "Profile"
+              << std::right << std::setw(8) << "Frames"
+              << std::setw(12) << "Encode FPS"
+              << std::setw(14) << "Size (KB)"
+              << std::setw(14) << "Bitrate(kbps)"
+              << std::setw(10) << "Speed" << std::endl;
+    std::cout << std::string(78, '-') << std::endl;
+
+    for (const auto& profile : profiles) {
+        std::string output = output_prefix + "." + profile.name + ".h264";
+        EncodeResult r;
+        if (!encode_file(profile, input_file, output.c_str(), max_frames, false, r) || r.frames == 0) {
+            std::cout << std::left << std::setw(20) << profile.name << "  FAILED" << std::endl;
+            continue;
+        }
+
+        double fps = r.seconds > 0 ? r.frames / r.seconds : 0;
+        double duration = static_cast<double>(r.frames) / FPS;
+        std::cout << std::left << std::setw(20) << profile.name
+                  << std::right << std::setw(8) << r.frames
+                  << std::setw(12) << std::fixed << std::setprecision(1) << fps
+                  << std::setw(14) << std::setprecision(1) << r.bytes / 1024.0
+                  << std::setw(14) << std::setprecision(1) << r.bytes * 8 / duration / 1000.0
+                  << std::setw(9) << std::setprecision(2) << fps / FPS << "x" << std::endl;
+    }
+    std::cout << std::string(78, '-') << std::endl;
+}
+
+void print_usage(const char* prog) {
+    std::cout << "Usage: " << prog << " [input.yuv] [output.h264] [options]" << std::endl;
+    std::cout << "  --profile <spec>     e.g. rc=crf,crf=23,preset=veryfast,gop=50,bf=0" << std::endl;
+    std::cout << "  --<key> <value>      override one profile key (rc/bitrate/crf/preset/tune/gop/bf/lookahead/threads)" << std::endl;
+    std::cout << "  --sweep              encode the clip under every profile and print a table" << std::endl;
+    std::cout << "  --profiles <file>    profile list for --sweep (one spec per line), default: built-in list" << std::endl;
+    std::cout << "  --frames <n>         frames per profile in --sweep (default " << SWEEP_FRAMES << ")" << std::endl;
+    std::cout << "  --throughput         pipelined reader/encoder/writer threads, one fps line per second" << std::endl;
+    std::cout << "  --frame-threads <n>  x264 frame threads for --throughput (default auto)" << std::endl;
+    std::cout << "  --slice-threads <n>  use n sliced threads instead of frame threads" << std::endl;
+    std::cout << "  --lookahead-threads <n>" << std::endl;
+    std::cout << "  --pool <n>           prefetched frames (default 16)" << std::endl;
+    std::cout << "  --write-buffer <mb>  output buffer size (default 8)" << std::endl;
+    std::cout << "  --low-latency        zerolatency, no B-frames, intra refresh, sliced output; prints a latency histogram" << std::endl;
+    std::cout << "  --slices <n>         slices per frame for --low-latency (default 4)" << std::endl;
+    std::cout << "  --slice-max-size <b> cap slice size in bytes, e.g. 1200" << std::endl;
+    std::cout << "  --refresh <n>        intra refresh period in frames (default " << FPS << ")" << std::endl;
+    std::cout << "  --scene-cut          pre-analyse luma and place keyframes at scene cuts (implies --gop-report)" << std::endl;
+    std::cout << "  --min-gop <n>        minimum keyframe distance for --scene-cut (default " << FPS / 2 << ")" << std::endl;
+    std::cout << "  --max-gop <n>        maximum keyframe distance for --scene-cut (default " << FPS * 2 << ")" << std::endl;
+    std::cout << "  --scene-threshold <x> luma histogram difference 0..1 that counts as a cut (default 0.35)" << std::endl;
+    std::cout << "  --gop-report         print keyframe positions, GOP sizes and bytes per frame type" << std::endl;
+    std::cout << "  --low-latency, --throughput and --scene-cut are mutually exclusive" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    // 默认 profile 与之前写死的参数一致: 400kbps ABR, preset=slow, GOP 10, 1 个 B 帧
+    EncoderProfile profile;
+    profile.bitrate = BITRATE;
+    profile.preset = "slow";
+    profile.gop = 10;
+    profile.b_frames = 1;
+
+    const char* input_file = INPUT_FILE;
+    const char* output_file = OUTPUT_FILE;
+    bool sweep = false;
+    std::string profiles_file;
+    int sweep_frames = SWEEP_FRAMES;
+    bool throughput = false;
+    ThroughputOptions tp;
+    bool low_latency = false;
+    LowLatencyOptions ll;
+    bool preset_given = false;
+    bool scene_cut = false;
+    bool gop_report = false;
+    SceneCutOptions sc;
+    sc.min_gop = FPS / 2;
+    sc.max_gop = FPS * 2; // 默认与 2 秒的切片对齐
+    int positional = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg == "--sweep") {
+            sweep = true;
+        } else if (arg == "--throughput") {
+            throughput = true;
+        } else if (arg == "--low-latency") {
+            low_latency = true;
+        } else if (arg == "--scene-cut") {
+            scene_cut = true;
+        } else if (arg == "--gop-report") {
+            gop_report = true;
+        } else if (arg.compare(0, 2, "--") == 0 && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (arg == "--preset") preset_given = true;
+            if (arg == "--profile") {
+                if (!parse_profile(value, profile)) return 1;
+                preset_given = preset_given || value.find("preset=") != std::string::npos;
+            } else if (arg == "--profiles") {
+                profiles_file = value;
+            } else if (arg == "--frames") {
+                sweep_frames = atoi(value.c_str());
+            } else if (arg == "--frame-threads") {
+                tp.threads = atoi(value.c_str());
+                tp.sliced = false;
+            } else if (arg == "--slice-threads") {
+                tp.threads = atoi(value.c_str());
+                tp.sliced = true;
+            } else if (arg == "--lookahead-threads") {
+                tp.lookahead_threads = atoi(value.c_str());
+            } else if (arg == "--pool") {
+                tp.pool_frames = atoi(value.c_str());
+            } else if (arg == "--write-buffer") {
+                tp.write_buffer_mb = atoi(value.c_str());
+            } else if (arg == "--slices") {
+                ll.slices = atoi(value.c_str());
+            } else if (arg == "--slice-max-size") {
+                ll.slice_max_size = atoi(value.c_str());
+            } else if (arg == "--refresh") {
+                ll.refresh_period = atoi(value.c_str());
+            } else if (arg == "--min-gop") {
+                sc.min_gop = atoi(value.c_str());
+            } else if (arg == "--max-gop") {
+                sc.max_gop = atoi(value.c_str());
+            } else if (arg == "--scene-threshold") {
+                sc.hist_threshold = atof(value.c_str());
+            } else if (!set_profile_option(profile, arg.substr(2), value)) {
+                std::cerr << "Invalid option: " << arg << " " << value << std::endl;
+                return 1;
+            }
+        } else if (positional == 0) {
+            input_file = argv[i];
+            positional++;
+        } else if (positional == 1) {
+            output_file = argv[i];
+            positional++;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (sweep) {
+        std::vector<EncoderProfile> profiles;
+        if (profiles_file.empty()) {
+            profiles = builtin_sweep_profiles(profile);
+        } else if (!load_profiles(profiles_file, profile, profiles)) {
+            return 1;
+        }
+        run_sweep(profiles, input_file, output_file, sweep_frames);
+        return 0;
+    }
+
+    // 三种模式各自有独立的编码循环，不能叠加
+    if (low_latency + throughput + scene_cut > 1) {
+        std::cerr << "--low-latency, --throughput and --scene-cut cannot be combined" << std::endl;
+        return 1;
+    }
+
+    if (low_latency) {
+        // 默认的 preset=slow 单帧耗时太长，没有显式指定时换成 veryfast；B 帧在 open_encoder 里关掉
+        if (!preset_given) profile.preset = "veryfast";
+        profile.b_frames = 0;
+        profile.tune = "zerolatency";
+    }
+
+    std::cout << "Profile " << describe_profile(profile) << std::endl;
+    EncodeResult result;
+    if (low_latency) {
+        if (!encode_file_low_latency(profile, ll, input_file, output_file, result)) {
+            return 1;
+        }
+    } else if (throughput) {
+        if (tp.write_buffer_mb <= 0) tp.write_buffer_mb = 1;
+        std::cout << "Throughput mode: " << (tp.sliced ? "slice" : "frame") << " threads "
+                  << (tp.threads > 0 ? std::to_string(tp.threads) : "auto")
+                  << ", lookahead threads " << (tp.lookahead_threads > 0 ? std::to_string(tp.lookahead_threads) : "auto")
+                  << ", pool " << tp.pool_frames << " frames, write buffer " << tp.write_buffer_mb << " MB" << std::endl;
+        if (!encode_file_throughput(profile, tp, input_file, output_file, result)) {
+            return 1;
+        }
+    } else {
+        std::vector<uint8_t> keyframes;
+        if (scene_cut) {
+            if (sc.min_gop < 1) sc.min_gop = 1;
+            if (sc.max_gop < sc.min_gop) sc.max_gop = sc.min_gop;
+            if (!SceneDetector::analyzeFile(input_file, WIDTH, HEIGHT, sc, keyframes)) return 1;
+        }
+        GopReport report;
+        bool want_report = scene_cut || gop_report;
+        if (!encode_file(profile, input_file, output_file, 0, !want_report, result,
+                         scene_cut ? &sc : nullptr, scene_cut ? &keyframes : nullptr,
+                         want_report ? &report : nullptr)) {
+            return 1;
+        }
+        if (want_report) report.print(FPS);
+    }
+
+    std::cout << "Encoding finished. " << result.frames << " frames, " << result.bytes << " bytes, "
+              << std::fixed << std::setprecision(1) << result.frames / result.seconds << " fps" << std::endl;
     return 0;
-}
\ No newline at end of file
+}
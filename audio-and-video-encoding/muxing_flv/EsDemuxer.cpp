@@ -0,0 +1,280 @@
+#include "EsDemuxer.h"
+
+#include <iostream>
+
+// 第一个 GOP 超过这么多帧也冻结 PTS 偏移，只有一个 IDR 的流不至于整段缓存在内存里
+static const size_t MAX_FIRST_GOP_FRAMES = 300;
+
+// ADTS 采样率索引表
+static const int ADTS_SAMPLE_RATES[16] = {
+    96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050,
+    16000, 12000, 11025, 8000, 7350, 0, 0, 0
+};
+
+// 解析 ADTS 头 (7 字节)，返回该帧的采样率和样本数
+static bool parse_adts(const uint8_t *data, int size, int *sample_rate, int *nb_samples) {
+    if (size < 7) return false;
+    // syncword 0xFFF
+    if (data[0] != 0xFF || (data[1] & 0xF0) != 0xF0) return false;
+
+    int sf_index = (data[2] >> 2) & 0x0F;
+    int raw_blocks = data[6] & 0x03; // number_of_raw_data_blocks_in_frame
+    if (ADTS_SAMPLE_RATES[sf_index] == 0) return false;
+
+    *sample_rate = ADTS_SAMPLE_RATES[sf_index];
+    *nb_samples = (raw_blocks + 1) * 1024;
+    return true;
+}
+
+// 访问单元里是否有 IDR slice (nal_unit_type == 5)，IDR 处 POC 归零
+static bool contains_idr(const uint8_t *data, int size) {
+    for (int i = 0; i + 3 < size; ++i) {
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+            if ((data[i + 3] & 0x1F) == 5) return true;
+            i += 2;
+        }
+    }
+    return false;
+}
+
+EsDemuxer::~EsDemuxer() {
+    for (auto &f : pending_) {
+        av_packet_free(&f.pkt);
+    }
+    av_packet_free(&audio_pkt_);
+    if (parser_) av_parser_close(parser_);
+    avcodec_free_context(&parser_ctx_);
+    avformat_close_input(&fmt_ctx_v_);
+    avformat_close_input(&fmt_ctx_a_);
+}
+
+bool EsDemuxer::open(const char *h264_file, const char *aac_file, double fps) {
+    // --- 打开视频输入 ---
+    if (avformat_open_input(&fmt_ctx_v_, h264_file, nullptr, nullptr) < 0) {
+        std::cerr << "Could not open video file." << std::endl;
+        return false;
+    }
+    if (avformat_find_stream_info(fmt_ctx_v_, nullptr) < 0) return false;
+
+    // --- 打开音频输入 ---
+    if (avformat_open_input(&fmt_ctx_a_, aac_file, nullptr, nullptr) < 0) {
+        std::cerr << "Could not open audio file." << std::endl;
+        return false;
+    }
+    if (avformat_find_stream_info(fmt_ctx_a_, nullptr) < 0) return false;
+
+    video_idx_ = av_find_best_stream(fmt_ctx_v_, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    audio_idx_ = av_find_best_stream(fmt_ctx_a_, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    if (video_idx_ < 0 || audio_idx_ < 0) {
+        std::cerr << "Could not find video/audio stream in input." << std::endl;
+        return false;
+    }
+    in_video_st_ = fmt_ctx_v_->streams[video_idx_];
+    in_audio_st_ = fmt_ctx_a_->streams[audio_idx_];
+
+    // 帧率：外部指定 > 码流探测 (SPS VUI timing) > 25
+    if (fps > 0) {
+        frame_rate_ = av_d2q(fps, 100000);
+    } else if (in_video_st_->r_frame_rate.num > 0 && in_video_st_->r_frame_rate.den > 0) {
+        frame_rate_ = in_video_st_->r_frame_rate;
+    } else if (in_video_st_->avg_frame_rate.num > 0 && in_video_st_->avg_frame_rate.den > 0) {
+        frame_rate_ = in_video_st_->avg_frame_rate;
+    }
+
+    // 重排深度：find_stream_info 时解码器按 SPS (max_num_reorder_frames) 或实际解码结果给出
+    reorder_depth_ = in_video_st_->codecpar->video_delay;
+    initial_reorder_depth_ = reorder_depth_;
+
+    // 再挂一个 h264 parser，每个访问单元都是完整帧，只用它解析 slice header 拿 POC 和帧类型
+    parser_ = av_parser_init(AV_CODEC_ID_H264);
+    parser_ctx_ = avcodec_alloc_context3(nullptr);
+    if (!parser_ || !parser_ctx_) return false;
+    parser_->flags |= PARSER_FLAG_COMPLETE_FRAMES;
+    avcodec_parameters_to_context(parser_ctx_, in_video_st_->codecpar);
+
+    audio_pkt_ = av_packet_alloc();
+    return audio_pkt_ != nullptr;
+}
+
+void EsDemuxer::assignNextDisplay() {
+    VideoFrame *next = nullptr;
+    for (auto &f : pending_) {
+        if (f.display_idx < 0 && (!next || f.poc < next->poc)) next = &f;
+    }
+    if (!next) return;
+
+    next->display_idx = video_display_idx_++;
+    last_display_poc_ = next->poc;
+    unassigned_--;
+
+    // PTS 偏移冻结后定序时就算好，之前的由 freezePtsDelay() 补算
+    if (pts_delay_ >= 0) setVideoPts(*next);
+}
+
+void EsDemuxer::setVideoPts(VideoFrame &f) {
+    // 偏移 D 帧保证 PTS >= DTS
+    AVRational frame_dur = av_inv_q(frame_rate_);
+    f.pkt->pts = av_rescale_q(f.display_idx + pts_delay_, frame_dur, AV_TIME_BASE_Q);
+    if (f.pkt->pts < f.pkt->dts) {
+        // 只有冻结后重排深度又变大才会出现，钳到 DTS 保证封装器不报错
+        f.pkt->pts = f.pkt->dts;
+    }
+}
+
+void EsDemuxer::freezePtsDelay() {
+    pts_delay_ = reorder_depth_;
+    for (auto &f : pending_) {
+        if (f.display_idx >= 0) setVideoPts(f);
+    }
+}
+
+int EsDemuxer::fillVideo() {
+    while (pending_.empty() || pending_.front().display_idx < 0 || pts_delay_ < 0) {
+        if (video_eof_) {
+            if (pending_.empty()) return AVERROR_EOF;
+            // 输入读完：剩下的帧按 POC 顺序全部输出
+            while (unassigned_ > 0) assignNextDisplay();
+            if (pts_delay_ < 0) freezePtsDelay();
+            break;
+        }
+
+        AVPacket *pkt = av_packet_alloc();
+        if (!pkt) return AVERROR(ENOMEM);
+        if (av_read_frame(fmt_ctx_v_, pkt) < 0) {
+            av_packet_free(&pkt);
+            video_eof_ = true;
+            continue;
+        }
+        if (pkt->stream_index != video_idx_) {
+            av_packet_free(&pkt);
+            continue;
+        }
+
+        // 解析 slice header: POC / 帧类型 / 关键帧
+        uint8_t *out_data = nullptr;
+        int out_size = 0;
+        av_parser_parse2(parser_, parser_ctx_, &out_data, &out_size,
+                         pkt->data, pkt->size, AV_NOPTS_VALUE, AV_NOPTS_VALUE, 0);
+
+        VideoFrame f;
+        f.pkt = pkt;
+        f.poc = parser_->output_picture_number;
+        f.decode_idx = video_decode_idx_++;
+
+        int type = parser_->pict_type;
+        frame_types_[(type >= AV_PICTURE_TYPE_I && type <= AV_PICTURE_TYPE_B) ? type : 0]++;
+        if (parser_->key_frame == 1) {
+            pkt->flags |= AV_PKT_FLAG_KEY;
+            keyframes_++;
+        }
+
+        if (contains_idr(pkt->data, pkt->size)) {
+            // POC 从 0 重新开始，上一段剩余的帧全部先定序
+            while (unassigned_ > 0) assignNextDisplay();
+            last_display_poc_ = INT_MIN;
+            // 第二个 IDR 到来说明第一个 GOP 结束
+            if (pts_delay_ < 0 && f.decode_idx > 0) freezePtsDelay();
+        } else if (f.poc < last_display_poc_) {
+            // 比已经定序的帧还要早显示，说明重排深度估小了，之后的帧加大深度
+            reorder_violations_++;
+            reorder_depth_++;
+        }
+
+        AVRational frame_dur = av_inv_q(frame_rate_);
+        pkt->dts = av_rescale_q(f.decode_idx, frame_dur, AV_TIME_BASE_Q);
+        pkt->duration = av_rescale_q(1, frame_dur, AV_TIME_BASE_Q);
+        pkt->stream_index = VIDEO;
+        pkt->pos = -1;
+
+        pending_.push_back(f);
+        unassigned_++;
+
+        // 模拟解码器输出：缓存超过 D 帧时 POC 最小的那帧必然是下一个显示的
+        if (unassigned_ > reorder_depth_) assignNextDisplay();
+        if (pts_delay_ < 0 && pending_.size() >= MAX_FIRST_GOP_FRAMES) freezePtsDelay();
+    }
+    return 0;
+}
+
+int EsDemuxer::fillAudio() {
+    while (!audio_ready_ && !audio_eof_) {
+        if (av_read_frame(fmt_ctx_a_, audio_pkt_) < 0) {
+            audio_eof_ = true;
+            break;
+        }
+        if (audio_pkt_->stream_index != audio_idx_) {
+            av_packet_unref(audio_pkt_);
+            continue;
+        }
+
+        int rate = 0;
+        int nb_samples = 0;
+        if (!parse_adts(audio_pkt_->data, audio_pkt_->size, &rate, &nb_samples)) {
+            // 不是 ADTS (或头损坏)：退回探测到的参数
+            rate = in_audio_st_->codecpar->sample_rate;
+            nb_samples = in_audio_st_->codecpar->frame_size > 0 ? in_audio_st_->codecpar->frame_size : 1024;
+        }
+
+        if (audio_rate_ == 0) {
+            audio_rate_ = rate;
+            // 解码器报告的采样率是 ADTS 的 2 倍 -> SBR (HE-AAC)
+            he_aac_ = in_audio_st_->codecpar->sample_rate > rate;
+        } else if (rate != audio_rate_) {
+            audio_samples_ = av_rescale(audio_samples_, rate, audio_rate_);
+            audio_rate_ = rate;
+        }
+
+        AVRational sample_time_base = {1, audio_rate_};
+        audio_pkt_->pts = av_rescale_q(audio_samples_, sample_time_base, AV_TIME_BASE_Q);
+        audio_pkt_->dts = audio_pkt_->pts;
+        audio_pkt_->duration = av_rescale_q(nb_samples, sample_time_base, AV_TIME_BASE_Q);
+        audio_pkt_->stream_index = AUDIO;
+        audio_pkt_->pos = -1;
+
+        audio_samples_ += nb_samples;
+        audio_frames_++;
+        audio_ready_ = true;
+    }
+    return audio_ready_ ? 0 : AVERROR_EOF;
+}
+
+int EsDemuxer::read(AVPacket *pkt) {
+    int vret = fillVideo();
+    int aret = fillAudio();
+    if (vret < 0 && aret < 0) return AVERROR_EOF;
+
+    // 两路都有包时取 DTS 小的，保证输出单调交错
+    bool take_video = aret < 0 || (vret == 0 && pending_.front().pkt->dts <= audio_pkt_->dts);
+
+    if (take_video) {
+        VideoFrame f = pending_.front();
+        pending_.pop_front();
+        av_packet_move_ref(pkt, f.pkt);
+        av_packet_free(&f.pkt);
+    } else {
+        av_packet_move_ref(pkt, audio_pkt_);
+        audio_ready_ = false;
+    }
+    return 0;
+}
+
+void EsDemuxer::printStats() const {
+    std::cout << "Video: " << video_decode_idx_ << " frames"
+              << " (I=" << frame_types_[AV_PICTURE_TYPE_I]
+              << " P=" << frame_types_[AV_PICTURE_TYPE_P]
+              << " B=" << frame_types_[AV_PICTURE_TYPE_B] << ")"
+              << ", keyframes=" << keyframes_
+              << ", fps=" << frame_rate_.num << "/" << frame_rate_.den
+              << ", reorder depth=" << reorder_depth_ << ", PTS delay=" << pts_delay_ << std::endl;
+    if (reorder_violations_ > 0) {
+        std::cout << "  [!] reorder depth grew from " << initial_reorder_depth_ << " to " << reorder_depth_
+                  << " (" << reorder_violations_ << " frames displayed out of order)" << std::endl;
+    }
+
+    std::cout << "Audio: " << audio_frames_ << " frames, " << audio_samples_ << " samples @ " << audio_rate_ << "Hz"
+              << (he_aac_ ? " (HE-AAC/SBR, output rate doubled)" : "");
+    if (audio_rate_ > 0) {
+        std::cout << ", duration=" << static_cast<double>(audio_samples_) / audio_rate_ << "s";
+    }
+    std::cout << std::endl;
+}
@@ -0,0 +1,116 @@
+#ifndef ESDEMUXER_H
+#define ESDEMUXER_H
+
+#include <climits>
+#include <deque>
+#include <string>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+/**
+ * H.264 + AAC 裸流读取器：从码流本身恢复时间戳
+ *
+ * 裸流 (.h264 / .aac) 没有可靠的时间戳，本类负责生成可以直接送给封装器的 DTS/PTS：
+ *
+ * 视频: 每个访问单元再过一遍 h264 parser，拿到 pict_type / key_frame / POC。
+ *       按解码顺序编号得到 DTS；用 "重排深度 D" 模拟解码器的输出 (bumping) 过程——
+ *       待输出的帧超过 D 个时，POC 最小的那个得到下一个显示序号——得到 PTS。
+ *       PTS = (显示序号 + D) * 帧时长，保证 PTS >= DTS，CTS = PTS - DTS 即 B 帧的合成时间偏移。
+ *       IDR 处 POC 归零，先把上一段剩余的帧按 POC 顺序全部输出。
+ *       第一个 GOP 读完之前不输出视频包，PTS 里的 D 取第一个 GOP 结束时的深度并就此冻结，
+ *       之后深度再变大只影响输出顺序，不会让已经连续的 PTS 整体前后跳。
+ *
+ * 音频: 逐帧解析 ADTS 头，按 (raw_data_blocks + 1) * 1024 个样本、ADTS 头里的采样率累加时长。
+ *       HE-AAC 的 ADTS 采样率是核心采样率，这样算出的时长与解码后的 2048 样本 @ 2 倍采样率一致。
+ *
+ * read() 按 DTS 交错返回两路包，时间戳单位统一为 AV_TIME_BASE (微秒)，
+ * stream_index: 0 = 视频, 1 = 音频，由调用方换算到各自输出流的 time_base。
+ */
+class EsDemuxer {
+public:
+    static const int VIDEO = 0;
+    static const int AUDIO = 1;
+
+    EsDemuxer() = default;
+
+    ~EsDemuxer();
+
+    // 打开两个输入。fps <= 0 时使用码流里的帧率 (SPS VUI / 探测结果)，都没有则按 25
+    bool open(const char *h264_file, const char *aac_file, double fps = 0);
+
+    // 输入流参数，用于创建输出流
+    const AVCodecParameters *videoParams() const { return in_video_st_->codecpar; }
+    const AVCodecParameters *audioParams() const { return in_audio_st_->codecpar; }
+
+    // 取下一个包 (引用转移到 pkt)，返回 0 成功，AVERROR_EOF 两路都读完
+    int read(AVPacket *pkt);
+
+    // 打印帧类型、重排深度、音频样本数等统计
+    void printStats() const;
+
+    int64_t videoFrames() const { return video_decode_idx_; }
+    int64_t audioFrames() const { return audio_frames_; }
+
+private:
+    struct VideoFrame {
+        AVPacket *pkt = nullptr;
+        int poc = 0;
+        int64_t decode_idx = 0;
+        int64_t display_idx = -1; // -1 表示还没确定显示顺序
+    };
+
+    // 从视频输入读到 pending_ 队头的帧可以输出 (已定显示序号且 PTS 偏移已冻结) 为止
+    int fillVideo();
+
+    // 从音频输入读下一个包到 audio_pkt_，并计算时间戳
+    int fillAudio();
+
+    // 把 POC 最小的待定帧定为下一个显示序号
+    void assignNextDisplay();
+
+    // 按冻结的 PTS 偏移计算已定序帧的 PTS (微秒)
+    void setVideoPts(VideoFrame &f);
+
+    // 第一个 GOP 结束：冻结 PTS 偏移，补算已经定序的帧的 PTS
+    void freezePtsDelay();
+
+    AVFormatContext *fmt_ctx_v_ = nullptr;
+    AVFormatContext *fmt_ctx_a_ = nullptr;
+    AVStream *in_video_st_ = nullptr;
+    AVStream *in_audio_st_ = nullptr;
+    int video_idx_ = -1;
+    int audio_idx_ = -1;
+
+    // 视频时间戳恢复
+    AVCodecParserContext *parser_ = nullptr;
+    AVCodecContext *parser_ctx_ = nullptr;
+    AVRational frame_rate_{25, 1};
+    int reorder_depth_ = 0;           // 模拟解码器输出用的重排深度，发现不足时加大
+    int pts_delay_ = -1;              // PTS 偏移 (帧)，第一个 GOP 结束时冻结，-1 表示还没冻结
+    std::deque<VideoFrame> pending_;  // 解码顺序的待输出帧
+    int unassigned_ = 0;              // pending_ 中还没定显示序号的帧数
+    int last_display_poc_ = INT_MIN;  // 当前 POC 周期内最后定序的 POC，用于检测重排深度不足
+    bool video_eof_ = false;
+    int64_t video_decode_idx_ = 0;
+    int64_t video_display_idx_ = 0;
+
+    // 音频时间戳恢复
+    AVPacket *audio_pkt_ = nullptr;
+    bool audio_ready_ = false;
+    bool audio_eof_ = false;
+    int audio_rate_ = 0;              // ADTS 头里的采样率
+    int64_t audio_samples_ = 0;       // 已累计的样本数 (audio_rate_ 为单位)
+    int64_t audio_frames_ = 0;
+
+    // 统计
+    int64_t frame_types_[4] = {0, 0, 0, 0}; // 未知 / I / P / B
+    int64_t keyframes_ = 0;
+    int reorder_violations_ = 0;
+    int initial_reorder_depth_ = 0;
+    bool he_aac_ = false;
+};
+
+#endif // ESDEMUXER_H
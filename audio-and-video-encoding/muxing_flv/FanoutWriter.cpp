@@ -0,0 +1,158 @@
+#include "FanoutWriter.h"
+#include "EsDemuxer.h"
+
+#include <cstdio>
+
+extern "C" {
+#include <libavutil/time.h>
+}
+
+// 音频包小、丢了会直接听到断音，比视频多留一倍余量；再满说明这一路已经卡死，音频也丢
+static const size_t AUDIO_QUEUE_FACTOR = 2;
+
+FanoutWriter::FanoutWriter(size_t max_queue) : max_queue_(max_queue) {
+}
+
+FanoutWriter::~FanoutWriter() {
+    for (auto &out : outputs_) {
+        if (out->thread.joinable()) out->thread.join();
+        for (AVPacket *pkt : out->queue) {
+            av_packet_free(&pkt);
+        }
+    }
+}
+
+void FanoutWriter::addOutput(const std::string &name, AVFormatContext *fmt_ctx, AVStream *out_streams[2]) {
+    std::unique_ptr<Output> out(new Output());
+    out->name = name;
+    out->fmt_ctx = fmt_ctx;
+    out->streams[0] = out_streams[0];
+    out->streams[1] = out_streams[1];
+    outputs_.push_back(std::move(out));
+}
+
+void FanoutWriter::dispatch(Output &out, const AVPacket *pkt) {
+    bool is_video = pkt->stream_index == EsDemuxer::VIDEO;
+    bool is_key = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
+
+    std::lock_guard<std::mutex> lock(out.mutex);
+    if (out.failed) return;
+
+    if (is_video && out.waiting_key) {
+        if (!is_key) {
+            out.dropped++;
+            return;
+        }
+        out.waiting_key = false;
+    }
+
+    // 这一路跟不上：只对这一路丢包，读线程不等它，其他输出不受影响
+    if (is_video && out.queue.size() >= max_queue_) {
+        // 视频丢到下一个关键帧为止，避免解码花屏
+        out.dropped++;
+        out.waiting_key = true;
+        return;
+    }
+    if (!is_video && out.queue.size() >= max_queue_ * AUDIO_QUEUE_FACTOR) {
+        out.dropped++;
+        out.dropped_audio++;
+        return;
+    }
+
+    AVPacket *ref = av_packet_alloc();
+    if (!ref || av_packet_ref(ref, pkt) < 0) {
+        av_packet_free(&ref);
+        out.dropped++;
+        return;
+    }
+    out.queue.push_back(ref);
+    if (out.queue.size() > out.max_depth) out.max_depth = out.queue.size();
+    out.cond.notify_one();
+}
+
+void FanoutWriter::writerLoop(Output *out) {
+    while (true) {
+        AVPacket *pkt = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(out->mutex);
+            out->cond.wait(lock, [&] { return out->finished || !out->queue.empty(); });
+            if (out->queue.empty()) return;
+            pkt = out->queue.front();
+            out->queue.pop_front();
+        }
+
+        // 每路输出拿到的是自己的引用，时间戳可以各自换算
+        AVStream *out_st = out->streams[pkt->stream_index];
+        av_packet_rescale_ts(pkt, AV_TIME_BASE_Q, out_st->time_base);
+        pkt->stream_index = out_st->index;
+        int size = pkt->size;
+
+        int ret = av_interleaved_write_frame(out->fmt_ctx, pkt);
+        av_packet_free(&pkt);
+
+        std::lock_guard<std::mutex> lock(out->mutex);
+        if (ret < 0) {
+            char err_buf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(ret, err_buf, sizeof(err_buf));
+            fprintf(stderr, "[fanout] %s 写入失败，停止该路输出: %s\n", out->name.c_str(), err_buf);
+            out->failed = true;
+            for (AVPacket *p : out->queue) {
+                av_packet_free(&p);
+            }
+            out->queue.clear();
+            return;
+        }
+        out->sent_packets++;
+        out->sent_bytes += size;
+    }
+}
+
+int FanoutWriter::run(EsDemuxer &demuxer, bool paced) {
+    for (auto &out : outputs_) {
+        out->thread = std::thread(&FanoutWriter::writerLoop, this, out.get());
+    }
+
+    AVPacket *pkt = av_packet_alloc();
+    int64_t start = av_gettime_relative();
+    int64_t first_dts = AV_NOPTS_VALUE;
+
+    while (demuxer.read(pkt) >= 0) {
+        if (paced) {
+            if (first_dts == AV_NOPTS_VALUE) first_dts = pkt->dts;
+            int64_t wait = start + (pkt->dts - first_dts) - av_gettime_relative();
+            if (wait > 0) av_usleep(static_cast<unsigned>(wait));
+        }
+
+        for (auto &out : outputs_) {
+            dispatch(*out, pkt);
+        }
+        av_packet_unref(pkt);
+    }
+    av_packet_free(&pkt);
+
+    int ok = 0;
+    for (auto &out : outputs_) {
+        {
+            std::lock_guard<std::mutex> lock(out->mutex);
+            out->finished = true;
+            out->cond.notify_one();
+        }
+        out->thread.join();
+        if (!out->failed) ok++;
+    }
+    return ok;
+}
+
+void FanoutWriter::printStats() const {
+    printf("%-40s %10s %10s %10s %8s %8s  %s\n", "Output", "Packets", "MB", "Dropped", "(audio)", "MaxQ", "Status");
+    for (const auto &out : outputs_) {
+        printf("%-40s %10lld %10.2f %10lld %8lld %8zu  %s\n",
+               out->name.c_str(),
+               static_cast<long long>(out->sent_packets),
+               out->sent_bytes / (1024.0 * 1024.0),
+               static_cast<long long>(out->dropped),
+               static_cast<long long>(out->dropped_audio),
+               out->max_depth,
+               out->failed ? "FAILED" : "OK");
+    }
+}
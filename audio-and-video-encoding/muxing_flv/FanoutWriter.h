@@ -0,0 +1,74 @@
+#ifndef FANOUTWRITER_H
+#define FANOUTWRITER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+class EsDemuxer;
+
+/**
+ * 一次读取，多路输出 (中继节点把一路源复制到多个目的地)
+ *
+ * 输入只解析一遍，每个包对每路输出 av_packet_ref 一份 (只加引用计数，不拷贝数据)，
+ * 放进该输出自己的有界队列，由该输出独立的写线程调用 av_interleaved_write_frame。
+ *
+ * 读线程永远不会因为某一路阻塞：某路队列满了就只对这一路丢包，其他输出照常写。
+ * 视频丢到下一个关键帧为止；音频可以多排一倍 (丢音频会直接断音)，超过硬上限也丢，
+ * 卡死的输出占用的内存有上限。某路写失败后只停掉这一路。
+ */
+class FanoutWriter {
+public:
+    explicit FanoutWriter(size_t max_queue);
+
+    ~FanoutWriter();
+
+    // 添加一路已经写过文件头的输出，out_streams 下标与 EsDemuxer::VIDEO / AUDIO 对应
+    void addOutput(const std::string &name, AVFormatContext *fmt_ctx, AVStream *out_streams[2]);
+
+    // 读完输入并等所有写线程结束。paced 为 true 时按 DTS 对齐墙上时钟读取
+    // 返回成功完成的输出路数
+    int run(EsDemuxer &demuxer, bool paced);
+
+    // 打印每路输出的发送/丢包统计
+    void printStats() const;
+
+private:
+    struct Output {
+        std::string name;
+        AVFormatContext *fmt_ctx = nullptr;
+        AVStream *streams[2] = {nullptr, nullptr};
+
+        std::deque<AVPacket *> queue;
+        std::mutex mutex;
+        std::condition_variable cond;
+        bool finished = false;
+        bool failed = false;
+        bool waiting_key = false;
+
+        int64_t sent_packets = 0;
+        int64_t sent_bytes = 0;
+        int64_t dropped = 0;
+        int64_t dropped_audio = 0;   // dropped 中的音频包
+        size_t max_depth = 0;
+        std::thread thread;
+    };
+
+    // 把一个包分发给某一路输出 (引用计数 +1)，队列满时按丢帧策略丢弃
+    void dispatch(Output &out, const AVPacket *pkt);
+
+    void writerLoop(Output *out);
+
+    std::vector<std::unique_ptr<Output>> outputs_;
+    size_t max_queue_;
+};
+
+#endif // FANOUTWRITER_H
@@ -0,0 +1,160 @@
+#include "LiveSender.h"
+#include "EsDemuxer.h"
+
+#include <cstdio>
+#include <thread>
+
+extern "C" {
+#include <libavutil/time.h>
+}
+
+LiveSender::LiveSender(AVFormatContext *out_fmt_ctx, AVStream *out_streams[2], size_t max_queue)
+    : out_fmt_ctx_(out_fmt_ctx), max_queue_(max_queue) {
+    out_streams_[0] = out_streams[0];
+    out_streams_[1] = out_streams[1];
+}
+
+LiveSender::~LiveSender() {
+    for (AVPacket *pkt : queue_) {
+        av_packet_free(&pkt);
+    }
+}
+
+bool LiveSender::enqueue(AVPacket *pkt) {
+    bool is_video = pkt->stream_index == EsDemuxer::VIDEO;
+    bool is_key = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (failed_) return false;
+
+    if (is_video && waiting_key_) {
+        if (!is_key) {
+            dropped_frames_++;
+            av_packet_unref(pkt);
+            return true;
+        }
+        waiting_key_ = false;
+    }
+
+    if (queue_.size() >= max_queue_) {
+        if (is_video && !is_key) {
+            // 背压：丢掉这一帧，直到下一个关键帧前的视频都不再发送
+            dropped_frames_++;
+            waiting_key_ = true;
+            av_packet_unref(pkt);
+            return true;
+        }
+        cond_not_full_.wait(lock, [&] { return failed_ || queue_.size() < max_queue_; });
+        if (failed_) return false;
+    }
+
+    AVPacket *node = av_packet_alloc();
+    if (!node) return false;
+    av_packet_move_ref(node, pkt);
+    queue_.push_back(node);
+    if (queue_.size() > max_depth_) max_depth_ = queue_.size();
+    cond_not_empty_.notify_one();
+    return true;
+}
+
+void LiveSender::senderLoop() {
+    while (true) {
+        AVPacket *pkt = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_not_empty_.wait(lock, [&] { return finished_ || !queue_.empty(); });
+            if (queue_.empty()) return; // finished_ 且已发完
+            pkt = queue_.front();
+            queue_.pop_front();
+            cond_not_full_.notify_one();
+        }
+
+        AVStream *out_st = out_streams_[pkt->stream_index];
+        av_packet_rescale_ts(pkt, AV_TIME_BASE_Q, out_st->time_base);
+        pkt->stream_index = out_st->index;
+        int size = pkt->size;
+
+        int ret = av_interleaved_write_frame(out_fmt_ctx_, pkt);
+        av_packet_free(&pkt);
+        if (ret < 0) {
+            char err_buf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(ret, err_buf, sizeof(err_buf));
+            fprintf(stderr, "\n[live] 发送失败: %s\n", err_buf);
+            std::lock_guard<std::mutex> lock(mutex_);
+            failed_ = true;
+            cond_not_full_.notify_all();
+            return;
+        }
+        sent_bytes_ += size;
+        sent_packets_++;
+    }
+}
+
+void LiveSender::printStats(int64_t elapsed_us, int64_t lag_us, bool final) {
+    int64_t bytes = sent_bytes_;
+    int64_t packets = sent_packets_;
+    size_t depth;
+    int64_t dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        depth = queue_.size();
+        dropped = dropped_frames_;
+    }
+
+    if (final) {
+        double seconds = elapsed_us / 1000000.0;
+        printf("\n[live] 推流结束: %.1fs, %lld 包, %.1f kbps 平均, 丢帧 %lld, 队列最大深度 %zu/%zu\n",
+               seconds, static_cast<long long>(packets),
+               seconds > 0 ? bytes * 8 / seconds / 1000.0 : 0.0,
+               static_cast<long long>(dropped), max_depth_, max_queue_);
+        return;
+    }
+
+    double interval = (elapsed_us - last_report_us_) / 1000000.0;
+    printf("[live] t=%.1fs send=%.1fkbps %.0fpkt/s queue=%zu/%zu dropped=%lld lag=%lldms\n",
+           elapsed_us / 1000000.0,
+           (bytes - last_bytes_) * 8 / interval / 1000.0,
+           (packets - last_packets_) / interval,
+           depth, max_queue_, static_cast<long long>(dropped), static_cast<long long>(lag_us / 1000));
+    last_bytes_ = bytes;
+    last_packets_ = packets;
+    last_report_us_ = elapsed_us;
+}
+
+int LiveSender::run(EsDemuxer &demuxer) {
+    std::thread sender(&LiveSender::senderLoop, this);
+
+    AVPacket *pkt = av_packet_alloc();
+    int64_t start = av_gettime_relative();
+    int64_t first_dts = AV_NOPTS_VALUE;
+    int64_t lag_us = 0;
+
+    while (demuxer.read(pkt) >= 0) {
+        // 节拍：DTS (微秒) 对齐墙上时钟，没到点就睡
+        if (first_dts == AV_NOPTS_VALUE) first_dts = pkt->dts;
+        int64_t due = start + (pkt->dts - first_dts);
+        int64_t now = av_gettime_relative();
+        if (due > now) {
+            av_usleep(static_cast<unsigned>(due - now));
+            now = av_gettime_relative();
+        }
+        lag_us = now - due;
+
+        if (!enqueue(pkt)) break;
+
+        if (now - start - last_report_us_ >= 1000000) {
+            printStats(now - start, lag_us, false);
+        }
+    }
+    av_packet_free(&pkt);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = true;
+        cond_not_empty_.notify_one();
+    }
+    sender.join();
+
+    printStats(av_gettime_relative() - start, lag_us, true);
+    return failed_ ? -1 : 0;
+}
@@ -0,0 +1,68 @@
+#ifndef LIVESENDER_H
+#define LIVESENDER_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+class EsDemuxer;
+
+/**
+ * 实时推流：按 DTS 对齐墙上时钟把包送给封装器 (tcp:// / unix:// / rtmp:// 等任意 avio 输出)
+ *
+ * 读取线程 (run 的调用者) 负责节拍：包的 DTS 到点了才放入发送队列；
+ * 发送线程从队列取包调用 av_interleaved_write_frame，网络慢时阻塞在这里。
+ *
+ * 发送队列有界，满了说明下游跟不上 (背压)：
+ *  - 非关键帧视频直接丢弃，并且一直丢到下一个关键帧 (P 帧依赖前面的帧，丢一个后面都花)
+ *  - 关键帧和音频等待队列腾出空间
+ *
+ * 每秒打印一次发送码率、队列深度、丢帧数和发送延迟 (墙上时钟 - DTS)。
+ */
+class LiveSender {
+public:
+    // out_streams: 下标与 EsDemuxer::VIDEO / AUDIO 对应的输出流
+    LiveSender(AVFormatContext *out_fmt_ctx, AVStream *out_streams[2], size_t max_queue);
+
+    ~LiveSender();
+
+    // 推流直到输入读完 (或发送出错)，返回 0 成功
+    int run(EsDemuxer &demuxer);
+
+private:
+    // 放入发送队列，按丢帧策略可能直接丢弃；返回 false 表示发送线程已出错退出
+    bool enqueue(AVPacket *pkt);
+
+    // 发送线程
+    void senderLoop();
+
+    void printStats(int64_t elapsed_us, int64_t lag_us, bool final);
+
+    AVFormatContext *out_fmt_ctx_;
+    AVStream *out_streams_[2];
+    size_t max_queue_;
+
+    std::deque<AVPacket *> queue_;
+    std::mutex mutex_;
+    std::condition_variable cond_not_full_;
+    std::condition_variable cond_not_empty_;
+    bool finished_ = false;    // 输入已读完
+    bool failed_ = false;      // 发送出错
+    bool waiting_key_ = false; // 丢过非关键帧，等下一个关键帧
+
+    // 统计
+    std::atomic<int64_t> sent_bytes_{0};
+    std::atomic<int64_t> sent_packets_{0};
+    int64_t dropped_frames_ = 0;
+    size_t max_depth_ = 0;
+    int64_t last_bytes_ = 0;
+    int64_t last_packets_ = 0;
+    int64_t last_report_us_ = 0;
+};
+
+#endif // LIVESENDER_H
@@ -0,0 +1,43 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * ֻڴӳļ
+ *
+ * Windows  CreateFileMapping / MapViewOfFileƽ̨ mmap
+ * ļӳһڴ棬߳̿ͬʱͬ򣬲Ҫ fopen/fseek
+ * 32 λĵַռŲ¼ GB ļ open() ʧܡ
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const char *path);
+
+    void close();
+
+    const uint8_t *data() const { return data_; }
+
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void *file_ = nullptr;    // HANDLE
+    void *mapping_ = nullptr; // HANDLE
+#else
+    int fd_ = -1;
+#endif
+};
+
+#endif // MAPPEDFILE_H
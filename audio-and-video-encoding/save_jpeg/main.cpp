@@ -1,10 +1,21 @@
 /**
  * YUV ת JPEG 
  * ܣ YUV ļȡָһ֡Ϊ JPEG
+ *      ģʽÿ N ֡һ JPEG MJPEG  (Ԥѩͼ)
  */
 
 #include <iostream>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include "MappedFile.h"
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -21,7 +32,7 @@ const int HEIGHT = 720;
 const int EXTRACT_FRAME_INDEX = 50; // ȡ 50 ֡
 // ===========================================
 
-int main() {
+int save_single_frame() {
     // 1.  YUV ļ
     FILE *f_yuv = fopen(IN_YUV_FILE, "rb");
     if (!f_yuv) {
@@ -121,3 +132,303 @@ int main() {
 
     return 0;
 }
+
+// =================  =================
+
+struct BatchOptions {
+    int width = WIDTH;
+    int height = HEIGHT;
+    int every = 25;        // ÿ֡һ
+    int start = 0;         // һŵ֡
+    int max_images = 0;    // ർţ0 ʾ
+    int threads = 0;       // 0 ʾ CPU 
+    int slice_threads = 1; // ÿڲ߳
+    int quality = 4;       // MJPEG  qscale2 ã31 
+    bool psnr = false;     // ͳÿͼ PSNR (Ҫ)
+};
+
+// ÿͼĽɸ߳дҪ
+struct ImageResult {
+    int frame_index = 0;
+    int bytes = 0;
+    double psnr_y = -1;
+    bool ok = false;
+};
+
+AVCodecContext *open_mjpeg_encoder(const BatchOptions &opt) {
+    const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+    if (!codec) {
+        printf("Ҳ MJPEG \n");
+        return nullptr;
+    }
+
+    AVCodecContext *c = avcodec_alloc_context3(codec);
+    if (!c) return nullptr;
+
+    c->width = opt.width;
+    c->height = opt.height;
+    c->time_base = (AVRational){1, 25};
+    c->framerate = (AVRational){25, 1};
+    c->pix_fmt = AV_PIX_FMT_YUVJ420P;
+
+    // ̶ qscale ʣÿͼһ£Сݱ仯
+    c->flags |= AV_CODEC_FLAG_QSCALE;
+    c->global_quality = FF_QP2LAMBDA * opt.quality;
+    if (opt.psnr) c->flags |= AV_CODEC_FLAG_PSNR;
+
+    // һ֡ڲָٰ߳
+    c->thread_count = opt.slice_threads;
+    c->thread_type = FF_THREAD_SLICE;
+
+    if (avcodec_open2(c, codec, NULL) < 0) {
+        printf("޷򿪱\n");
+        avcodec_free_context(&c);
+        return nullptr;
+    }
+    return c;
+}
+
+// ӳڴ MappedFile AVBuffer ͷʱʲô
+static void noop_free(void *, uint8_t *) {
+}
+
+//  AV_PKT_DATA_QUALITY_STATS ȡ Y ƽ PSNR
+// ֣quality(4) pict_type(1) error_count(1) reserved(2) error[i](8, С)
+double packet_psnr_y(const AVPacket *pkt, int width, int height) {
+    size_t size = 0;
+    const uint8_t *sd = av_packet_get_side_data(pkt, AV_PKT_DATA_QUALITY_STATS, &size);
+    if (!sd || size < 16 || sd[5] < 1) return -1;
+
+    uint64_t error = 0;
+    for (int i = 7; i >= 0; --i) error = (error << 8) | sd[8 + i];
+    if (error == 0) return 99.0;
+    return 10.0 * log10(255.0 * 255.0 * width * height / error);
+}
+
+// һ̣߳Լı frames[begin, end)
+void jpeg_worker(const MappedFile &input, const BatchOptions &opt, const char *pattern,
+                 const std::vector<int> &frames, size_t begin, size_t end, std::vector<ImageResult> &results) {
+    AVCodecContext *c = open_mjpeg_encoder(opt);
+    AVFrame *frame = av_frame_alloc();
+    AVPacket *pkt = av_packet_alloc();
+    if (!c || !frame || !pkt) {
+        // ֡ϣʧܵͼƬܶӦ֡
+        for (size_t i = begin; i < end; ++i) results[i].frame_index = frames[i];
+        avcodec_free_context(&c);
+        av_frame_free(&frame);
+        av_packet_free(&pkt);
+        return;
+    }
+
+    const int frame_size = av_image_get_buffer_size(c->pix_fmt, opt.width, opt.height, 1);
+    char path[1024];
+
+    for (size_t i = begin; i < end; ++i) {
+        ImageResult &r = results[i];
+        r.frame_index = frames[i];
+
+        // ֱӳڴ棬 AVFrame ԼĻ
+        const uint8_t *src = input.data() + static_cast<size_t>(frames[i]) * frame_size;
+        av_frame_unref(frame);
+        frame->format = c->pix_fmt;
+        frame->width = opt.width;
+        frame->height = opt.height;
+        frame->quality = c->global_quality;
+        frame->pts = frames[i];
+        frame->buf[0] = av_buffer_create(const_cast<uint8_t *>(src), frame_size, noop_free, nullptr,
+                                         AV_BUFFER_FLAG_READONLY);
+        if (!frame->buf[0]) break;
+        av_image_fill_arrays(frame->data, frame->linesize, src, c->pix_fmt, opt.width, opt.height, 1);
+
+        int ret = avcodec_send_frame(c, frame);
+        if (ret < 0) {
+            printf(" %d ֡ʧ: %s\n", frames[i], av_err2str(ret));
+            continue;
+        }
+        ret = avcodec_receive_packet(c, pkt);
+        if (ret < 0) {
+            printf(" %d ֡ʧ: %s\n", frames[i], av_err2str(ret));
+            continue;
+        }
+
+        if (av_get_frame_filename2(path, sizeof(path), pattern, frames[i], 0) < 0) {
+            printf(" %d ֡·ʧ: %s\n", frames[i], pattern);
+            av_packet_unref(pkt);
+            continue;
+        }
+        FILE *f_jpg = fopen(path, "wb");
+        if (f_jpg) {
+            r.ok = fwrite(pkt->data, 1, pkt->size, f_jpg) == static_cast<size_t>(pkt->size);
+            r.ok = fclose(f_jpg) == 0 && r.ok;
+        }
+        if (!r.ok) printf("޷д %s\n", path);
+        r.bytes = pkt->size;
+        if (opt.psnr) r.psnr_y = packet_psnr_y(pkt, opt.width, opt.height);
+        av_packet_unref(pkt);
+    }
+
+    avcodec_free_context(&c);
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+}
+
+void print_summary(const BatchOptions &opt, const std::vector<ImageResult> &results, double seconds) {
+    int ok = 0;
+    int64_t total = 0;
+    const ImageResult *smallest = nullptr;
+    const ImageResult *largest = nullptr;
+    double psnr_sum = 0;
+    double psnr_min = 0;
+    int psnr_count = 0;
+    for (const ImageResult &r : results) {
+        if (!r.ok) continue;
+        ok++;
+        total += r.bytes;
+        if (!smallest || r.bytes < smallest->bytes) smallest = &r;
+        if (!largest || r.bytes > largest->bytes) largest = &r;
+        if (r.psnr_y >= 0) {
+            if (psnr_count == 0 || r.psnr_y < psnr_min) psnr_min = r.psnr_y;
+            psnr_sum += r.psnr_y;
+            psnr_count++;
+        }
+    }
+
+    const double raw = opt.width * opt.height * 1.5;
+    printf("---------------- JPEG ͳ ----------------\n");
+    printf("ͼƬ: %d / %zu , ʱ %.2fs (%.1f /)\n", ok, results.size(), seconds,
+           seconds > 0 ? ok / seconds : 0.0);
+    if (ok == 0) return;
+
+    const double avg = static_cast<double>(total) / ok;
+    printf(": qscale %d, %dx%d\n", opt.quality, opt.width, opt.height);
+    printf("С:  %.2f MB, ƽ %.1f KB, С %.1f KB ( %d ֡),  %.1f KB ( %d ֡)\n",
+           total / 1048576.0, avg / 1024.0, smallest->bytes / 1024.0, smallest->frame_index,
+           largest->bytes / 1024.0, largest->frame_index);
+    printf("ѹ: ƽ %.2f bpp, ѹ %.1f:1\n", avg * 8.0 / (opt.width * opt.height), raw / avg);
+    if (psnr_count > 0) {
+        printf("PSNR(Y): ƽ %.2f dB,  %.2f dB\n", psnr_sum / psnr_count, psnr_min);
+    }
+}
+
+int save_every_nth_frame(const BatchOptions &opt, const char *input_file, const char *pattern) {
+    MappedFile input;
+    if (!input.open(input_file)) {
+        printf("޷ӳ YUV ļ: %s\n", input_file);
+        return -1;
+    }
+
+    //  jpeg_worker ƫƼ㱣һ (ʱɫȡ)
+    const size_t frame_size = av_image_get_buffer_size(AV_PIX_FMT_YUVJ420P, opt.width, opt.height, 1);
+    const size_t total_frames = input.size() / frame_size;
+    std::vector<int> frames;
+    for (size_t idx = opt.start; idx < total_frames; idx += opt.every) {
+        if (opt.max_images > 0 && static_cast<int>(frames.size()) >= opt.max_images) break;
+        frames.push_back(static_cast<int>(idx));
+    }
+    if (frames.empty()) {
+        printf("ļֻ %zu ֡ûҪ֡\n", total_frames);
+        return -1;
+    }
+
+    int threads = opt.threads > 0 ? opt.threads : static_cast<int>(std::thread::hardware_concurrency());
+    if (threads < 1) threads = 1;
+    threads = std::min<int>(threads, static_cast<int>(frames.size()));
+    printf("%s: %zu ֡,  %zu  (ÿ %d ֡һ), %d  x %d ߳\n", input_file, total_frames,
+           frames.size(), opt.every, threads, opt.slice_threads);
+
+    // ָ̣֡߳ÿ߳ӳڴ˳
+    std::vector<ImageResult> results(frames.size());
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        size_t begin = frames.size() * t / threads;
+        size_t end = frames.size() * (t + 1) / threads;
+        workers.emplace_back(jpeg_worker, std::cref(input), std::cref(opt), pattern, std::cref(frames), begin, end,
+                             std::ref(results));
+    }
+    for (std::thread &w : workers) w.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    print_summary(opt, results, seconds);
+    for (const ImageResult &r : results) {
+        if (!r.ok) return -1;
+    }
+    return 0;
+}
+
+void print_usage(const char *prog) {
+    printf("÷:\n");
+    printf("  %s                                  ȡ %s ĵ %d ֡\n", prog, IN_YUV_FILE, EXTRACT_FRAME_INDEX);
+    printf("  %s --every <n> [ѡ] <in.yuv> <out_%%05d.jpg>\n", prog);
+    printf("ѡ:\n");
+    printf("  --every <n>          ÿ n ֡һ\n");
+    printf("  --size <WxH>         ֱ (Ĭ %dx%d)\n", WIDTH, HEIGHT);
+    printf("  --start <n>          ӵ n ֡ʼ (Ĭ 0)\n");
+    printf("  --max <n>            ർ n \n");
+    printf("  -j <n>               б (Ĭ CPU )\n");
+    printf("  --slice-threads <n>  ÿ߳ (Ĭ 1)\n");
+    printf("  -q <2-31>            JPEG  qscaleԽСԽ (Ĭ 4)\n");
+    printf("  --psnr               ͳ PSNR\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) return save_single_frame();
+
+    BatchOptions opt;
+    std::vector<const char *> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg == "--psnr") {
+            opt.psnr = true;
+        } else if (arg == "--every" || arg == "--size" || arg == "--start" || arg == "--max" || arg == "-j"
+                   || arg == "--slice-threads" || arg == "-q") {
+            if (i + 1 >= argc) {
+                printf("%s ȱٲ\n", arg.c_str());
+                return -1;
+            }
+            const char *value = argv[++i];
+            if (arg == "--every") {
+                opt.every = atoi(value);
+            } else if (arg == "--size") {
+                if (sscanf(value, "%dx%d", &opt.width, &opt.height) != 2) {
+                    printf("ֱʸʽӦΪ WxH: %s\n", value);
+                    return -1;
+                }
+            } else if (arg == "--start") {
+                opt.start = atoi(value);
+            } else if (arg == "--max") {
+                opt.max_images = atoi(value);
+            } else if (arg == "-j") {
+                opt.threads = atoi(value);
+            } else if (arg == "--slice-threads") {
+                opt.slice_threads = atoi(value);
+            } else {
+                opt.quality = atoi(value);
+            }
+        } else {
+            positional.push_back(argv[i]);
+        }
+    }
+
+    if (positional.size() != 2) {
+        print_usage(argv[0]);
+        return -1;
+    }
+    // ·Ҫֻһ %d ֡ռλͼƬдͬһļ
+    // · av_get_frame_filename2 չ printf ʽ
+    char probe[1024];
+    if (av_get_frame_filename2(probe, sizeof(probe), positional[1], 0, 0) < 0) {
+        printf("·Ҫ֡Ÿʽ thumbs/frame_%%05d.jpg\n");
+        return -1;
+    }
+    if (opt.width <= 0 || opt.height <= 0 || opt.every < 1 || opt.start < 0 || opt.slice_threads < 1) {
+        print_usage(argv[0]);
+        return -1;
+    }
+    opt.quality = std::max(2, std::min(31, opt.quality));
+
+    return save_every_nth_frame(opt, positional[0], positional[1]);
+}
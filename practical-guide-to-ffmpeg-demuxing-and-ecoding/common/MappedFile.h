@@ -0,0 +1,43 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 只读内存映射文件
+ *
+ * Windows 用 CreateFileMapping / MapViewOfFile，其它平台用 mmap。
+ * 整个文件映射成一段连续内存，不用把文件读进内存，也不用自己管理缓冲。
+ * 32 位程序的地址空间放不下几个 GB 的文件，这种情况下 open() 会失败。
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const char *path);
+
+    void close();
+
+    const uint8_t *data() const { return data_; }
+
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void *file_ = nullptr;    // HANDLE
+    void *mapping_ = nullptr; // HANDLE
+#else
+    int fd_ = -1;
+#endif
+};
+
+#endif // MAPPEDFILE_H
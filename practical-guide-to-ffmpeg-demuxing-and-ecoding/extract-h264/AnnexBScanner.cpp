@@ -0,0 +1,113 @@
+#include "AnnexBScanner.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+AnnexBScanner::AnnexBScanner(Callback callback, uint64_t baseOffset)
+    : callback_(std::move(callback)), base_(baseOffset), pos_(baseOffset) {
+}
+
+void AnnexBScanner::feed(const uint8_t *data, size_t len) {
+    // 上一块结束时当前 NALU 的开头字节还没攒够，先从这一块补齐
+    if (inNalu_ && headLen_ < HEAD_BYTES) {
+        size_t n = std::min(HEAD_BYTES - headLen_, len);
+        memcpy(head_ + headLen_, data, n);
+        headLen_ += n;
+    }
+
+    size_t i = 0;
+    while (i < len) {
+        const uint8_t b = data[i];
+        if (b == 0x00) {
+            zeros_++;
+            i++;
+            continue;
+        }
+        if (b == 0x01 && zeros_ >= 2) {
+            // 找到起始码，0x01 之前的连续零里最多 3 个属于起始码，更多的是上一个 NALU 的补零
+            const uint64_t one = pos_ + i;
+            const int startCodeLen = zeros_ >= 3 ? 4 : 3;
+            if (inNalu_) endNalu(one - zeros_);
+            beginNalu(one + 1 - startCodeLen, startCodeLen, data + i + 1, len - i - 1);
+            zeros_ = 0;
+            i++;
+            continue;
+        }
+
+        // 非零字节：直接跳到下一个 0x00
+        zeros_ = 0;
+        const void *next = memchr(data + i + 1, 0x00, len - i - 1);
+        if (!next) {
+            i = len;
+            break;
+        }
+        i = static_cast<size_t>(static_cast<const uint8_t *>(next) - data);
+    }
+    pos_ += len;
+}
+
+void AnnexBScanner::finish() {
+    if (inNalu_) endNalu(pos_ - zeros_);
+    zeros_ = 0;
+}
+
+void AnnexBScanner::beginNalu(uint64_t startCodeOffset, int startCodeLen, const uint8_t *data, size_t avail) {
+    inNalu_ = true;
+    current_ = NaluRef();
+    current_.offset = startCodeOffset;
+    current_.startCodeLen = startCodeLen;
+    naluStart_ = startCodeOffset + startCodeLen;
+
+    headLen_ = std::min(HEAD_BYTES, avail);
+    memcpy(head_, data, headLen_);
+}
+
+void AnnexBScanner::endNalu(uint64_t end) {
+    inNalu_ = false;
+    current_.size = end > naluStart_ ? end - naluStart_ : 0;
+    current_.head = head_;
+    // head_ 可能多拷贝了下一个起始码之后的字节，按实际长度截断
+    current_.headLen = static_cast<size_t>(std::min<uint64_t>(headLen_, current_.size));
+    callback_(current_);
+}
+
+bool scanAnnexBFile(const std::string &filePath, const AnnexBScanner::Callback &callback, bool useMmap,
+                    size_t windowSize, uint64_t *fileSize, std::string *error) {
+    AnnexBScanner scanner(callback);
+
+    if (useMmap) {
+        MappedFile file;
+        if (file.open(filePath.c_str())) {
+            if (file.size() > 0) scanner.feed(file.data(), file.size());
+            scanner.finish();
+            if (fileSize) *fileSize = file.size();
+            return true;
+        }
+        // 映射失败时退回窗口读取
+    }
+
+    FILE *f = fopen(filePath.c_str(), "rb");
+    if (!f) {
+        if (error) *error = "无法打开文件";
+        return false;
+    }
+    // 每次直接读满一个大窗口，不需要 stdio 再缓冲一遍
+    setvbuf(f, nullptr, _IONBF, 0);
+
+    std::vector<uint8_t> window(std::max<size_t>(windowSize, 4096));
+    size_t n;
+    while ((n = fread(window.data(), 1, window.size(), f)) > 0) {
+        scanner.feed(window.data(), n);
+    }
+    bool ok = !ferror(f);
+    if (!ok && error) *error = "读取文件失败";
+    fclose(f);
+
+    scanner.finish();
+    if (fileSize) *fileSize = scanner.bytesFed();
+    return ok;
+}
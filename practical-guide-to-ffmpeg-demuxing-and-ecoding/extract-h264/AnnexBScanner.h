@@ -0,0 +1,80 @@
+#ifndef ANNEXBSCANNER_H
+#define ANNEXBSCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/// 扫描到的一个 NALU
+struct NaluRef {
+    uint64_t offset = 0;       ///< 起始码在文件中的偏移
+    int startCodeLen = 0;      ///< 起始码长度 (3 或 4)
+    uint64_t size = 0;         ///< NALU 长度 (含头部，不含起始码和末尾的补零)
+    const uint8_t *head = nullptr; ///< NALU 开头的若干字节 (从头部字节开始)
+    size_t headLen = 0;        ///< head 中有效的字节数，最多 AnnexBScanner::HEAD_BYTES
+};
+
+/**
+ * @brief Annex B 起始码流式扫描器
+ *
+ * 数据可以分成任意大小的块多次 feed()，跨块的起始码 (00 00 | 01) 也能正确识别，
+ * 因此既可以喂整段内存映射，也可以喂固定大小的读取窗口，内存占用与文件大小无关。
+ *
+ * 查找起始码时用 memchr 跳过非零字节 (C 库的 memchr 一般是 SIMD 实现)，
+ * 只有遇到 0x00 才逐字节检查，码流里的 00 00 因为防竞争字节很少出现。
+ *
+ * 每个 NALU 在找到下一个起始码 (或 finish) 时通过回调交出，
+ * 附带开头最多 HEAD_BYTES 字节的拷贝，足够解析 SPS/PPS/Slice 头。
+ */
+class AnnexBScanner {
+public:
+    static const size_t HEAD_BYTES = 1024;
+
+    using Callback = std::function<void(const NaluRef &)>;
+
+    /**
+     * @param callback 每个完整 NALU 的回调
+     * @param baseOffset 第一个 feed 字节在文件中的偏移
+     */
+    explicit AnnexBScanner(Callback callback, uint64_t baseOffset = 0);
+
+    /// 送入下一块数据
+    void feed(const uint8_t *data, size_t len);
+
+    /// 数据结束，交出最后一个 NALU
+    void finish();
+
+    /// 已经送入的字节数
+    uint64_t bytesFed() const { return pos_ - base_; }
+
+private:
+    void beginNalu(uint64_t startCodeOffset, int startCodeLen, const uint8_t *data, size_t avail);
+
+    void endNalu(uint64_t end);
+
+    Callback callback_;
+    uint64_t base_;
+    uint64_t pos_;             ///< 下一个 feed 字节的文件偏移
+    uint64_t zeros_ = 0;       ///< 当前位置之前连续 0x00 的个数
+
+    bool inNalu_ = false;
+    NaluRef current_;
+    uint64_t naluStart_ = 0;   ///< 当前 NALU 头部字节的文件偏移
+    uint8_t head_[HEAD_BYTES];
+    size_t headLen_ = 0;
+};
+
+/**
+ * @brief 扫描整个 Annex B 文件
+ *
+ * 优先用内存映射一次性 feed 整个文件；映射失败 (例如 32 位程序打开超大文件)
+ * 或 useMmap 为 false 时，改为按 windowSize 大小的窗口循环 fread。
+ *
+ * @param error 失败时写入原因
+ * @return bool 文件是否读完
+ */
+bool scanAnnexBFile(const std::string &filePath, const AnnexBScanner::Callback &callback, bool useMmap,
+                    size_t windowSize, uint64_t *fileSize, std::string *error);
+
+#endif // ANNEXBSCANNER_H
@@ -0,0 +1,97 @@
+#ifndef BITREADER_H
+#define BITREADER_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 去掉防竞争字节 (emulation_prevention_three_byte)
+ *
+ * NALU 负载中出现 00 00 0x 时编码器会插入 0x03 变成 00 00 03 0x，
+ * 解析语法元素之前必须先还原成 RBSP。
+ *
+ * @param src NALU 数据 (不含起始码)
+ * @param len 数据长度
+ * @param dst 输出缓冲，至少 len 字节
+ * @return size_t RBSP 长度
+ */
+inline size_t unescapeRbsp(const uint8_t *src, size_t len, uint8_t *dst) {
+    size_t out = 0;
+    int zeros = 0;
+    for (size_t i = 0; i < len; i++) {
+        const uint8_t b = src[i];
+        if (zeros >= 2 && b == 0x03) {
+            zeros = 0;
+            continue;
+        }
+        dst[out++] = b;
+        zeros = (b == 0x00) ? zeros + 1 : 0;
+    }
+    return out;
+}
+
+/**
+ * @brief RBSP 位读取器
+ *
+ * 支持定长读取 u(n) 以及指数哥伦布编码 ue(v) / se(v)。
+ * 越界时不抛异常，只置 error 标志并返回 0，调用方在解析结束后统一检查。
+ */
+class BitReader {
+public:
+    BitReader(const uint8_t *data, size_t size) : data_(data), bits_(static_cast<uint64_t>(size) * 8) {}
+
+    /// 读取 n 位 (n <= 32)，高位在前
+    uint32_t readBits(int n) {
+        if (n == 0) return 0;
+        if (pos_ + n > bits_) {
+            error_ = true;
+            pos_ = bits_;
+            return 0;
+        }
+        uint64_t v = 0;
+        while (n > 0) {
+            const int avail = 8 - static_cast<int>(pos_ & 7);
+            const int take = n < avail ? n : avail;
+            const uint32_t byte = data_[pos_ >> 3];
+            v = (v << take) | ((byte >> (avail - take)) & ((1u << take) - 1));
+            pos_ += take;
+            n -= take;
+        }
+        return static_cast<uint32_t>(v);
+    }
+
+    bool readFlag() { return readBits(1) != 0; }
+
+    void skipBits(int n) { readBits(n); }
+
+    /// ue(v)：前导零个数 k，值为 2^k - 1 + 后面 k 位
+    uint32_t readUE() {
+        int zeros = 0;
+        while (!readFlag()) {
+            if (error_ || ++zeros > 31) {
+                error_ = true;
+                return 0;
+            }
+        }
+        return static_cast<uint32_t>((1ull << zeros) - 1 + readBits(zeros));
+    }
+
+    /// se(v)：ue 的值 k 依次映射为 0, 1, -1, 2, -2 ...
+    int32_t readSE() {
+        const uint32_t k = readUE();
+        const int64_t v = (k & 1) ? (static_cast<int64_t>(k) + 1) / 2 : -static_cast<int64_t>(k / 2);
+        return static_cast<int32_t>(v);
+    }
+
+    bool error() const { return error_; }
+
+    uint64_t bitsLeft() const { return bits_ - pos_; }
+
+private:
+    const uint8_t *data_;
+    uint64_t bits_;
+    uint64_t pos_ = 0;
+    bool error_ = false;
+};
+
+#endif // BITREADER_H
@@ -0,0 +1,189 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+/// 码流里没有帧率信息时按这个帧率计算时间
+static const double DEFAULT_FPS = 25.0;
+
+/// 码率曲线最多打印的行数，超过时几秒合并成一行
+static const size_t MAX_BITRATE_ROWS = 60;
+
+/// GOP 结构分析最多保存的帧数 (只影响模式串和连续 B 帧统计，不影响 GOP 长度)
+static const size_t MAX_GOP_FRAMES = 4096;
+
+/// 帧类型在 types_ 中的下标
+static int typeIndex(char type) {
+    switch (type) {
+        case 'I': return 0;
+        case 'P': return 1;
+        default: return 2;
+    }
+}
+
+FrameStats::FrameStats(int framesToPrint, const std::string &extraColumn)
+    : framesToPrint_(framesToPrint), extraColumn_(extraColumn) {
+}
+
+char FrameStats::mergeType(char current, char sliceType) {
+    if (current == '?' || typeIndex(sliceType) > typeIndex(current)) return sliceType;
+    return current;
+}
+
+void FrameStats::setFrameRate(double fps) {
+    if (fpsSet_) return;
+    fpsSet_ = true;
+    fpsFromStream_ = fps > 0;
+    fps_ = fpsFromStream_ ? fps : DEFAULT_FPS;
+}
+
+void FrameStats::addFrame(const Frame &frame) {
+    if (!fpsSet_) setFrameRate(0);
+
+    TypeStats &t = types_[typeIndex(frame.type)];
+    t.count++;
+    t.bytes += frame.bytes;
+
+    // 每个 I 帧开始一个新的 GOP
+    if (frame.type == 'I') closeGop();
+    gopLength_++;
+    if (gopLength_ == 1) {
+        gopStartsWithI_ = frame.type == 'I';
+        gopKey_ = frame.key;
+    }
+    if (gopFrames_.size() < MAX_GOP_FRAMES) gopFrames_.push_back(std::make_pair(frame.poc, frame.type));
+
+    const size_t second = static_cast<size_t>(frame.index / fps_);
+    if (second >= secondBytes_.size()) secondBytes_.resize(second + 1, 0);
+    secondBytes_[second] += frame.bytes;
+
+    if (framesToPrint_ < 0 || printed_.size() < static_cast<size_t>(framesToPrint_)) printed_.push_back(frame);
+    frameCount_++;
+}
+
+void FrameStats::closeGop() {
+    if (gopLength_ == 0) return;
+
+    if (!gopStartsWithI_) {
+        // 文件开头第一个 I 帧之前的帧不算完整 GOP
+        leadingFrames_ = gopLength_;
+    } else {
+        gops_.count++;
+        if (gopKey_) gops_.keyCount++;
+        gops_.totalLength += gopLength_;
+        if (gops_.count == 1 || gopLength_ < gops_.minLength) gops_.minLength = gopLength_;
+        if (gopLength_ > gops_.maxLength) gops_.maxLength = gopLength_;
+
+        // 按 POC 排序得到显示顺序
+        std::stable_sort(gopFrames_.begin(), gopFrames_.end(),
+                         [](const std::pair<int, char> &a, const std::pair<int, char> &b) { return a.first < b.first; });
+        int run = 0;
+        for (const auto &f : gopFrames_) {
+            run = (f.second == 'B') ? run + 1 : 0;
+            gops_.maxConsecutiveB = std::max(gops_.maxConsecutiveB, run);
+        }
+        if (gops_.firstPattern.empty()) {
+            for (size_t i = 0; i < gopFrames_.size() && i < 60; i++) gops_.firstPattern += gopFrames_[i].second;
+            if (gopLength_ > 60) gops_.firstPattern += "...";
+        }
+    }
+
+    gopLength_ = 0;
+    gopStartsWithI_ = false;
+    gopKey_ = false;
+    gopFrames_.clear();
+}
+
+void FrameStats::finish() {
+    closeGop();
+}
+
+void FrameStats::printFrameTable() const {
+    if (printed_.empty()) return;
+
+    std::cout << "\n[*] 逐帧信息 (解码顺序, 前 " << printed_.size() << " 帧)" << std::endl;
+    std::cout << std::string(90, '-') << std::endl;
+    std::cout << std::left << std::setw(8) << "Frame"
+              << "| " << std::setw(12) << "Offset (Hex)"
+              << "| " << std::setw(5) << "Type"
+              << "| " << std::setw(4) << "Key"
+              << "| " << std::setw(4) << "Ref"
+              << "| " << std::setw(10) << extraColumn_
+              << "| " << std::setw(8) << "POC"
+              << "| " << std::setw(7) << "Slices"
+              << "| " << "Bytes" << std::endl;
+    std::cout << std::string(90, '-') << std::endl;
+    for (const Frame &f : printed_) {
+        std::cout << std::setw(8) << f.index
+                  << "| 0x" << std::hex << std::uppercase << std::right << std::setfill('0') << std::setw(8) << f.offset
+                  << std::dec << std::left << std::setfill(' ') << "  | " << std::setw(5) << f.type
+                  << "| " << std::setw(4) << (f.key ? "Y" : "")
+                  << "| " << std::setw(4) << (f.ref ? "Y" : "")
+                  << "| " << std::setw(10) << f.extra
+                  << "| " << std::setw(8) << f.poc
+                  << "| " << std::setw(7) << f.slices
+                  << "| " << f.bytes << std::endl;
+    }
+}
+
+void FrameStats::printSummary(uint64_t totalBytes) const {
+    if (frameCount_ == 0) {
+        std::cout << "[!] 没有解析出任何帧" << std::endl;
+        return;
+    }
+
+    const double seconds = frameCount_ / fps_;
+    std::cout << "\n[*] 帧统计: " << frameCount_ << " 帧, " << std::fixed << std::setprecision(2) << seconds << " s ("
+              << fps_ << " fps" << (fpsFromStream_ ? "" : ", 码流无帧率信息, 按默认值") << "), 平均码率 "
+              << (seconds > 0 ? totalBytes * 8.0 / seconds / 1000.0 : 0.0) << " kbps" << std::endl;
+    std::cout << std::string(90, '-') << std::endl;
+    std::cout << std::left << std::setw(6) << "Type"
+              << "| " << std::setw(10) << "Frames"
+              << "| " << std::setw(8) << "Ratio"
+              << "| " << std::setw(15) << "Bytes"
+              << "| " << std::setw(12) << "Avg bytes"
+              << "| " << "Byte share" << std::endl;
+    std::cout << std::string(90, '-') << std::endl;
+    static const char TYPE_NAMES[] = {'I', 'P', 'B'};
+    for (int i = 0; i < 3; i++) {
+        const TypeStats &t = types_[i];
+        std::cout << std::setw(6) << TYPE_NAMES[i]
+                  << "| " << std::setw(10) << t.count
+                  << "| " << std::right << std::setw(6) << 100.0 * t.count / frameCount_ << "% " << std::left
+                  << "| " << std::setw(15) << t.bytes
+                  << "| " << std::setw(12) << (t.count ? t.bytes / t.count : 0)
+                  << "| " << (totalBytes ? 100.0 * t.bytes / totalBytes : 0.0) << "%" << std::endl;
+    }
+
+    std::cout << "\n[*] GOP 结构: " << gops_.count << " 个 GOP (其中关键帧开头 " << gops_.keyCount << " 个)";
+    if (gops_.count > 0) {
+        std::cout << ", 长度 min " << gops_.minLength << " / avg " << static_cast<double>(gops_.totalLength) / gops_.count
+                  << " / max " << gops_.maxLength << " 帧, 最多连续 B 帧 " << gops_.maxConsecutiveB << std::endl;
+        std::cout << "    第一个 GOP (显示顺序): " << gops_.firstPattern;
+    }
+    std::cout << std::endl;
+    if (leadingFrames_ > 0) {
+        std::cout << "    文件开头有 " << leadingFrames_ << " 帧在第一个 I 帧之前 (不计入 GOP)" << std::endl;
+    }
+
+    // 每秒码率，秒数太多时合并成若干行
+    const size_t step = (secondBytes_.size() + MAX_BITRATE_ROWS - 1) / MAX_BITRATE_ROWS;
+    uint64_t minBytes = secondBytes_[0];
+    uint64_t maxBytes = secondBytes_[0];
+    for (uint64_t b : secondBytes_) {
+        minBytes = std::min(minBytes, b);
+        maxBytes = std::max(maxBytes, b);
+    }
+    std::cout << "\n[*] 码率曲线 (kbps, 每行 " << step << " s): 每秒最小 " << minBytes * 8 / 1000 << ", 最大 "
+              << maxBytes * 8 / 1000 << std::endl;
+    for (size_t s = 0; s < secondBytes_.size(); s += step) {
+        const size_t end = std::min(s + step, secondBytes_.size());
+        uint64_t sum = 0;
+        for (size_t i = s; i < end; i++) sum += secondBytes_[i];
+        const double kbps = sum * 8.0 / 1000.0 / (end - s);
+        const int bar = maxBytes ? static_cast<int>(kbps * 1000.0 / 8.0 / maxBytes * 50) : 0;
+        std::cout << "    " << std::right << std::setw(6) << s << "s " << std::setw(10) << std::setprecision(1) << kbps
+                  << " " << std::string(bar, '#') << std::left << std::endl;
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 与编码格式无关的逐帧统计
+ *
+ * H.264 / HEVC 的分析器把 Slice 组装成帧后交给这里，
+ * 累计帧类型、GOP 结构和每秒码率，并打印逐帧表格和汇总。
+ *
+ * 统计是边扫描边累计的，只保存当前 GOP、前 framesToPrint 帧的明细和每秒一个计数，
+ * 整个文件的帧列表不会留在内存里。
+ */
+class FrameStats {
+public:
+    struct Frame {
+        uint64_t index = 0;      ///< 解码顺序的帧号
+        uint64_t offset = 0;     ///< 第一个 Slice 的起始码偏移
+        char type = '?';         ///< I/P/B (多个 Slice 时取 B > P > I)
+        bool key = false;        ///< H.264 的 IDR / HEVC 的 IRAP
+        bool ref = false;        ///< 是否参考帧
+        int extra = 0;           ///< 编码格式相关的一列 (H.264: frame_num, HEVC: TemporalId)
+        int poc = 0;
+        int slices = 0;
+        uint64_t bytes = 0;      ///< 整个访问单元的字节数 (含起始码、SEI、参数集)
+    };
+
+    /**
+     * @param framesToPrint 逐帧表格显示的帧数，-1 表示全部显示
+     * @param extraColumn Frame::extra 列的表头
+     */
+    FrameStats(int framesToPrint, const std::string &extraColumn);
+
+    /// 设置帧率 (只有第一次调用生效)，fps <= 0 表示码流里没有帧率信息，按默认值计算
+    void setFrameRate(double fps);
+
+    /// 多个 Slice 的帧类型按 B > P > I 合并，current 为 '?' 时直接取 sliceType
+    static char mergeType(char current, char sliceType);
+
+    void addFrame(const Frame &frame);
+
+    /// 扫描结束，结束最后一个 GOP
+    void finish();
+
+    uint64_t frameCount() const { return frameCount_; }
+
+    /// 打印逐帧表格 (前 framesToPrint 帧)
+    void printFrameTable() const;
+
+    /// 打印帧类型、GOP 和码率汇总，totalBytes 为整个文件的字节数 (用于平均码率)
+    void printSummary(uint64_t totalBytes) const;
+
+private:
+    struct TypeStats {
+        uint64_t count = 0;
+        uint64_t bytes = 0;
+    };
+
+    struct GopStats {
+        uint64_t count = 0;
+        uint64_t keyCount = 0;
+        uint64_t minLength = 0;
+        uint64_t maxLength = 0;
+        uint64_t totalLength = 0;
+        int maxConsecutiveB = 0;
+        std::string firstPattern;  ///< 第一个完整 GOP 的显示顺序，如 IBBPBBP
+    };
+
+    void closeGop();
+
+    int framesToPrint_;
+    std::string extraColumn_;
+    double fps_ = 0;
+    bool fpsSet_ = false;
+    bool fpsFromStream_ = false;
+    uint64_t frameCount_ = 0;
+
+    TypeStats types_[3];           ///< I, P, B
+    std::vector<Frame> printed_;
+    GopStats gops_;
+    uint64_t gopLength_ = 0;       ///< 当前 GOP 的帧数
+    bool gopStartsWithI_ = false;
+    bool gopKey_ = false;
+    std::vector<std::pair<int, char>> gopFrames_; ///< 当前 GOP 的 (POC, 类型)，解码顺序
+    uint64_t leadingFrames_ = 0;   ///< 第一个 I 帧之前的帧数
+    std::vector<uint64_t> secondBytes_;   ///< 每秒的字节数
+};
+
+#endif // FRAMESTATS_H
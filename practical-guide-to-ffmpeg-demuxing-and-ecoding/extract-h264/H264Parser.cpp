@@ -0,0 +1,289 @@
+#include "H264Parser.h"
+#include "BitReader.h"
+
+// scaling_list() 只需要跳过，不保存
+static void skipScalingList(BitReader &br, int size) {
+    int lastScale = 8;
+    int nextScale = 8;
+    for (int j = 0; j < size; j++) {
+        if (nextScale != 0) {
+            const int delta = br.readSE();
+            nextScale = (lastScale + delta + 256) % 256;
+        }
+        lastScale = (nextScale == 0) ? lastScale : nextScale;
+    }
+}
+
+// 只解析到 timing_info 为止，后面的 HRD 参数用不到
+static void parseVui(BitReader &br, H264Sps &sps) {
+    if (br.readFlag()) {              // aspect_ratio_info_present_flag
+        if (br.readBits(8) == 255) {  // aspect_ratio_idc == Extended_SAR
+            br.skipBits(16);          // sar_width
+            br.skipBits(16);          // sar_height
+        }
+    }
+    if (br.readFlag()) {              // overscan_info_present_flag
+        br.skipBits(1);               // overscan_appropriate_flag
+    }
+    if (br.readFlag()) {              // video_signal_type_present_flag
+        br.skipBits(3);               // video_format
+        br.skipBits(1);               // video_full_range_flag
+        if (br.readFlag()) {          // colour_description_present_flag
+            br.skipBits(24);          // colour_primaries, transfer_characteristics, matrix_coefficients
+        }
+    }
+    if (br.readFlag()) {              // chroma_loc_info_present_flag
+        br.readUE();
+        br.readUE();
+    }
+    sps.timingInfoPresent = br.readFlag();
+    if (sps.timingInfoPresent) {
+        sps.numUnitsInTick = br.readBits(32);
+        sps.timeScale = br.readBits(32);
+        sps.fixedFrameRate = br.readFlag();
+    }
+}
+
+bool parseSps(const uint8_t *rbsp, size_t len, H264Sps &sps) {
+    BitReader br(rbsp, len);
+    sps = H264Sps();
+
+    sps.profileIdc = static_cast<int>(br.readBits(8));
+    sps.constraintFlags = static_cast<int>(br.readBits(8));
+    sps.levelIdc = static_cast<int>(br.readBits(8));
+    sps.spsId = static_cast<int>(br.readUE());
+    if (sps.spsId >= H264_MAX_SPS) return false;
+
+    // High 系列档次才有色度格式、位深和缩放矩阵
+    switch (sps.profileIdc) {
+        case 100: case 110: case 122: case 244: case 44:
+        case 83: case 86: case 118: case 128: case 138: case 139: case 134: case 135:
+            sps.chromaFormatIdc = static_cast<int>(br.readUE());
+            if (sps.chromaFormatIdc == 3) sps.separateColourPlane = br.readFlag();
+            sps.bitDepthLuma = static_cast<int>(br.readUE()) + 8;
+            sps.bitDepthChroma = static_cast<int>(br.readUE()) + 8;
+            br.skipBits(1);           // qpprime_y_zero_transform_bypass_flag
+            if (br.readFlag()) {      // seq_scaling_matrix_present_flag
+                const int lists = (sps.chromaFormatIdc != 3) ? 8 : 12;
+                for (int i = 0; i < lists; i++) {
+                    if (br.readFlag()) skipScalingList(br, i < 6 ? 16 : 64);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+
+    sps.log2MaxFrameNum = static_cast<int>(br.readUE()) + 4;
+    sps.pocType = static_cast<int>(br.readUE());
+    if (sps.pocType == 0) {
+        sps.log2MaxPocLsb = static_cast<int>(br.readUE()) + 4;
+    } else if (sps.pocType == 1) {
+        sps.deltaPicOrderAlwaysZero = br.readFlag();
+        sps.offsetForNonRefPic = br.readSE();
+        sps.offsetForTopToBottomField = br.readSE();
+        sps.numRefFramesInPocCycle = static_cast<int>(br.readUE());
+        if (sps.numRefFramesInPocCycle > 255) return false;
+        for (int i = 0; i < sps.numRefFramesInPocCycle; i++) {
+            sps.offsetForRefFrame[i] = br.readSE();
+        }
+    }
+    if (sps.log2MaxFrameNum > 16 || sps.pocType > 2 || sps.log2MaxPocLsb > 16) return false;
+
+    sps.maxNumRefFrames = static_cast<int>(br.readUE());
+    br.skipBits(1);                   // gaps_in_frame_num_value_allowed_flag
+    const int widthInMbs = static_cast<int>(br.readUE()) + 1;
+    const int heightInMapUnits = static_cast<int>(br.readUE()) + 1;
+    sps.frameMbsOnly = br.readFlag();
+    if (!sps.frameMbsOnly) br.skipBits(1); // mb_adaptive_frame_field_flag
+    br.skipBits(1);                   // direct_8x8_inference_flag
+
+    int cropLeft = 0, cropRight = 0, cropTop = 0, cropBottom = 0;
+    if (br.readFlag()) {              // frame_cropping_flag
+        cropLeft = static_cast<int>(br.readUE());
+        cropRight = static_cast<int>(br.readUE());
+        cropTop = static_cast<int>(br.readUE());
+        cropBottom = static_cast<int>(br.readUE());
+    }
+
+    // 裁剪单位取决于色度采样方式 (7.4.2.1.1)
+    const int chromaArrayType = sps.separateColourPlane ? 0 : sps.chromaFormatIdc;
+    const int subWidthC = (chromaArrayType == 3) ? 1 : 2;
+    const int subHeightC = (chromaArrayType == 1) ? 2 : 1;
+    const int cropUnitX = (chromaArrayType == 0) ? 1 : subWidthC;
+    const int cropUnitY = ((chromaArrayType == 0) ? 1 : subHeightC) * (sps.frameMbsOnly ? 1 : 2);
+    sps.width = widthInMbs * 16 - cropUnitX * (cropLeft + cropRight);
+    sps.height = (sps.frameMbsOnly ? 1 : 2) * heightInMapUnits * 16 - cropUnitY * (cropTop + cropBottom);
+
+    if (br.readFlag()) parseVui(br, sps); // vui_parameters_present_flag
+
+    sps.valid = !br.error();
+    return sps.valid;
+}
+
+bool parsePps(const uint8_t *rbsp, size_t len, H264Pps &pps) {
+    BitReader br(rbsp, len);
+    pps = H264Pps();
+
+    pps.ppsId = static_cast<int>(br.readUE());
+    pps.spsId = static_cast<int>(br.readUE());
+    if (pps.ppsId >= H264_MAX_PPS || pps.spsId >= H264_MAX_SPS) return false;
+    pps.entropyCodingMode = br.readFlag();
+    pps.bottomFieldPicOrderInFramePresent = br.readFlag();
+    pps.numSliceGroups = static_cast<int>(br.readUE()) + 1;
+    if (pps.numSliceGroups > 1) {
+        // FMO 只在 Baseline/Extended 中出现，条带组参数对 Slice 头前半部分没有影响，这里不再往下解析
+        pps.valid = !br.error();
+        return pps.valid;
+    }
+    pps.numRefIdxL0Default = static_cast<int>(br.readUE()) + 1;
+    pps.numRefIdxL1Default = static_cast<int>(br.readUE()) + 1;
+    pps.weightedPred = br.readFlag();
+    pps.weightedBipredIdc = static_cast<int>(br.readBits(2));
+    pps.picInitQp = br.readSE() + 26;
+
+    pps.valid = !br.error();
+    return pps.valid;
+}
+
+bool parseSliceHeader(const uint8_t *rbsp, size_t len, int nalType, int nalRefIdc, const H264Sps *spsTable,
+                      const H264Pps *ppsTable, H264SliceHeader &sh) {
+    BitReader br(rbsp, len);
+    sh = H264SliceHeader();
+    sh.nalType = nalType;
+    sh.nalRefIdc = nalRefIdc;
+    sh.idr = (nalType == 5);
+
+    sh.firstMbInSlice = br.readUE();
+    const uint32_t sliceType = br.readUE();
+    if (sliceType > 9) return false;
+    sh.sliceType = static_cast<int>(sliceType % 5);
+    const uint32_t ppsId = br.readUE();
+    if (ppsId >= H264_MAX_PPS || !ppsTable[ppsId].valid) return false;
+    sh.ppsId = static_cast<int>(ppsId);
+
+    const H264Pps &pps = ppsTable[ppsId];
+    const H264Sps &sps = spsTable[pps.spsId];
+    if (!sps.valid) return false;
+
+    if (sps.separateColourPlane) br.skipBits(2); // colour_plane_id
+    sh.frameNum = static_cast<int>(br.readBits(sps.log2MaxFrameNum));
+    if (!sps.frameMbsOnly) {
+        sh.fieldPic = br.readFlag();
+        if (sh.fieldPic) sh.bottomField = br.readFlag();
+    }
+    if (sh.idr) sh.idrPicId = static_cast<int>(br.readUE());
+    if (sps.pocType == 0) {
+        sh.pocLsb = static_cast<int>(br.readBits(sps.log2MaxPocLsb));
+        if (pps.bottomFieldPicOrderInFramePresent && !sh.fieldPic) sh.deltaPocBottom = br.readSE();
+    }
+    if (sps.pocType == 1 && !sps.deltaPicOrderAlwaysZero) {
+        sh.deltaPoc[0] = br.readSE();
+        if (pps.bottomFieldPicOrderInFramePresent && !sh.fieldPic) sh.deltaPoc[1] = br.readSE();
+    }
+    return !br.error();
+}
+
+std::string profileName(const H264Sps &sps) {
+    switch (sps.profileIdc) {
+        case 66: return (sps.constraintFlags & 0x40) ? "Constrained Baseline" : "Baseline";
+        case 77: return "Main";
+        case 88: return "Extended";
+        case 100: return "High";
+        case 110: return "High 10";
+        case 122: return "High 4:2:2";
+        case 244: return "High 4:4:4 Predictive";
+        case 44: return "CAVLC 4:4:4 Intra";
+        default: return "Profile " + std::to_string(sps.profileIdc);
+    }
+}
+
+char sliceTypeChar(int sliceType) {
+    static const char NAMES[] = {'P', 'B', 'I', 'p', 'i'}; // 小写表示 SP / SI
+    return (sliceType >= 0 && sliceType < 5) ? NAMES[sliceType] : '?';
+}
+
+int H264PocCalculator::compute(const H264Sps &sps, const H264SliceHeader &sh) {
+    const bool isFrame = !sh.fieldPic;
+    int top = 0;
+    int bottom = 0;
+
+    if (sps.pocType == 0) {
+        // 8.2.1.1: 由 pic_order_cnt_lsb 的回绕推算高位
+        const int maxLsb = 1 << sps.log2MaxPocLsb;
+        if (sh.idr) {
+            prevPocMsb_ = 0;
+            prevPocLsb_ = 0;
+        }
+        int msb;
+        if (sh.pocLsb < prevPocLsb_ && prevPocLsb_ - sh.pocLsb >= maxLsb / 2) {
+            msb = prevPocMsb_ + maxLsb;
+        } else if (sh.pocLsb > prevPocLsb_ && sh.pocLsb - prevPocLsb_ > maxLsb / 2) {
+            msb = prevPocMsb_ - maxLsb;
+        } else {
+            msb = prevPocMsb_;
+        }
+        top = msb + sh.pocLsb;
+        bottom = isFrame ? top + sh.deltaPocBottom : top;
+        // 只有参考图像更新 prevPicOrderCnt
+        if (sh.nalRefIdc != 0) {
+            prevPocMsb_ = msb;
+            prevPocLsb_ = sh.pocLsb;
+        }
+    } else {
+        // 8.2.1.2 / 8.2.1.3: 由 frame_num 推算
+        const int maxFrameNum = 1 << sps.log2MaxFrameNum;
+        int frameNumOffset;
+        if (sh.idr) {
+            frameNumOffset = 0;
+        } else if (prevFrameNum_ > sh.frameNum) {
+            frameNumOffset = prevFrameNumOffset_ + maxFrameNum;
+        } else {
+            frameNumOffset = prevFrameNumOffset_;
+        }
+
+        if (sps.pocType == 1) {
+            int absFrameNum = (sps.numRefFramesInPocCycle != 0) ? frameNumOffset + sh.frameNum : 0;
+            if (sh.nalRefIdc == 0 && absFrameNum > 0) absFrameNum--;
+
+            int expected = 0;
+            if (absFrameNum > 0) {
+                int expectedDeltaPerCycle = 0;
+                for (int i = 0; i < sps.numRefFramesInPocCycle; i++) {
+                    expectedDeltaPerCycle += sps.offsetForRefFrame[i];
+                }
+                const int cycleCnt = (absFrameNum - 1) / sps.numRefFramesInPocCycle;
+                const int frameNumInCycle = (absFrameNum - 1) % sps.numRefFramesInPocCycle;
+                expected = cycleCnt * expectedDeltaPerCycle;
+                for (int i = 0; i <= frameNumInCycle; i++) {
+                    expected += sps.offsetForRefFrame[i];
+                }
+            }
+            if (sh.nalRefIdc == 0) expected += sps.offsetForNonRefPic;
+
+            if (isFrame) {
+                top = expected + sh.deltaPoc[0];
+                bottom = top + sps.offsetForTopToBottomField + sh.deltaPoc[1];
+            } else if (!sh.bottomField) {
+                top = bottom = expected + sh.deltaPoc[0];
+            } else {
+                top = bottom = expected + sps.offsetForTopToBottomField + sh.deltaPoc[0];
+            }
+        } else {
+            int temp;
+            if (sh.idr) {
+                temp = 0;
+            } else if (sh.nalRefIdc == 0) {
+                temp = 2 * (frameNumOffset + sh.frameNum) - 1;
+            } else {
+                temp = 2 * (frameNumOffset + sh.frameNum);
+            }
+            top = bottom = temp;
+        }
+
+        prevFrameNumOffset_ = frameNumOffset;
+        prevFrameNum_ = sh.frameNum;
+    }
+
+    return top < bottom ? top : bottom;
+}
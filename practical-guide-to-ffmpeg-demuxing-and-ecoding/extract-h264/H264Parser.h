@@ -0,0 +1,120 @@
+#ifndef H264PARSER_H
+#define H264PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// 序列参数集 (SPS) 中分析需要的字段
+struct H264Sps {
+    bool valid = false;
+    int profileIdc = 0;
+    int constraintFlags = 0;       ///< constraint_set0~5_flag 所在的整个字节
+    int levelIdc = 0;
+    int spsId = 0;
+    int chromaFormatIdc = 1;       ///< 0: 黑白, 1: 4:2:0, 2: 4:2:2, 3: 4:4:4
+    bool separateColourPlane = false;
+    int bitDepthLuma = 8;
+    int bitDepthChroma = 8;
+    int log2MaxFrameNum = 4;
+    int pocType = 0;
+    int log2MaxPocLsb = 4;
+    bool deltaPicOrderAlwaysZero = false;
+    int offsetForNonRefPic = 0;
+    int offsetForTopToBottomField = 0;
+    int numRefFramesInPocCycle = 0;
+    int offsetForRefFrame[256] = {0};
+    int maxNumRefFrames = 0;
+    bool frameMbsOnly = true;
+    int width = 0;                 ///< 裁剪后的宽度
+    int height = 0;                ///< 裁剪后的高度
+    bool timingInfoPresent = false;
+    uint32_t numUnitsInTick = 0;
+    uint32_t timeScale = 0;
+    bool fixedFrameRate = false;
+
+    /// VUI 给出的帧率，没有时返回 0
+    double frameRate() const {
+        return (timingInfoPresent && numUnitsInTick > 0) ? timeScale / (2.0 * numUnitsInTick) : 0.0;
+    }
+};
+
+/// 图像参数集 (PPS) 中分析需要的字段
+struct H264Pps {
+    bool valid = false;
+    int ppsId = 0;
+    int spsId = 0;
+    bool entropyCodingMode = false;           ///< false: CAVLC, true: CABAC
+    bool bottomFieldPicOrderInFramePresent = false;
+    int numSliceGroups = 1;
+    int numRefIdxL0Default = 1;
+    int numRefIdxL1Default = 1;
+    bool weightedPred = false;
+    int weightedBipredIdc = 0;
+    int picInitQp = 26;
+};
+
+/// Slice 头部从开头解析到 POC 相关字段为止
+struct H264SliceHeader {
+    int nalType = 0;
+    int nalRefIdc = 0;
+    bool idr = false;
+    uint32_t firstMbInSlice = 0;
+    int sliceType = 0;             ///< 已经对 5 取模：0 P, 1 B, 2 I, 3 SP, 4 SI
+    int ppsId = 0;
+    int frameNum = 0;
+    bool fieldPic = false;
+    bool bottomField = false;
+    int idrPicId = 0;
+    int pocLsb = 0;
+    int deltaPocBottom = 0;
+    int deltaPoc[2] = {0, 0};
+};
+
+/// SPS/PPS 的 id 上限 (标准规定)
+const int H264_MAX_SPS = 32;
+const int H264_MAX_PPS = 256;
+
+/**
+ * @brief 解析 SPS
+ * @param rbsp 去掉防竞争字节后的数据，不含 1 字节 NALU 头
+ */
+bool parseSps(const uint8_t *rbsp, size_t len, H264Sps &sps);
+
+/// 解析 PPS (到 pic_init_qp 为止，不解析 FMO 的条带组参数)
+bool parsePps(const uint8_t *rbsp, size_t len, H264Pps &pps);
+
+/**
+ * @brief 解析 Slice 头部
+ * @param spsTable 以 sps_id 为下标的 SPS 表 (H264_MAX_SPS 个)
+ * @param ppsTable 以 pps_id 为下标的 PPS 表 (H264_MAX_PPS 个)
+ * @return bool 引用的 SPS/PPS 不存在或数据不完整时返回 false
+ */
+bool parseSliceHeader(const uint8_t *rbsp, size_t len, int nalType, int nalRefIdc, const H264Sps *spsTable,
+                      const H264Pps *ppsTable, H264SliceHeader &sh);
+
+/// 档次名称，如 "High"、"Constrained Baseline"
+std::string profileName(const H264Sps &sps);
+
+/// Slice 类型的单字母名称
+char sliceTypeChar(int sliceType);
+
+/**
+ * @brief 图像顺序号 (POC) 计算，按 H.264 8.2.1 节实现三种 pic_order_cnt_type
+ *
+ * 需要按解码顺序对每个图像调用一次。没有解析 dec_ref_pic_marking，
+ * 所以 memory_management_control_operation 5 之后的 POC 可能与解码器不同。
+ */
+class H264PocCalculator {
+public:
+    /// 返回图像的 POC (帧取顶场与底场的较小值)
+    int compute(const H264Sps &sps, const H264SliceHeader &sh);
+
+private:
+    int prevPocMsb_ = 0;
+    int prevPocLsb_ = 0;
+    int prevFrameNumOffset_ = 0;
+    int prevFrameNum_ = 0;
+};
+
+#endif // H264PARSER_H
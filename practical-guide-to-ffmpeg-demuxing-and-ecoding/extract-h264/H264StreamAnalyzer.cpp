@@ -0,0 +1,152 @@
+#include "H264StreamAnalyzer.h"
+#include "BitReader.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+/// Slice 类型对应的帧类型，SP / SI 分别按 P / I 统计
+static char frameTypeOf(int sliceType) {
+    switch (sliceType) {
+        case 1: return 'B';
+        case 0: case 3: return 'P';
+        default: return 'I';
+    }
+}
+
+H264StreamAnalyzer::H264StreamAnalyzer(int framesToPrint)
+    : sps_(H264_MAX_SPS), pps_(H264_MAX_PPS), stats_(framesToPrint, "frame_num") {
+}
+
+void H264StreamAnalyzer::onNalu(const NaluRef &nalu) {
+    const uint64_t bytes = nalu.size + nalu.startCodeLen;
+    totalBytes_ += bytes;
+    if (nalu.headLen == 0) {
+        pendingBytes_ += bytes;
+        return;
+    }
+
+    const int nalType = nalu.head[0] & 0x1F;
+    const int nalRefIdc = (nalu.head[0] >> 5) & 0x03;
+    switch (nalType) {
+        case 1:
+        case 5:
+            onSlice(nalu, nalType, nalRefIdc, bytes);
+            break;
+        case 7: {
+            H264Sps sps;
+            size_t len = unescapeRbsp(nalu.head + 1, nalu.headLen - 1, rbsp_);
+            if (parseSps(rbsp_, len, sps)) sps_[sps.spsId] = sps;
+            pendingBytes_ += bytes;
+            break;
+        }
+        case 8: {
+            H264Pps pps;
+            size_t len = unescapeRbsp(nalu.head + 1, nalu.headLen - 1, rbsp_);
+            if (parsePps(rbsp_, len, pps)) pps_[pps.ppsId] = pps;
+            pendingBytes_ += bytes;
+            break;
+        }
+        case 10:
+        case 11:
+        case 12:
+            // 序列结束、流结束、填充数据跟在所属帧的 Slice 后面
+            if (inFrame_) frame_.info.bytes += bytes;
+            else pendingBytes_ += bytes;
+            break;
+        default:
+            // AUD、SEI 等出现在帧的第一个 Slice 之前，属于下一帧
+            pendingBytes_ += bytes;
+            break;
+    }
+}
+
+void H264StreamAnalyzer::onSlice(const NaluRef &nalu, int nalType, int nalRefIdc, uint64_t bytes) {
+    // Slice 头只用到前几十个字节，没必要还原整个 head
+    const size_t len = unescapeRbsp(nalu.head + 1, std::min<size_t>(nalu.headLen - 1, 64), rbsp_);
+    H264SliceHeader sh;
+    if (!parseSliceHeader(rbsp_, len, nalType, nalRefIdc, sps_.data(), pps_.data(), sh)) {
+        // 通常是文件从 GOP 中间截断，第一个 SPS/PPS 之前的 Slice 无法解析
+        sliceErrors_++;
+        pendingBytes_ += bytes;
+        return;
+    }
+    const H264Sps &sps = sps_[pps_[sh.ppsId].spsId];
+    const int poc = poc_.compute(sps, sh);
+
+    // 同一帧的第二场：frame_num 相同、场别相反，合并成一帧
+    const bool secondField = inFrame_ && sh.firstMbInSlice == 0 && sh.fieldPic && frame_.field
+                             && frame_.bottomField != sh.bottomField && frame_.info.extra == sh.frameNum;
+    if (secondField) {
+        frame_.field = false;
+        frame_.info.poc = std::min(frame_.info.poc, poc);
+        frame_.info.ref = frame_.info.ref || nalRefIdc != 0;
+        frame_.info.bytes += pendingBytes_;
+        pendingBytes_ = 0;
+    } else if (!inFrame_ || sh.firstMbInSlice == 0) {
+        // first_mb_in_slice == 0 表示新图像的第一个 Slice (不考虑 ASO 乱序条带)
+        if (inFrame_) endFrame();
+        inFrame_ = true;
+        frame_ = Frame();
+        frame_.info.index = stats_.frameCount();
+        frame_.info.offset = nalu.offset;
+        frame_.info.key = sh.idr;
+        frame_.info.ref = nalRefIdc != 0;
+        frame_.info.extra = sh.frameNum;
+        frame_.info.poc = poc;
+        frame_.field = sh.fieldPic;
+        frame_.bottomField = sh.bottomField;
+        frame_.spsId = pps_[sh.ppsId].spsId;
+        frame_.info.bytes = pendingBytes_;
+        pendingBytes_ = 0;
+    }
+
+    frame_.info.slices++;
+    frame_.info.bytes += bytes;
+    frame_.info.type = FrameStats::mergeType(frame_.info.type, frameTypeOf(sh.sliceType));
+}
+
+void H264StreamAnalyzer::endFrame() {
+    inFrame_ = false;
+    if (activeSpsId_ < 0) {
+        activeSpsId_ = frame_.spsId;
+        stats_.setFrameRate(sps_[activeSpsId_].frameRate());
+    }
+    stats_.addFrame(frame_.info);
+}
+
+void H264StreamAnalyzer::finish() {
+    if (inFrame_) endFrame();
+    stats_.finish();
+}
+
+void H264StreamAnalyzer::printReport() const {
+    stats_.printFrameTable();
+
+    std::cout << "\n[*] 参数集" << std::endl;
+    for (const H264Sps &sps : sps_) {
+        if (!sps.valid) continue;
+        std::cout << "    SPS #" << sps.spsId << ": " << profileName(sps) << " @ Level " << sps.levelIdc / 10 << "."
+                  << sps.levelIdc % 10 << ", " << sps.width << "x" << sps.height
+                  << (sps.frameMbsOnly ? "" : " (隔行)")
+                  << ", 色度格式 " << sps.chromaFormatIdc << ", " << sps.bitDepthLuma << " bit"
+                  << ", 参考帧 " << sps.maxNumRefFrames << ", POC type " << sps.pocType;
+        if (sps.frameRate() > 0) {
+            std::cout << ", " << std::fixed << std::setprecision(3) << sps.frameRate() << " fps"
+                      << (sps.fixedFrameRate ? " (固定)" : "");
+        }
+        std::cout << std::endl;
+    }
+    for (const H264Pps &pps : pps_) {
+        if (!pps.valid) continue;
+        std::cout << "    PPS #" << pps.ppsId << ": SPS #" << pps.spsId << ", " << (pps.entropyCodingMode ? "CABAC" : "CAVLC")
+                  << ", 条带组 " << pps.numSliceGroups << ", 加权预测 " << (pps.weightedPred ? "P" : "-")
+                  << "/" << pps.weightedBipredIdc << ", init QP " << pps.picInitQp << std::endl;
+    }
+
+    stats_.printSummary(totalBytes_);
+
+    if (sliceErrors_ > 0) {
+        std::cout << "[!] " << sliceErrors_ << " 个 Slice 无法解析 (缺少 SPS/PPS 或数据损坏)" << std::endl;
+    }
+}
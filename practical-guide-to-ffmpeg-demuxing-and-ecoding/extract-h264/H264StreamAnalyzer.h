@@ -0,0 +1,58 @@
+#ifndef H264STREAMANALYZER_H
+#define H264STREAMANALYZER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "AnnexBScanner.h"
+#include "FrameStats.h"
+#include "H264Parser.h"
+
+/**
+ * @brief H.264 逐帧统计
+ *
+ * 按文件顺序接收 NALU，解析 SPS/PPS/Slice 头，把 Slice 组装成帧 (访问单元)，
+ * 组装好的帧交给 FrameStats 统计帧类型、GOP 结构和每秒码率。
+ */
+class H264StreamAnalyzer {
+public:
+    /// @param framesToPrint 逐帧表格显示的帧数，-1 表示全部显示
+    explicit H264StreamAnalyzer(int framesToPrint);
+
+    /// 按文件顺序送入一个 NALU
+    void onNalu(const NaluRef &nalu);
+
+    /// 扫描结束，结束最后一帧
+    void finish();
+
+    /// 打印逐帧表格和汇总统计
+    void printReport() const;
+
+private:
+    /// 正在组装的帧：FrameStats 需要的信息加上合并场用的字段
+    struct Frame {
+        FrameStats::Frame info;  ///< info.extra 为 frame_num
+        bool field = false;
+        bool bottomField = false;
+        int spsId = 0;
+    };
+
+    void onSlice(const NaluRef &nalu, int nalType, int nalRefIdc, uint64_t bytes);
+
+    void endFrame();
+
+    std::vector<H264Sps> sps_;
+    std::vector<H264Pps> pps_;
+    H264PocCalculator poc_;
+    uint8_t rbsp_[AnnexBScanner::HEAD_BYTES];
+
+    bool inFrame_ = false;
+    Frame frame_;
+    uint64_t pendingBytes_ = 0;    ///< 下一帧之前的 AUD/SEI/SPS/PPS
+    uint64_t totalBytes_ = 0;
+    uint64_t sliceErrors_ = 0;
+    int activeSpsId_ = -1;         ///< 第一帧引用的 SPS，帧率取自它的 VUI
+    FrameStats stats_;
+};
+
+#endif // H264STREAMANALYZER_H
@@ -0,0 +1,228 @@
+#include "HevcParser.h"
+#include "BitReader.h"
+
+// profile_tier_level(1, maxNumSubLayersMinus1)，只保留 general 部分
+static void parseProfileTierLevel(BitReader &br, int maxSubLayersMinus1, HevcSps *sps) {
+    br.skipBits(2);                       // general_profile_space
+    const bool tier = br.readFlag();
+    const int profileIdc = static_cast<int>(br.readBits(5));
+    br.skipBits(32);                      // general_profile_compatibility_flag[32]
+    br.skipBits(4);                       // progressive / interlaced / non_packed / frame_only
+    br.skipBits(32);                      // 43 位约束标志 + 1 位 inbld/reserved
+    br.skipBits(12);
+    const int levelIdc = static_cast<int>(br.readBits(8));
+    if (sps) {
+        sps->tierFlag = tier;
+        sps->profileIdc = profileIdc;
+        sps->levelIdc = levelIdc;
+    }
+
+    bool profilePresent[8] = {false};
+    bool levelPresent[8] = {false};
+    for (int i = 0; i < maxSubLayersMinus1; i++) {
+        profilePresent[i] = br.readFlag();
+        levelPresent[i] = br.readFlag();
+    }
+    if (maxSubLayersMinus1 > 0) {
+        for (int i = maxSubLayersMinus1; i < 8; i++) br.skipBits(2); // reserved_zero_2bits
+    }
+    for (int i = 0; i < maxSubLayersMinus1; i++) {
+        if (profilePresent[i]) {
+            br.skipBits(32);              // 与 general 部分相同的 88 位
+            br.skipBits(32);
+            br.skipBits(24);
+        }
+        if (levelPresent[i]) br.skipBits(8);
+    }
+}
+
+static int ceilLog2(uint32_t v) {
+    int n = 0;
+    while ((1u << n) < v) n++;
+    return n;
+}
+
+bool parseHevcVps(const uint8_t *rbsp, size_t len, HevcVps &vps) {
+    BitReader br(rbsp, len);
+    vps = HevcVps();
+
+    vps.vpsId = static_cast<int>(br.readBits(4));
+    br.skipBits(2);                       // vps_base_layer_internal_flag, vps_base_layer_available_flag
+    br.skipBits(6);                       // vps_max_layers_minus1
+    const int maxSubLayersMinus1 = static_cast<int>(br.readBits(3));
+    if (maxSubLayersMinus1 > 6) return false;
+    vps.maxSubLayers = maxSubLayersMinus1 + 1;
+    br.skipBits(1);                       // vps_temporal_id_nesting_flag
+    br.skipBits(16);                      // vps_reserved_0xffff_16bits
+    parseProfileTierLevel(br, maxSubLayersMinus1, nullptr);
+
+    const bool orderingInfoPresent = br.readFlag();
+    for (int i = orderingInfoPresent ? 0 : maxSubLayersMinus1; i <= maxSubLayersMinus1; i++) {
+        br.readUE();                      // vps_max_dec_pic_buffering_minus1
+        br.readUE();                      // vps_max_num_reorder_pics
+        br.readUE();                      // vps_max_latency_increase_plus1
+    }
+    const int maxLayerId = static_cast<int>(br.readBits(6));
+    const uint32_t numLayerSetsMinus1 = br.readUE();
+    if (numLayerSetsMinus1 > 1023) return false;
+    for (uint32_t i = 1; i <= numLayerSetsMinus1; i++) {
+        br.skipBits(maxLayerId + 1);      // layer_id_included_flag
+    }
+
+    // 后面的 HRD 参数用不到
+    vps.timingInfoPresent = br.readFlag();
+    if (vps.timingInfoPresent) {
+        vps.numUnitsInTick = br.readBits(32);
+        vps.timeScale = br.readBits(32);
+    }
+
+    vps.valid = !br.error();
+    return vps.valid;
+}
+
+bool parseHevcSps(const uint8_t *rbsp, size_t len, HevcSps &sps) {
+    BitReader br(rbsp, len);
+    sps = HevcSps();
+
+    sps.vpsId = static_cast<int>(br.readBits(4));
+    const int maxSubLayersMinus1 = static_cast<int>(br.readBits(3));
+    if (maxSubLayersMinus1 > 6) return false;
+    sps.maxSubLayers = maxSubLayersMinus1 + 1;
+    br.skipBits(1);                       // sps_temporal_id_nesting_flag
+    parseProfileTierLevel(br, maxSubLayersMinus1, &sps);
+
+    sps.spsId = static_cast<int>(br.readUE());
+    if (sps.spsId >= HEVC_MAX_SPS) return false;
+    sps.chromaFormatIdc = static_cast<int>(br.readUE());
+    if (sps.chromaFormatIdc > 3) return false;
+    if (sps.chromaFormatIdc == 3) sps.separateColourPlane = br.readFlag();
+    const uint32_t codedWidth = br.readUE();
+    const uint32_t codedHeight = br.readUE();
+
+    int cropLeft = 0, cropRight = 0, cropTop = 0, cropBottom = 0;
+    if (br.readFlag()) {                  // conformance_window_flag
+        cropLeft = static_cast<int>(br.readUE());
+        cropRight = static_cast<int>(br.readUE());
+        cropTop = static_cast<int>(br.readUE());
+        cropBottom = static_cast<int>(br.readUE());
+    }
+    // 裁剪单位取决于色度采样方式 (表 6-1)
+    const int chromaArrayType = sps.separateColourPlane ? 0 : sps.chromaFormatIdc;
+    const int subWidthC = (chromaArrayType == 1 || chromaArrayType == 2) ? 2 : 1;
+    const int subHeightC = (chromaArrayType == 1) ? 2 : 1;
+    sps.width = static_cast<int>(codedWidth) - subWidthC * (cropLeft + cropRight);
+    sps.height = static_cast<int>(codedHeight) - subHeightC * (cropTop + cropBottom);
+
+    sps.bitDepthLuma = static_cast<int>(br.readUE()) + 8;
+    sps.bitDepthChroma = static_cast<int>(br.readUE()) + 8;
+    sps.log2MaxPocLsb = static_cast<int>(br.readUE()) + 4;
+    if (sps.log2MaxPocLsb > 16) return false;
+
+    const bool orderingInfoPresent = br.readFlag();
+    for (int i = orderingInfoPresent ? 0 : maxSubLayersMinus1; i <= maxSubLayersMinus1; i++) {
+        br.readUE();                      // sps_max_dec_pic_buffering_minus1
+        br.readUE();                      // sps_max_num_reorder_pics
+        br.readUE();                      // sps_max_latency_increase_plus1
+    }
+    const int log2MinCbSize = static_cast<int>(br.readUE()) + 3;
+    sps.log2CtbSize = log2MinCbSize + static_cast<int>(br.readUE());
+    if (sps.log2CtbSize < 4 || sps.log2CtbSize > 6) return false;
+
+    // Slice 片段地址的位数由 CTB 个数决定
+    const uint32_t ctb = 1u << sps.log2CtbSize;
+    sps.picSizeInCtbs = static_cast<int>(((codedWidth + ctb - 1) / ctb) * ((codedHeight + ctb - 1) / ctb));
+
+    sps.valid = !br.error();
+    return sps.valid;
+}
+
+bool parseHevcPps(const uint8_t *rbsp, size_t len, HevcPps &pps) {
+    BitReader br(rbsp, len);
+    pps = HevcPps();
+
+    pps.ppsId = static_cast<int>(br.readUE());
+    pps.spsId = static_cast<int>(br.readUE());
+    if (pps.ppsId >= HEVC_MAX_PPS || pps.spsId >= HEVC_MAX_SPS) return false;
+    pps.dependentSliceSegmentsEnabled = br.readFlag();
+    pps.outputFlagPresent = br.readFlag();
+    pps.numExtraSliceHeaderBits = static_cast<int>(br.readBits(3));
+    pps.signDataHiding = br.readFlag();
+    pps.cabacInitPresent = br.readFlag();
+    br.readUE();                          // num_ref_idx_l0_default_active_minus1
+    br.readUE();                          // num_ref_idx_l1_default_active_minus1
+    pps.initQp = br.readSE() + 26;
+
+    pps.valid = !br.error();
+    return pps.valid;
+}
+
+bool parseHevcSliceHeader(const uint8_t *rbsp, size_t len, int nalType, int temporalId, const HevcSps *spsTable,
+                          const HevcPps *ppsTable, HevcSliceHeader &sh) {
+    BitReader br(rbsp, len);
+    sh = HevcSliceHeader();
+    sh.nalType = nalType;
+    sh.temporalId = temporalId;
+
+    sh.firstSliceSegmentInPic = br.readFlag();
+    if (hevcIsIrap(nalType)) br.skipBits(1); // no_output_of_prior_pics_flag
+    const uint32_t ppsId = br.readUE();
+    if (ppsId >= HEVC_MAX_PPS || !ppsTable[ppsId].valid) return false;
+    sh.ppsId = static_cast<int>(ppsId);
+
+    const HevcPps &pps = ppsTable[ppsId];
+    const HevcSps &sps = spsTable[pps.spsId];
+    if (!sps.valid) return false;
+
+    if (!sh.firstSliceSegmentInPic) {
+        if (pps.dependentSliceSegmentsEnabled) sh.dependentSliceSegment = br.readFlag();
+        sh.sliceSegmentAddress = br.readBits(ceilLog2(static_cast<uint32_t>(sps.picSizeInCtbs)));
+    }
+    if (!sh.dependentSliceSegment) {
+        br.skipBits(pps.numExtraSliceHeaderBits); // slice_reserved_flag
+        const uint32_t sliceType = br.readUE();
+        if (sliceType > 2) return false;
+        sh.sliceType = static_cast<int>(sliceType);
+        if (pps.outputFlagPresent) br.skipBits(1);  // pic_output_flag
+        if (sps.separateColourPlane) br.skipBits(2); // colour_plane_id
+        if (!hevcIsIdr(nalType)) sh.pocLsb = static_cast<int>(br.readBits(sps.log2MaxPocLsb));
+    }
+    return !br.error();
+}
+
+std::string hevcProfileName(const HevcSps &sps) {
+    switch (sps.profileIdc) {
+        case 1: return "Main";
+        case 2: return "Main 10";
+        case 3: return "Main Still Picture";
+        case 4: return "Range Extensions";
+        case 5: return "High Throughput";
+        case 9: return "Screen Content";
+        default: return "Profile " + std::to_string(sps.profileIdc);
+    }
+}
+
+int HevcPocCalculator::compute(const HevcSps &sps, const HevcSliceHeader &sh) {
+    const int maxLsb = 1 << sps.log2MaxPocLsb;
+    const int type = sh.nalType;
+
+    // 8.3.1: IDR、BLA 以及码流开头 / EOS 之后的 CRA，NoRaslOutputFlag 为 1，POC 高位清零
+    int pocMsb;
+    if (hevcIsIrap(type) && (hevcIsIdr(type) || type < HEVC_NAL_IDR_W_RADL || firstPicture_)) {
+        pocMsb = 0;
+    } else if (sh.pocLsb < prevPocLsb_ && prevPocLsb_ - sh.pocLsb >= maxLsb / 2) {
+        pocMsb = prevPocMsb_ + maxLsb;
+    } else if (sh.pocLsb > prevPocLsb_ && sh.pocLsb - prevPocLsb_ > maxLsb / 2) {
+        pocMsb = prevPocMsb_ - maxLsb;
+    } else {
+        pocMsb = prevPocMsb_;
+    }
+    firstPicture_ = false;
+
+    // prevTid0Pic: TemporalId 为 0，且不是 RASL / RADL / 子层非参考图像
+    const bool leading = type >= HEVC_NAL_RADL_N && type <= HEVC_NAL_RASL_R;
+    if (sh.temporalId == 0 && !leading && !hevcIsSubLayerNonRef(type)) {
+        prevPocLsb_ = sh.pocLsb;
+        prevPocMsb_ = pocMsb;
+    }
+    return pocMsb + sh.pocLsb;
+}
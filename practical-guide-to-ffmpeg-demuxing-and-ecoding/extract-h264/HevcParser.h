@@ -0,0 +1,165 @@
+#ifndef HEVCPARSER_H
+#define HEVCPARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// HEVC 的 NAL 单元类型 (H.265 表 7-1 中用到的部分)
+enum HevcNalType {
+    HEVC_NAL_TRAIL_N = 0,
+    HEVC_NAL_RADL_N = 6,
+    HEVC_NAL_RASL_R = 9,
+    HEVC_NAL_BLA_W_LP = 16,
+    HEVC_NAL_IDR_W_RADL = 19,
+    HEVC_NAL_IDR_N_LP = 20,
+    HEVC_NAL_CRA_NUT = 21,
+    HEVC_NAL_RSV_IRAP_23 = 23,
+    HEVC_NAL_VPS = 32,
+    HEVC_NAL_SPS = 33,
+    HEVC_NAL_PPS = 34,
+    HEVC_NAL_AUD = 35,
+    HEVC_NAL_EOS = 36,
+    HEVC_NAL_EOB = 37,
+    HEVC_NAL_FD = 38,
+    HEVC_NAL_SEI_PREFIX = 39,
+    HEVC_NAL_SEI_SUFFIX = 40,
+};
+
+/// 2 字节的 NALU 头: [F(1) | Type(6) | LayerId(6) | TID+1(3)]
+struct HevcNalHeader {
+    int forbidden = 0;
+    int type = 0;
+    int layerId = 0;
+    int temporalId = 0;   ///< nuh_temporal_id_plus1 - 1
+};
+
+inline HevcNalHeader parseHevcNalHeader(uint8_t b0, uint8_t b1) {
+    HevcNalHeader h;
+    h.forbidden = (b0 >> 7) & 0x01;
+    h.type = (b0 >> 1) & 0x3F;
+    h.layerId = ((b0 & 0x01) << 5) | (b1 >> 3);
+    h.temporalId = (b1 & 0x07) - 1;
+    return h;
+}
+
+/// 0~31 为 VCL (Slice)，其中 0~9 与 16~21 已定义
+inline bool hevcIsVcl(int type) { return type < 32; }
+
+/// 帧内随机接入点：BLA / IDR / CRA
+inline bool hevcIsIrap(int type) { return type >= HEVC_NAL_BLA_W_LP && type <= HEVC_NAL_RSV_IRAP_23; }
+
+inline bool hevcIsIdr(int type) { return type == HEVC_NAL_IDR_W_RADL || type == HEVC_NAL_IDR_N_LP; }
+
+/// 子层非参考图像 (TRAIL_N、TSA_N、STSA_N、RADL_N、RASL_N 以及保留的 RSV_VCL_N10/12/14)
+inline bool hevcIsSubLayerNonRef(int type) { return type <= 14 && type % 2 == 0; }
+
+/// 视频参数集 (VPS) 中分析需要的字段
+struct HevcVps {
+    bool valid = false;
+    int vpsId = 0;
+    int maxSubLayers = 1;
+    bool timingInfoPresent = false;
+    uint32_t numUnitsInTick = 0;
+    uint32_t timeScale = 0;
+
+    /// VPS 给出的帧率，没有时返回 0 (HEVC 的一个 tick 就是一帧，与 H.264 不同)
+    double frameRate() const {
+        return (timingInfoPresent && numUnitsInTick > 0) ? static_cast<double>(timeScale) / numUnitsInTick : 0.0;
+    }
+};
+
+/// 序列参数集 (SPS) 中分析需要的字段
+struct HevcSps {
+    bool valid = false;
+    int vpsId = 0;
+    int spsId = 0;
+    int maxSubLayers = 1;
+    int profileIdc = 0;
+    bool tierFlag = false;         ///< false: Main tier, true: High tier
+    int levelIdc = 0;              ///< general_level_idc，等于级别 x 30
+    int chromaFormatIdc = 1;
+    bool separateColourPlane = false;
+    int width = 0;                 ///< 裁剪后的宽度
+    int height = 0;                ///< 裁剪后的高度
+    int bitDepthLuma = 8;
+    int bitDepthChroma = 8;
+    int log2MaxPocLsb = 4;
+    int log2CtbSize = 4;
+    int picSizeInCtbs = 0;
+};
+
+/// 图像参数集 (PPS) 中分析需要的字段
+struct HevcPps {
+    bool valid = false;
+    int ppsId = 0;
+    int spsId = 0;
+    bool dependentSliceSegmentsEnabled = false;
+    bool outputFlagPresent = false;
+    int numExtraSliceHeaderBits = 0;
+    bool signDataHiding = false;
+    bool cabacInitPresent = false;
+    int initQp = 26;
+};
+
+/// Slice 片段头部从开头解析到 slice_pic_order_cnt_lsb 为止
+struct HevcSliceHeader {
+    int nalType = 0;
+    int temporalId = 0;
+    bool firstSliceSegmentInPic = false;
+    int ppsId = 0;
+    bool dependentSliceSegment = false;  ///< 依赖片段没有自己的 slice_type，沿用前一个片段
+    uint32_t sliceSegmentAddress = 0;
+    int sliceType = 2;             ///< 0 B, 1 P, 2 I
+    int pocLsb = 0;
+};
+
+/// VPS/SPS/PPS 的 id 上限 (标准规定)
+const int HEVC_MAX_VPS = 16;
+const int HEVC_MAX_SPS = 16;
+const int HEVC_MAX_PPS = 64;
+
+/**
+ * @brief 解析 VPS (到 vps_timing_info 为止)
+ * @param rbsp 去掉防竞争字节后的数据，不含 2 字节 NALU 头
+ */
+bool parseHevcVps(const uint8_t *rbsp, size_t len, HevcVps &vps);
+
+/// 解析 SPS (到 CTB 大小为止，不解析 VUI；帧率取自 VPS)
+bool parseHevcSps(const uint8_t *rbsp, size_t len, HevcSps &sps);
+
+/// 解析 PPS (到 init_qp 为止)
+bool parseHevcPps(const uint8_t *rbsp, size_t len, HevcPps &pps);
+
+/**
+ * @brief 解析 Slice 片段头部
+ * @param spsTable 以 sps_id 为下标的 SPS 表 (HEVC_MAX_SPS 个)
+ * @param ppsTable 以 pps_id 为下标的 PPS 表 (HEVC_MAX_PPS 个)
+ * @return bool 引用的 SPS/PPS 不存在或数据不完整时返回 false
+ */
+bool parseHevcSliceHeader(const uint8_t *rbsp, size_t len, int nalType, int temporalId, const HevcSps *spsTable,
+                          const HevcPps *ppsTable, HevcSliceHeader &sh);
+
+/// 档次名称，如 "Main"、"Main 10"
+std::string hevcProfileName(const HevcSps &sps);
+
+/**
+ * @brief 图像顺序号 (POC) 计算，按 H.265 8.3.1 节实现
+ *
+ * 需要按解码顺序对每个图像的第一个 Slice 片段调用一次。
+ * 码流的第一个图像以及 EOS 之后的第一个图像是 NoRaslOutputFlag 为 1 的 IRAP，POC 高位清零。
+ */
+class HevcPocCalculator {
+public:
+    int compute(const HevcSps &sps, const HevcSliceHeader &sh);
+
+    /// 遇到 EOS 时调用，下一个 IRAP 重新开始计数
+    void onEndOfSequence() { firstPicture_ = true; }
+
+private:
+    bool firstPicture_ = true;
+    int prevPocLsb_ = 0;    ///< 上一个 TemporalId 为 0 的参考图像 (prevTid0Pic)
+    int prevPocMsb_ = 0;
+};
+
+#endif // HEVCPARSER_H
@@ -0,0 +1,156 @@
+#include "HevcStreamAnalyzer.h"
+#include "BitReader.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+/// slice_type 对应的帧类型：0 B, 1 P, 2 I
+static char frameTypeOf(int sliceType) {
+    switch (sliceType) {
+        case 0: return 'B';
+        case 1: return 'P';
+        default: return 'I';
+    }
+}
+
+HevcStreamAnalyzer::HevcStreamAnalyzer(int framesToPrint)
+    : vps_(HEVC_MAX_VPS), sps_(HEVC_MAX_SPS), pps_(HEVC_MAX_PPS), stats_(framesToPrint, "TID") {
+}
+
+void HevcStreamAnalyzer::onNalu(const NaluRef &nalu) {
+    const uint64_t bytes = nalu.size + nalu.startCodeLen;
+    totalBytes_ += bytes;
+    if (nalu.headLen < 2) {
+        pendingBytes_ += bytes;
+        return;
+    }
+
+    const HevcNalHeader header = parseHevcNalHeader(nalu.head[0], nalu.head[1]);
+    if (header.layerId > 0) {
+        // 增强层 / 多视点的 NALU 跟在基本层图像后面
+        if (inFrame_) frame_.bytes += bytes;
+        else pendingBytes_ += bytes;
+        return;
+    }
+
+    if (hevcIsVcl(header.type)) {
+        onSlice(nalu, header, bytes);
+        return;
+    }
+    switch (header.type) {
+        case HEVC_NAL_VPS: {
+            HevcVps vps;
+            size_t len = unescapeRbsp(nalu.head + 2, nalu.headLen - 2, rbsp_);
+            if (parseHevcVps(rbsp_, len, vps)) vps_[vps.vpsId] = vps;
+            pendingBytes_ += bytes;
+            break;
+        }
+        case HEVC_NAL_SPS: {
+            HevcSps sps;
+            size_t len = unescapeRbsp(nalu.head + 2, nalu.headLen - 2, rbsp_);
+            if (parseHevcSps(rbsp_, len, sps)) sps_[sps.spsId] = sps;
+            pendingBytes_ += bytes;
+            break;
+        }
+        case HEVC_NAL_PPS: {
+            HevcPps pps;
+            size_t len = unescapeRbsp(nalu.head + 2, nalu.headLen - 2, rbsp_);
+            if (parseHevcPps(rbsp_, len, pps)) pps_[pps.ppsId] = pps;
+            pendingBytes_ += bytes;
+            break;
+        }
+        case HEVC_NAL_EOS:
+            poc_.onEndOfSequence();
+            // fallthrough
+        case HEVC_NAL_EOB:
+        case HEVC_NAL_FD:
+        case HEVC_NAL_SEI_SUFFIX:
+            // 序列结束、流结束、填充数据和后缀 SEI 跟在所属帧的 Slice 后面
+            if (inFrame_) frame_.bytes += bytes;
+            else pendingBytes_ += bytes;
+            break;
+        default:
+            // AUD、前缀 SEI 等出现在帧的第一个 Slice 之前，属于下一帧
+            pendingBytes_ += bytes;
+            break;
+    }
+}
+
+void HevcStreamAnalyzer::onSlice(const NaluRef &nalu, const HevcNalHeader &header, uint64_t bytes) {
+    // Slice 片段头只用到前几十个字节，没必要还原整个 head
+    const size_t len = unescapeRbsp(nalu.head + 2, std::min<size_t>(nalu.headLen - 2, 64), rbsp_);
+    HevcSliceHeader sh;
+    if (!parseHevcSliceHeader(rbsp_, len, header.type, header.temporalId, sps_.data(), pps_.data(), sh)) {
+        // 通常是文件从 GOP 中间截断，第一个 SPS/PPS 之前的 Slice 无法解析
+        sliceErrors_++;
+        pendingBytes_ += bytes;
+        return;
+    }
+
+    if (!inFrame_ || sh.firstSliceSegmentInPic) {
+        if (inFrame_) endFrame();
+        inFrame_ = true;
+        frame_ = FrameStats::Frame();
+        frame_.index = stats_.frameCount();
+        frame_.offset = nalu.offset;
+        frame_.key = hevcIsIrap(header.type);
+        frame_.ref = !hevcIsSubLayerNonRef(header.type);
+        frame_.extra = header.temporalId;
+        frameSpsId_ = pps_[sh.ppsId].spsId;
+        frame_.poc = poc_.compute(sps_[frameSpsId_], sh);
+        frame_.bytes = pendingBytes_;
+        pendingBytes_ = 0;
+    }
+
+    frame_.slices++;
+    frame_.bytes += bytes;
+    // 依赖片段沿用前一个片段的 slice_type
+    if (!sh.dependentSliceSegment) frame_.type = FrameStats::mergeType(frame_.type, frameTypeOf(sh.sliceType));
+}
+
+void HevcStreamAnalyzer::endFrame() {
+    inFrame_ = false;
+    if (!frameRateSet_) {
+        frameRateSet_ = true;
+        stats_.setFrameRate(vps_[sps_[frameSpsId_].vpsId].frameRate());
+    }
+    stats_.addFrame(frame_);
+}
+
+void HevcStreamAnalyzer::finish() {
+    if (inFrame_) endFrame();
+    stats_.finish();
+}
+
+void HevcStreamAnalyzer::printReport() const {
+    stats_.printFrameTable();
+
+    std::cout << "\n[*] 参数集" << std::endl;
+    for (const HevcVps &vps : vps_) {
+        if (!vps.valid) continue;
+        std::cout << "    VPS #" << vps.vpsId << ": 时域子层 " << vps.maxSubLayers;
+        if (vps.frameRate() > 0) std::cout << ", " << std::fixed << std::setprecision(3) << vps.frameRate() << " fps";
+        std::cout << std::endl;
+    }
+    for (const HevcSps &sps : sps_) {
+        if (!sps.valid) continue;
+        std::cout << "    SPS #" << sps.spsId << ": VPS #" << sps.vpsId << ", " << hevcProfileName(sps) << " @ "
+                  << (sps.tierFlag ? "High" : "Main") << " tier, Level " << sps.levelIdc / 30 << "."
+                  << (sps.levelIdc % 30) / 3 << ", " << sps.width << "x" << sps.height
+                  << ", 色度格式 " << sps.chromaFormatIdc << ", " << sps.bitDepthLuma << " bit"
+                  << ", CTB " << (1 << sps.log2CtbSize) << ", 时域子层 " << sps.maxSubLayers << std::endl;
+    }
+    for (const HevcPps &pps : pps_) {
+        if (!pps.valid) continue;
+        std::cout << "    PPS #" << pps.ppsId << ": SPS #" << pps.spsId << ", 依赖片段 "
+                  << (pps.dependentSliceSegmentsEnabled ? "Y" : "-") << ", 符号隐藏 " << (pps.signDataHiding ? "Y" : "-")
+                  << ", init QP " << pps.initQp << std::endl;
+    }
+
+    stats_.printSummary(totalBytes_);
+
+    if (sliceErrors_ > 0) {
+        std::cout << "[!] " << sliceErrors_ << " 个 Slice 无法解析 (缺少 VPS/SPS/PPS 或数据损坏)" << std::endl;
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef HEVCSTREAMANALYZER_H
+#define HEVCSTREAMANALYZER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "AnnexBScanner.h"
+#include "FrameStats.h"
+#include "HevcParser.h"
+
+/**
+ * @brief HEVC 逐帧统计
+ *
+ * 与 H264StreamAnalyzer 相同的用法：按文件顺序接收 NALU，解析 VPS/SPS/PPS/Slice 片段头，
+ * 把 Slice 片段组装成帧 (访问单元) 后交给 FrameStats。
+ * 关键帧为 IRAP (IDR/CRA/BLA)，逐帧表格的附加列为 TemporalId。
+ *
+ * 只统计基本层 (nuh_layer_id == 0)，增强层的 NALU 算作所在帧的字节数。
+ */
+class HevcStreamAnalyzer {
+public:
+    /// @param framesToPrint 逐帧表格显示的帧数，-1 表示全部显示
+    explicit HevcStreamAnalyzer(int framesToPrint);
+
+    /// 按文件顺序送入一个 NALU
+    void onNalu(const NaluRef &nalu);
+
+    /// 扫描结束，结束最后一帧
+    void finish();
+
+    /// 打印逐帧表格和汇总统计
+    void printReport() const;
+
+private:
+    void onSlice(const NaluRef &nalu, const HevcNalHeader &header, uint64_t bytes);
+
+    void endFrame();
+
+    std::vector<HevcVps> vps_;
+    std::vector<HevcSps> sps_;
+    std::vector<HevcPps> pps_;
+    HevcPocCalculator poc_;
+    uint8_t rbsp_[AnnexBScanner::HEAD_BYTES];
+
+    bool inFrame_ = false;
+    FrameStats::Frame frame_;      ///< frame_.extra 为 TemporalId
+    int frameSpsId_ = 0;
+    uint64_t pendingBytes_ = 0;    ///< 下一帧之前的 AUD/前缀 SEI/VPS/SPS/PPS
+    uint64_t totalBytes_ = 0;
+    uint64_t sliceErrors_ = 0;
+    bool frameRateSet_ = false;    ///< 第一帧时从 SPS 引用的 VPS 取得帧率
+    FrameStats stats_;
+};
+
+#endif // HEVCSTREAMANALYZER_H
@@ -0,0 +1,296 @@
+#include "NaluIndex.h"
+#include "AnnexBScanner.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <sys/stat.h>
+
+/// 每个线程至少扫描这么多字节，小文件不值得开很多线程
+static const size_t MIN_CHUNK_SIZE = 4 * 1024 * 1024;
+
+static const char INDEX_MAGIC[8] = {'H', '2', '6', '4', 'I', 'D', 'X', '\0'};
+static const uint32_t INDEX_VERSION = 2;
+static const size_t HEADER_BYTES = 48;
+
+/// 校验和覆盖源文件开头这么多字节，同样大小、同样修改时间的文件被改写也能发现
+static const size_t CHECKSUM_BYTES = 64 * 1024;
+static const size_t ENTRY_BYTES = 20;
+
+/// 读写索引时每批处理的记录数
+static const size_t IO_BATCH = 4096;
+
+static void putLE32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static void putLE64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static uint32_t getLE32(const uint8_t *p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static uint64_t getLE64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+// FNV-1a 64
+static uint64_t checksum(const uint8_t *data, size_t size) {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        h ^= data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool NaluIndex::stampSource(const std::string &filePath, SourceStamp &stamp) {
+    // MinGW 的 struct stat 里 st_size 只有 32 位，超过 2GB 的文件会截断
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(filePath.c_str(), &st) != 0) return false;
+#else
+    struct stat st;
+    if (stat(filePath.c_str(), &st) != 0) return false;
+#endif
+    FILE *f = fopen(filePath.c_str(), "rb");
+    if (!f) return false;
+    std::vector<uint8_t> head(CHECKSUM_BYTES);
+    const size_t n = fread(head.data(), 1, head.size(), f);
+    fclose(f);
+    stamp.size = static_cast<uint64_t>(st.st_size);
+    stamp.mtime = static_cast<int64_t>(st.st_mtime);
+    stamp.headChecksum = checksum(head.data(), n);
+    return true;
+}
+
+static bool isVcl(int type) {
+    return type == 1 || type == 5;
+}
+
+static uint32_t clampSize(uint64_t size) {
+    return static_cast<uint32_t>(std::min<uint64_t>(size, UINT32_MAX));
+}
+
+/// 扫描 [begin, end) 一块，只保留 0x01 落在本块内的起始码
+static void scanChunk(const uint8_t *data, size_t begin, size_t end, std::vector<NaluIndexEntry> &out) {
+    // 往前多看 3 个字节：起始码的 00 00 (00) 在上一块末尾、0x01 在本块开头时也能识别
+    const size_t from = begin >= 3 ? begin - 3 : 0;
+    AnnexBScanner scanner([&](const NaluRef &nalu) {
+        if (nalu.offset + nalu.startCodeLen - 1 < begin) return;
+        NaluIndexEntry e;
+        e.offset = nalu.offset;
+        e.startCodeLen = static_cast<uint8_t>(nalu.startCodeLen);
+        e.size = clampSize(nalu.size);
+        if (nalu.headLen > 0) e.type = nalu.head[0] & 0x1F;
+        // first_mb_in_slice 是 ue(v)，等于 0 时编码为单个 1 比特
+        if (nalu.headLen > 1 && isVcl(e.type) && (nalu.head[1] & 0x80)) e.flags |= NaluIndex::FLAG_FIRST_SLICE;
+        out.push_back(e);
+    }, from);
+    if (end > from) scanner.feed(data + from, end - from);
+    scanner.finish();
+}
+
+/// 块的最后一个 NALU 被块边界截断了，按下一个起始码的位置重新计算长度和头部
+static void fixBoundaryEntry(const uint8_t *data, uint64_t nextOffset, NaluIndexEntry &e) {
+    const uint64_t start = e.offset + e.startCodeLen;
+    uint64_t end = nextOffset;
+    while (end > start && data[end - 1] == 0x00) end--; // 去掉末尾补零
+    e.size = clampSize(end - start);
+    e.type = (end > start) ? (data[start] & 0x1F) : 0;
+    e.flags = 0;
+    if (end > start + 1 && isVcl(e.type) && (data[start + 1] & 0x80)) e.flags |= NaluIndex::FLAG_FIRST_SLICE;
+}
+
+bool NaluIndex::build(const std::string &filePath, int threads, std::string *error) {
+    MappedFile file;
+    if (!file.open(filePath.c_str())) {
+        if (error) *error = "无法映射文件";
+        return false;
+    }
+    entries_.clear();
+    const uint8_t *data = file.data();
+    const size_t size = file.size();
+    if (!stampSource(filePath, stamp_)) {
+        if (error) *error = "无法读取文件信息";
+        return false;
+    }
+    // 以实际映射的内容为准
+    stamp_.size = size;
+    stamp_.headChecksum = checksum(data, std::min(size, CHECKSUM_BYTES));
+
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(1, std::min<int>(threads, static_cast<int>(std::max<size_t>(1, size / MIN_CHUNK_SIZE))));
+    threadsUsed_ = threads;
+
+    std::vector<std::vector<NaluIndexEntry>> chunks(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        const size_t begin = static_cast<size_t>(static_cast<uint64_t>(size) * t / threads);
+        const size_t end = static_cast<size_t>(static_cast<uint64_t>(size) * (t + 1) / threads);
+        workers.emplace_back(scanChunk, data, begin, end, std::ref(chunks[t]));
+    }
+    for (std::thread &w : workers) w.join();
+
+    // 按顺序合并，前一块的最后一个 NALU 一直延伸到后一块的第一个起始码
+    size_t total = 0;
+    for (const auto &c : chunks) total += c.size();
+    entries_.reserve(total);
+    for (int t = 0; t < threads; t++) {
+        std::vector<NaluIndexEntry> &c = chunks[t];
+        if (c.empty()) continue; // 整块都在一个大 NALU 里
+        if (t > 0 && !entries_.empty()) fixBoundaryEntry(data, c.front().offset, entries_.back());
+        entries_.insert(entries_.end(), c.begin(), c.end());
+        std::vector<NaluIndexEntry>().swap(c);
+    }
+    if (threads > 1 && !entries_.empty()) fixBoundaryEntry(data, size, entries_.back());
+
+    assignAccessUnits();
+    return true;
+}
+
+void NaluIndex::assignAccessUnits() {
+    // 7.4.1.2.3：上一帧的 Slice 之后出现 AUD/SEI/SPS/PPS 等，
+    // 或出现 first_mb_in_slice == 0 的 Slice，就是新访问单元的开始
+    uint32_t au = 0;
+    bool seenVcl = false;
+    size_t auStart = 0;
+    for (size_t i = 0; i < entries_.size(); i++) {
+        NaluIndexEntry &e = entries_[i];
+        e.flags &= ~(FLAG_AU_START | FLAG_KEY);
+
+        bool startsAu;
+        if (i == 0) {
+            startsAu = true;
+        } else if (isVcl(e.type)) {
+            startsAu = seenVcl && (e.flags & FLAG_FIRST_SLICE);
+        } else if (e.type == 6 || e.type == 7 || e.type == 8 || e.type == 9 || (e.type >= 14 && e.type <= 18)) {
+            startsAu = seenVcl;
+        } else {
+            startsAu = false;
+        }
+
+        if (startsAu) {
+            if (i > 0) au++;
+            seenVcl = false;
+            auStart = i;
+            e.flags |= FLAG_AU_START;
+        }
+        e.auId = au;
+        if (isVcl(e.type)) seenVcl = true;
+        if (e.type == 5) entries_[auStart].flags |= FLAG_KEY;
+    }
+}
+
+bool NaluIndex::save(const std::string &indexPath, std::string *error) const {
+    FILE *f = fopen(indexPath.c_str(), "wb");
+    if (!f) {
+        if (error) *error = "无法创建索引文件";
+        return false;
+    }
+
+    uint8_t header[HEADER_BYTES];
+    memcpy(header, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    putLE32(header + 8, INDEX_VERSION);
+    putLE32(header + 12, static_cast<uint32_t>(ENTRY_BYTES));
+    putLE64(header + 16, stamp_.size);
+    putLE64(header + 24, static_cast<uint64_t>(stamp_.mtime));
+    putLE64(header + 32, stamp_.headChecksum);
+    putLE64(header + 40, entries_.size());
+    bool ok = fwrite(header, 1, HEADER_BYTES, f) == HEADER_BYTES;
+
+    std::vector<uint8_t> buf(IO_BATCH * ENTRY_BYTES);
+    for (size_t i = 0; ok && i < entries_.size(); i += IO_BATCH) {
+        const size_t n = std::min(IO_BATCH, entries_.size() - i);
+        for (size_t k = 0; k < n; k++) {
+            const NaluIndexEntry &e = entries_[i + k];
+            uint8_t *p = buf.data() + k * ENTRY_BYTES;
+            putLE64(p, e.offset);
+            putLE32(p + 8, e.size);
+            putLE32(p + 12, e.auId);
+            p[16] = e.type;
+            p[17] = e.startCodeLen;
+            p[18] = e.flags;
+            p[19] = 0;
+        }
+        ok = fwrite(buf.data(), ENTRY_BYTES, n, f) == n;
+    }
+
+    ok = fclose(f) == 0 && ok;
+    if (!ok && error) *error = "写入索引文件失败";
+    return ok;
+}
+
+bool NaluIndex::load(const std::string &indexPath, const std::string &filePath, std::string *error) {
+    SourceStamp current;
+    if (!stampSource(filePath, current)) {
+        if (error) *error = "无法读取源文件";
+        return false;
+    }
+    FILE *f = fopen(indexPath.c_str(), "rb");
+    if (!f) {
+        if (error) *error = "索引文件不存在";
+        return false;
+    }
+
+    uint8_t header[HEADER_BYTES];
+    if (fread(header, 1, HEADER_BYTES, f) != HEADER_BYTES || memcmp(header, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0
+        || getLE32(header + 8) != INDEX_VERSION || getLE32(header + 12) != ENTRY_BYTES) {
+        if (error) *error = "不是有效的索引文件";
+        fclose(f);
+        return false;
+    }
+    if (getLE64(header + 16) != current.size || static_cast<int64_t>(getLE64(header + 24)) != current.mtime
+        || getLE64(header + 32) != current.headChecksum) {
+        if (error) *error = "索引已过期 (源文件大小、修改时间或内容不一致)";
+        fclose(f);
+        return false;
+    }
+
+    const uint64_t count = getLE64(header + 40);
+    std::vector<NaluIndexEntry> entries;
+    entries.reserve(static_cast<size_t>(count));
+    std::vector<uint8_t> buf(IO_BATCH * ENTRY_BYTES);
+    while (entries.size() < count) {
+        const size_t n = static_cast<size_t>(std::min<uint64_t>(IO_BATCH, count - entries.size()));
+        if (fread(buf.data(), ENTRY_BYTES, n, f) != n) {
+            if (error) *error = "索引文件不完整";
+            fclose(f);
+            return false;
+        }
+        for (size_t k = 0; k < n; k++) {
+            const uint8_t *p = buf.data() + k * ENTRY_BYTES;
+            NaluIndexEntry e;
+            e.offset = getLE64(p);
+            e.size = getLE32(p + 8);
+            e.auId = getLE32(p + 12);
+            e.type = p[16];
+            e.startCodeLen = p[17];
+            e.flags = p[18];
+            entries.push_back(e);
+        }
+    }
+    fclose(f);
+
+    entries_.swap(entries);
+    stamp_ = current;
+    threadsUsed_ = 0;
+    return true;
+}
+
+std::vector<size_t> NaluIndex::keyEntries() const {
+    std::vector<size_t> keys;
+    for (size_t i = 0; i < entries_.size(); i++) {
+        if (entries_[i].flags & FLAG_KEY) keys.push_back(i);
+    }
+    return keys;
+}
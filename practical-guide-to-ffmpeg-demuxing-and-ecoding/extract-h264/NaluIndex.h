@@ -0,0 +1,80 @@
+#ifndef NALUINDEX_H
+#define NALUINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// 索引中的一条 NALU 记录
+struct NaluIndexEntry {
+    uint64_t offset = 0;       ///< 起始码在文件中的偏移
+    uint32_t size = 0;         ///< NALU 长度 (含头部，不含起始码和末尾补零)
+    uint32_t auId = 0;         ///< 所属访问单元 (帧) 的序号
+    uint8_t type = 0;          ///< nal_unit_type
+    uint8_t startCodeLen = 0;  ///< 3 或 4
+    uint8_t flags = 0;         ///< NaluIndex::FLAG_*
+};
+
+/**
+ * @brief Annex B 文件的 NALU / 访问单元索引
+ *
+ * build() 把内存映射的文件切成若干块，每块一个线程用 AnnexBScanner 扫描，
+ * 再按顺序合并：修正跨块的 NALU 长度，并按 H.264 7.4.1.2.3 划分访问单元。
+ *
+ * 索引可以保存成旁路文件 (默认 "<文件名>.idx")，之后 load() 直接读回，
+ * 不用重新扫描就能定位任意 IDR。文件格式 (小端)：
+ *   头部 48 字节: "H264IDX\0" | 版本 u32 | 每条记录字节数 u32 | 源文件大小 u64 | 源文件修改时间 i64
+ *                | 源文件开头 64KB 的校验和 u64 | 记录数 u64
+ *   每条记录 20 字节: offset u64 | size u32 | auId u32 | type u8 | startCodeLen u8 | flags u8 | 保留 u8
+ */
+class NaluIndex {
+public:
+    static const uint8_t FLAG_AU_START = 0x01;  ///< 访问单元的第一个 NALU
+    static const uint8_t FLAG_KEY = 0x02;       ///< 包含 IDR 的访问单元的第一个 NALU
+    static const uint8_t FLAG_FIRST_SLICE = 0x04; ///< first_mb_in_slice == 0 的 Slice
+
+    /// 旁路索引文件的默认路径
+    static std::string sidecarPath(const std::string &filePath) { return filePath + ".idx"; }
+
+    /**
+     * @brief 并行扫描文件建立索引
+     * @param threads 线程数，<= 0 表示 CPU 核数 (文件太小时会自动减少)
+     */
+    bool build(const std::string &filePath, int threads, std::string *error);
+
+    bool save(const std::string &indexPath, std::string *error) const;
+
+    /// 读取索引；记录的源文件大小、修改时间或开头内容的校验和与 filePath 当前的不同，说明索引已过期，返回 false
+    bool load(const std::string &indexPath, const std::string &filePath, std::string *error);
+
+    const std::vector<NaluIndexEntry> &entries() const { return entries_; }
+
+    uint64_t fileSize() const { return stamp_.size; }
+
+    uint32_t auCount() const { return entries_.empty() ? 0 : entries_.back().auId + 1; }
+
+    /// 所有带 FLAG_KEY 的记录下标，即每个 IDR 访问单元的起点
+    std::vector<size_t> keyEntries() const;
+
+    /// build() 实际使用的线程数
+    int threadsUsed() const { return threadsUsed_; }
+
+private:
+    /// 用来判断索引是否过期的源文件信息
+    struct SourceStamp {
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        uint64_t headChecksum = 0;
+    };
+
+    static bool stampSource(const std::string &filePath, SourceStamp &stamp);
+
+    void assignAccessUnits();
+
+    std::vector<NaluIndexEntry> entries_;
+    SourceStamp stamp_;
+    int threadsUsed_ = 0;
+};
+
+#endif // NALUINDEX_H
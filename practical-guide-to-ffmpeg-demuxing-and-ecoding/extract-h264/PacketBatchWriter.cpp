@@ -0,0 +1,146 @@
+#include "PacketBatchWriter.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+PacketBatchWriter::PacketBatchWriter(size_t maxPackets, size_t maxBytes)
+    : max_packets_(std::max<size_t>(1, maxPackets)), max_bytes_(maxBytes) {
+}
+
+PacketBatchWriter::~PacketBatchWriter() {
+    close();
+    for (AVPacket *&p : slots_) av_packet_free(&p);
+}
+
+bool PacketBatchWriter::open(const std::string &path) {
+    close();
+    if (slots_.empty()) {
+        slots_.resize(max_packets_, nullptr);
+        for (AVPacket *&p : slots_) {
+            p = av_packet_alloc();
+            if (!p) return false;
+        }
+    }
+    bytes_written_ = 0;
+    packets_written_ = 0;
+    write_calls_ = 0;
+
+#ifdef _WIN32
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) return false;
+    setvbuf(file_, nullptr, _IONBF, 0);
+    staging_.resize(max_bytes_);
+    return true;
+#else
+    iov_.reserve(max_packets_);
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    return fd_ >= 0;
+#endif
+}
+
+bool PacketBatchWriter::add(AVPacket *pkt) {
+    av_packet_move_ref(slots_[count_], pkt);
+    pending_bytes_ += slots_[count_]->size;
+    count_++;
+    if (count_ >= max_packets_ || pending_bytes_ >= max_bytes_) return flush();
+    return true;
+}
+
+bool PacketBatchWriter::flush() {
+    if (count_ == 0) return true;
+    bool ok = writeBatch();
+    bytes_written_ += pending_bytes_;
+    packets_written_ += count_;
+    for (size_t i = 0; i < count_; i++) av_packet_unref(slots_[i]);
+    count_ = 0;
+    pending_bytes_ = 0;
+    return ok;
+}
+
+#ifdef _WIN32
+
+bool PacketBatchWriter::writeBatch() {
+    size_t used = 0;
+    for (size_t i = 0; i < count_; i++) {
+        const AVPacket *p = slots_[i];
+        const size_t size = static_cast<size_t>(p->size);
+        if (used + size > staging_.size()) {
+            if (used > 0) {
+                write_calls_++;
+                if (fwrite(staging_.data(), 1, used, file_) != used) return false;
+                used = 0;
+            }
+            if (size > staging_.size()) {
+                // 单个包比缓冲还大，直接写
+                write_calls_++;
+                if (fwrite(p->data, 1, size, file_) != size) return false;
+                continue;
+            }
+        }
+        memcpy(staging_.data() + used, p->data, size);
+        used += size;
+    }
+    if (used > 0) {
+        write_calls_++;
+        if (fwrite(staging_.data(), 1, used, file_) != used) return false;
+    }
+    return true;
+}
+
+bool PacketBatchWriter::close() {
+    if (!file_) return true;
+    bool ok = flush();
+    ok = fclose(file_) == 0 && ok;
+    file_ = nullptr;
+    return ok;
+}
+
+#else
+
+bool PacketBatchWriter::writeBatch() {
+    std::vector<iovec> &iov = iov_;
+    iov.resize(count_);
+    for (size_t i = 0; i < count_; i++) {
+        iov[i].iov_base = slots_[i]->data;
+        iov[i].iov_len = static_cast<size_t>(slots_[i]->size);
+    }
+
+    // writev 可能只写出一部分，跳过已写完的 iovec 后继续
+    size_t idx = 0;
+    while (idx < iov.size()) {
+        const int n = static_cast<int>(std::min<size_t>(iov.size() - idx, IOV_MAX));
+        const ssize_t written = ::writev(fd_, &iov[idx], n);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        write_calls_++;
+        size_t left = static_cast<size_t>(written);
+        while (idx < iov.size() && left >= iov[idx].iov_len) {
+            left -= iov[idx].iov_len;
+            idx++;
+        }
+        if (left > 0) {
+            iov[idx].iov_base = static_cast<uint8_t *>(iov[idx].iov_base) + left;
+            iov[idx].iov_len -= left;
+        }
+    }
+    return true;
+}
+
+bool PacketBatchWriter::close() {
+    if (fd_ < 0) return true;
+    bool ok = flush();
+    ok = ::close(fd_) == 0 && ok;
+    fd_ = -1;
+    return ok;
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef PACKETBATCHWRITER_H
+#define PACKETBATCHWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+
+extern "C" {
+#include <libavcodec/packet.h>
+}
+
+/**
+ * @brief 批量写出 AVPacket
+ *
+ * add() 只接管数据包的引用 (av_packet_move_ref)，不拷贝数据；
+ * 攒够 maxPackets 个或 maxBytes 字节后一次性写出，写完再释放引用。
+ *
+ * POSIX 下用 writev 把一批包的数据作为 iovec 交给内核，一次系统调用写完；
+ * Windows 没有 writev，退化成拷到一块大缓冲后一次 fwrite。
+ */
+class PacketBatchWriter {
+public:
+    explicit PacketBatchWriter(size_t maxPackets = 256, size_t maxBytes = 4 * 1024 * 1024);
+
+    ~PacketBatchWriter();
+
+    PacketBatchWriter(const PacketBatchWriter &) = delete;
+
+    PacketBatchWriter &operator=(const PacketBatchWriter &) = delete;
+
+    bool open(const std::string &path);
+
+    /// 接管 pkt 的引用，调用后 pkt 变为空包
+    bool add(AVPacket *pkt);
+
+    /// 写出当前攒下的所有包
+    bool flush();
+
+    /// 写出剩余数据并关闭文件
+    bool close();
+
+    uint64_t bytesWritten() const { return bytes_written_; }
+
+    uint64_t packetsWritten() const { return packets_written_; }
+
+    uint64_t writeCalls() const { return write_calls_; }
+
+private:
+    bool writeBatch();
+
+    size_t max_packets_;
+    size_t max_bytes_;
+    std::vector<AVPacket *> slots_;  ///< 预先分配的包，只在其中移动引用
+    size_t count_ = 0;               ///< 当前批次中的包数
+    size_t pending_bytes_ = 0;
+
+#ifdef _WIN32
+    FILE *file_ = nullptr;
+    std::vector<uint8_t> staging_;
+#else
+    int fd_ = -1;
+    std::vector<iovec> iov_;         ///< 每批复用，不在写出时分配
+#endif
+
+    uint64_t bytes_written_ = 0;
+    uint64_t packets_written_ = 0;
+    uint64_t write_calls_ = 0;
+};
+
+#endif // PACKETBATCHWRITER_H
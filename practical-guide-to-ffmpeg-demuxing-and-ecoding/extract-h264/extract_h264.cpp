@@ -6,6 +6,15 @@
 #include <cstdlib>
 #include <cstdint>
 #include <algorithm>
+#include <chrono>
+
+#include "AnnexBScanner.h"
+#include "H264StreamAnalyzer.h"
+#include "HevcParser.h"
+#include "HevcStreamAnalyzer.h"
+#include "MappedFile.h"
+#include "NaluIndex.h"
+#include "PacketBatchWriter.h"
 
 // 引入 FFmpeg 头文件 (必须在 extern "C" 中引用)
 extern "C" {
@@ -16,7 +25,7 @@ extern "C" {
 }
 
 /*
- * H.264 学习工具：提取器与分析器 (C++ API 版本)
+ * H.264 / HEVC 学习工具：提取器与分析器 (C++ API 版本)
  *
  * 依赖库: FFmpeg (libavformat, libavcodec, libavutil)
  *
@@ -30,6 +39,16 @@ extern "C" {
  * ./h264_analyzer <video_file> <output_h264_file>
  */
 
+/// 裸流的编码格式
+enum StreamCodec {
+    STREAM_H264,
+    STREAM_HEVC,
+};
+
+const char* codecName(StreamCodec codec) {
+    return codec == STREAM_HEVC ? "HEVC" : "H.264";
+}
+
 // NALU 类型描述映射表
 std::string getNaluDescription(int type) {
     switch (type) {
@@ -50,11 +69,49 @@ std::string getNaluDescription(int type) {
     }
 }
 
+// HEVC NALU 类型描述映射表 (H.265 表 7-1)
+std::string getHevcNaluDescription(int type) {
+    switch (type) {
+        case 0: return "TRAIL_N (Non-ref trailing)";
+        case 1: return "TRAIL_R (Trailing picture)";
+        case 2: return "TSA_N";
+        case 3: return "TSA_R";
+        case 4: return "STSA_N";
+        case 5: return "STSA_R";
+        case 6: return "RADL_N (Decodable leading)";
+        case 7: return "RADL_R (Decodable leading)";
+        case 8: return "RASL_N (Skipped leading)";
+        case 9: return "RASL_R (Skipped leading)";
+        case 16: return "BLA_W_LP (Key Frame)";
+        case 17: return "BLA_W_RADL (Key Frame)";
+        case 18: return "BLA_N_LP (Key Frame)";
+        case 19: return "IDR_W_RADL (Key Frame)";   // 关键帧
+        case 20: return "IDR_N_LP (Key Frame)";     // 关键帧
+        case 21: return "CRA (Clean Random Access)"; // 开放 GOP 的随机接入点
+        case 32: return "VPS (Video Parameter Set)";            // 视频参数集
+        case 33: return "SPS (Sequence Parameter Set)";         // 序列参数集
+        case 34: return "PPS (Picture Parameter Set)";          // 图像参数集
+        case 35: return "AUD (Access Unit Delimiter)";          // 访问单元分隔符
+        case 36: return "END_SEQ";
+        case 37: return "END_STREAM";
+        case 38: return "FILLER";
+        case 39: return "SEI_PREFIX (Supplemental Enhancement Info)";
+        case 40: return "SEI_SUFFIX (Supplemental Enhancement Info)";
+        default: return "Reserved (" + std::to_string(type) + ")";
+    }
+}
+
+std::string getNaluDescription(StreamCodec codec, int type) {
+    return codec == STREAM_HEVC ? getHevcNaluDescription(type) : getNaluDescription(type);
+}
+
 /// NALU信息结构体
 struct NaluInfo {
     int forbidden{};  ///< 禁止位 (1位)
-    int nri{};        ///< 重要性指示 (2位)
-    int type{};       ///< NAL单元类型 (5位)
+    int nri{};        ///< 重要性指示 (2位)，HEVC 没有
+    int type{};       ///< NAL单元类型 (H.264 5位, HEVC 6位)
+    int layerId{};    ///< HEVC nuh_layer_id (6位)
+    int tid{};        ///< HEVC TemporalId (nuh_temporal_id_plus1 - 1)
     std::string desc; ///< 类型描述
 };
 
@@ -82,21 +139,42 @@ NaluInfo parseNaluHeader(uint8_t byteVal) {
 }
 
 /**
- * @brief 使用FFmpeg API提取H.264流
+ * @brief 解析HEVC NALU头部信息
+ * 
+ * NALU Header格式 (2字节): [F(1) | Type(6) | LayerId(6) | TID+1(3)]
+ * HEVC 没有 NRI，是否参考图像由类型本身区分 (偶数类型为子层非参考图像)
+ */
+NaluInfo parseHevcNaluHeader(uint8_t byte0, uint8_t byte1) {
+    const HevcNalHeader h = parseHevcNalHeader(byte0, byte1);
+    NaluInfo info;
+    info.forbidden = h.forbidden;
+    info.type = h.type;
+    info.layerId = h.layerId;
+    info.tid = h.temporalId;
+    info.desc = getHevcNaluDescription(info.type);
+    return info;
+}
+
+/**
+ * @brief 使用FFmpeg API提取H.264/HEVC流
  * 
  * 核心流程:
  * 1. 打开输入文件
  * 2. 查找视频流信息
- * 3. 初始化bitstream filter (h264_mp4toannexb)
+ * 3. 按视频流的编码格式初始化bitstream filter (h264_mp4toannexb / hevc_mp4toannexb)
  * 4. 读取数据包并处理
  * 5. 写入输出文件
  * 
+ * 过滤器输出的包不逐个 fwrite，而是把引用交给 PacketBatchWriter 攒成一批写出：
+ * POSIX 下一次 writev 直接写包里的数据，不拷贝；Windows 没有 writev，先拷到一块暂存缓冲再一次 fwrite。
+ * 
  * @param inputPath 输入文件路径
- * @param outputPath 输出H.264文件路径
+ * @param outputPath 输出裸流文件路径
+ * @param codec 输出视频流的编码格式
  * @return bool 是否成功提取
  */
-bool extractH264(const std::string& inputPath, const std::string& outputPath) {
-    std::cout << "[*] 正在通过 FFmpeg API 从 " << inputPath << " 提取 H.264 流..." << std::endl;
+bool extractVideoStream(const std::string& inputPath, const std::string& outputPath, StreamCodec* codec) {
+    std::cout << "[*] 正在通过 FFmpeg API 从 " << inputPath << " 提取视频流..." << std::endl;
 
     /// 输入文件格式上下文
     AVFormatContext* ifmt_ctx = nullptr;
@@ -104,14 +182,20 @@ bool extractH264(const std::string& inputPath, const std::string& outputPath) {
     const AVBitStreamFilter* bsf = nullptr;
     /// bitstream过滤器上下文
     AVBSFContext* bsf_ctx = nullptr;
-    /// 输出文件指针
-    FILE* out_file = nullptr;
+    /// 批量写出过滤后的数据包
+    PacketBatchWriter writer;
     /// 数据包
     AVPacket* pkt = nullptr;
     /// 视频流索引
     int video_stream_index = -1;
+    /// 过滤器名称，由视频流的编码格式决定
+    const char* bsf_name = nullptr;
     /// 操作是否成功
     bool success = false;
+    /// 开始时间，用于计算吞吐
+    auto start = std::chrono::steady_clock::now();
+    double seconds = 0;
+    double mb = 0;
 
     // 1. 打开输入文件
     // avformat_open_input会自动检测文件格式
@@ -141,12 +225,29 @@ bool extractH264(const std::string& inputPath, const std::string& outputPath) {
         goto cleanup;
     }
 
-    // 4. 初始化 Bitstream Filter (h264_mp4toannexb)
-    // 这一步至关重要：MP4 通常使用 AVCC 格式（无 StartCode），
-    // 分析 H.264 裸流通常需要 Annex B 格式（带 00 00 00 01 StartCode）。
-    bsf = av_bsf_get_by_name("h264_mp4toannexb");
+    // 4. 初始化 Bitstream Filter
+    // 这一步至关重要：MP4 通常使用 AVCC/HVCC 格式（无 StartCode），
+    // 分析裸流通常需要 Annex B 格式（带 00 00 00 01 StartCode）。
+    switch (ifmt_ctx->streams[video_stream_index]->codecpar->codec_id) {
+        case AV_CODEC_ID_H264:
+            *codec = STREAM_H264;
+            bsf_name = "h264_mp4toannexb";
+            break;
+        case AV_CODEC_ID_HEVC:
+            *codec = STREAM_HEVC;
+            bsf_name = "hevc_mp4toannexb";
+            break;
+        default:
+            std::cerr << "[!] 不支持的视频编码: "
+                      << avcodec_get_name(ifmt_ctx->streams[video_stream_index]->codecpar->codec_id)
+                      << " (只支持 H.264 / HEVC)" << std::endl;
+            goto cleanup;
+    }
+    std::cout << "[*] 视频流编码: " << codecName(*codec) << ", 使用 " << bsf_name << " 过滤器" << std::endl;
+
+    bsf = av_bsf_get_by_name(bsf_name);
     if (!bsf) {
-        std::cerr << "[!] FFmpeg 不支持 h264_mp4toannexb 过滤器" << std::endl;
+        std::cerr << "[!] FFmpeg 不支持 " << bsf_name << " 过滤器" << std::endl;
         goto cleanup;
     }
 
@@ -169,8 +270,7 @@ bool extractH264(const std::string& inputPath, const std::string& outputPath) {
     }
 
     // 5. 打开输出文件
-    out_file = fopen(outputPath.c_str(), "wb");
-    if (!out_file) {
+    if (!writer.open(outputPath)) {
         std::cerr << "[!] 无法创建输出文件: " << outputPath << std::endl;
         goto cleanup;
     }
@@ -209,11 +309,11 @@ bool extractH264(const std::string& inputPath, const std::string& outputPath) {
                     break;
                 }
 
-                // 写入文件
-                fwrite(pkt->data, 1, pkt->size, out_file);
-
-                // 释放从 BSF 接收到的 Packet 数据
-                av_packet_unref(pkt);
+                // 交给批量写出，pkt 的引用被接管，这里不需要 unref
+                if (!writer.add(pkt)) {
+                    std::cerr << "[!] 写入输出文件失败" << std::endl;
+                    goto cleanup;
+                }
             }
         } else {
             // 非视频流，释放
@@ -221,110 +321,282 @@ bool extractH264(const std::string& inputPath, const std::string& outputPath) {
         }
     }
 
+    // 冲刷过滤器，取出缓存的最后几个包
+    if (av_bsf_send_packet(bsf_ctx, nullptr) >= 0) {
+        while (av_bsf_receive_packet(bsf_ctx, pkt) >= 0) {
+            if (!writer.add(pkt)) {
+                std::cerr << "[!] 写入输出文件失败" << std::endl;
+                goto cleanup;
+            }
+        }
+    }
+    if (!writer.close()) {
+        std::cerr << "[!] 写入输出文件失败" << std::endl;
+        goto cleanup;
+    }
+
     success = true;
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    mb = writer.bytesWritten() / (1024.0 * 1024.0);
     std::cout << "[+] 提取成功: " << outputPath << std::endl;
+    std::cout << "[*] " << writer.packetsWritten() << " 个包, " << std::fixed << std::setprecision(2) << mb << " MB, "
+              << writer.writeCalls() << " 次写调用 (平均每次 "
+              << (writer.writeCalls() ? writer.packetsWritten() / static_cast<double>(writer.writeCalls()) : 0.0)
+              << " 个包), 用时 " << seconds << " s (" << (seconds > 0 ? mb / seconds : 0.0) << " MB/s)" << std::endl;
 
     // 清理资源
     cleanup:
     if (pkt) av_packet_free(&pkt);
     if (bsf_ctx) av_bsf_free(&bsf_ctx);
     if (ifmt_ctx) avformat_close_input(&ifmt_ctx);
-    if (out_file) fclose(out_file);
+    writer.close();
 
     return success;
 }
 
+/// 读取窗口大小 (内存映射失败或关闭时使用)
+const size_t SCAN_WINDOW_SIZE = 8 * 1024 * 1024;
+
+/// 按 NALU 类型汇总的统计
+struct NaluTypeStats {
+    uint64_t count = 0;   ///< 个数
+    uint64_t bytes = 0;   ///< 总字节数 (不含起始码)
+    uint64_t maxSize = 0; ///< 最大的一个
+};
+
 /**
- * @brief 分析H.264二进制文件结构
+ * @brief 分析H.264/HEVC二进制文件结构
  * 
  * 该函数会查找NALU的起始码(0x000001或0x00000001)，
- * 并解析每个NALU的头部信息。
+ * 并解析每个NALU的头部信息 (H.264 1 字节, HEVC 2 字节)。
  * 
- * @param filePath H.264文件路径
- * @param maxNalus 最大分析的NALU数量，默认20个
+ * 文件以流式方式扫描 (内存映射或分窗口读取)，内存占用与文件大小无关，
+ * 多 GB 的文件也会完整扫完：前 maxNalus 个 NALU 逐条打印，全部 NALU 计入统计。
+ * 同时解析参数集和 Slice 头，输出逐帧信息、帧类型、GOP 结构和码率曲线。
+ * 两种编码格式共用同一个起始码扫描器和 FrameStats 统计。
+ * 
+ * @param filePath 裸流文件路径
+ * @param codec 编码格式
+ * @param maxNalus 逐条打印的NALU数量，默认20个
+ * @param useMmap 是否使用内存映射，false 时按窗口读取
+ * @param maxFrames 逐条打印的帧数，默认30帧，-1 表示全部
  */
-void analyzeH264Stream(const std::string& filePath, int maxNalus = 20) {
-    std::cout << "\n[*] 开始分析文件结构: " << filePath << std::endl;
-    std::cout << "[*] 仅显示前 " << maxNalus << " 个 NALU...\n" << std::endl;
+void analyzeAnnexBStream(const std::string& filePath, StreamCodec codec, int maxNalus = 20, bool useMmap = true,
+                         int maxFrames = 30) {
+    const bool hevc = codec == STREAM_HEVC;
+    std::cout << "\n[*] 开始分析 " << codecName(codec) << " 文件结构: " << filePath << std::endl;
+    if (maxNalus > 0) {
+        std::cout << "[*] 逐条显示前 " << maxNalus << " 个 NALU，其余只做统计...\n" << std::endl;
+
+        // 打印表头
+        std::cout << std::string(90, '-') << std::endl;
+        std::cout << std::left << std::setw(15) << "Offset (Hex)"
+                  << "| " << std::setw(12) << "Start Code"
+                  << "| " << std::setw(9) << "Type ID"
+                  << "| " << std::setw(5) << (hevc ? "L/T" : "NRI")
+                  << "| " << "Description" << std::endl;
+        std::cout << std::string(90, '-') << std::endl;
+    }
 
-    // 打印表头
-    std::cout << std::string(90, '-') << std::endl;
-    std::cout << std::left << std::setw(15) << "Offset (Hex)"
-              << "| " << std::setw(12) << "Start Code"
-              << "| " << std::setw(9) << "Type ID"
-              << "| " << std::setw(5) << "NRI"
-              << "| " << "Description" << std::endl;
-    std::cout << std::string(90, '-') << std::endl;
+    NaluTypeStats stats[64];
+    uint64_t naluCount = 0;
+    uint64_t forbiddenCount = 0;
+    H264StreamAnalyzer h264Analyzer(maxFrames);
+    HevcStreamAnalyzer hevcAnalyzer(maxFrames);
+
+    auto onNalu = [&](const NaluRef& nalu) {
+        // 两个起始码紧挨着，没有头部字节 (HEVC 的头部有 2 字节)
+        if (nalu.headLen < (hevc ? 2u : 1u)) return;
+
+        NaluInfo info = hevc ? parseHevcNaluHeader(nalu.head[0], nalu.head[1]) : parseNaluHeader(nalu.head[0]);
+        if (naluCount < static_cast<uint64_t>(maxNalus)) {
+            // 格式化起始码为十六进制字符串
+            std::string startCodeHex = (nalu.startCodeLen == 3) ? "000001" : "00000001";
+
+            // 格式化输出NALU信息
+            std::cout << "0x" << std::hex << std::uppercase << std::right << std::setfill('0') << std::setw(8) << nalu.offset
+                      << "   | " << std::left << std::setfill(' ') << std::setw(10) << startCodeHex
+                      << " | " << std::setw(7) << std::dec << info.type
+                      << " | " << std::setw(3) << (hevc ? std::to_string(info.layerId) + "/" + std::to_string(info.tid)
+                                                        : std::to_string(info.nri))
+                      << " | " << info.desc << std::endl;
+
+            // 对于关键信息(参数集/关键帧)进行高亮显示
+            const bool important = hevc ? (hevcIsIrap(info.type) || (info.type >= HEVC_NAL_VPS && info.type <= HEVC_NAL_PPS))
+                                        : (info.type == 5 || info.type == 7 || info.type == 8);
+            if (important) {
+                std::cout << "             ^--- 关键信息 (" << info.desc << ")" << std::endl;
+            }
+        }
 
-    // 打开文件
-    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
-    if (!file.is_open()) {
-        std::cerr << "[!] 无法读取文件: " << filePath << std::endl;
+        NaluTypeStats& s = stats[info.type];
+        s.count++;
+        s.bytes += nalu.size;
+        s.maxSize = std::max(s.maxSize, nalu.size);
+        if (info.forbidden) forbiddenCount++;
+        naluCount++;
+        if (hevc) hevcAnalyzer.onNalu(nalu);
+        else h264Analyzer.onNalu(nalu);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t fileSize = 0;
+    std::string error;
+    if (!scanAnnexBFile(filePath, onNalu, useMmap, SCAN_WINDOW_SIZE, &fileSize, &error)) {
+        std::cerr << "[!] 无法读取文件: " << filePath << " (" << error << ")" << std::endl;
         return;
     }
+    if (hevc) hevcAnalyzer.finish();
+    else h264Analyzer.finish();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 
-    // 获取文件大小并回到文件开头
-    std::streamsize size = file.tellg();
-    file.seekg(0, std::ios::beg);
-
-    // 读取整个文件到内存 (注意：对于超大文件可能不适用，但用于学习分析足够)
-    std::vector<uint8_t> buffer(size);
-    if (!file.read(reinterpret_cast<char*>(buffer.data()), size)) {
-        std::cerr << "[!] 读取文件失败" << std::endl;
+    // 如果没有找到任何NALU，说明可能不是Annex B格式
+    if (naluCount == 0) {
+        std::cout << "[!] 未找到 NALU Start Code。这可能不是 Annex B 格式的 " << codecName(codec) << " 文件 (可能是 mp4 模式?)" << std::endl;
         return;
     }
 
-    // 查找NALU
-    int naluCount = 0;
-    size_t idx = 0;
+    double mb = fileSize / (1024.0 * 1024.0);
+    std::cout << "\n[*] 共 " << naluCount << " 个 NALU, " << std::fixed << std::setprecision(2) << mb << " MB, 用时 "
+              << seconds << " s (" << (seconds > 0 ? mb / seconds : 0.0) << " MB/s)" << std::endl;
 
-    while (idx < size && naluCount < maxNalus) {
-        // 确保有足够空间读取 Start Code
-        if (idx + 3 >= size) break;
+    std::cout << std::string(90, '-') << std::endl;
+    std::cout << std::left << std::setw(6) << "Type"
+              << "| " << std::setw(11) << "Count"
+              << "| " << std::setw(15) << "Bytes"
+              << "| " << std::setw(10) << "Avg"
+              << "| " << std::setw(10) << "Max"
+              << "| " << "Description" << std::endl;
+    std::cout << std::string(90, '-') << std::endl;
+    for (int type = 0; type < 64; type++) {
+        const NaluTypeStats& s = stats[type];
+        if (s.count == 0) continue;
+        std::cout << std::setw(6) << type
+                  << "| " << std::setw(11) << s.count
+                  << "| " << std::setw(15) << s.bytes
+                  << "| " << std::setw(10) << s.bytes / s.count
+                  << "| " << std::setw(10) << s.maxSize
+                  << "| " << getNaluDescription(codec, type) << std::endl;
+    }
 
-        // 查找起始码长度 (3字节或4字节)
-        int startCodeLen = 0;
-        if (buffer[idx] == 0x00 && buffer[idx+1] == 0x00 && buffer[idx+2] == 0x01) {
-            startCodeLen = 3;  // 3字节起始码
-        } else if (buffer[idx] == 0x00 && buffer[idx+1] == 0x00 && buffer[idx+2] == 0x00 && buffer[idx+3] == 0x01) {
-            startCodeLen = 4;  // 4字节起始码
-        }
+    if (forbiddenCount > 0) {
+        std::cout << "[!] " << forbiddenCount << " 个 NALU 的禁止位为 1，码流可能已损坏" << std::endl;
+    }
 
-        if (startCodeLen > 0) {
-            // 找到起始码，下一个字节就是NALU头部
-            size_t headerPos = idx + startCodeLen;
-            if (headerPos < size) {
-                uint8_t headerByte = buffer[headerPos];
-                NaluInfo info = parseNaluHeader(headerByte);
-
-                // 格式化起始码为十六进制字符串
-                std::string startCodeHex = (startCodeLen == 3) ? "000001" : "00000001";
-
-                // 格式化输出NALU信息
-                std::cout << "0x" << std::hex << std::uppercase << std::setfill('0') << std::setw(8) << idx
-                          << "   | " << std::setfill(' ') << std::setw(10) << startCodeHex
-                          << " | " << std::setw(7) << std::dec << info.type
-                          << " | " << std::setw(3) << info.nri
-                          << " | " << info.desc << std::endl;
-
-                // 对于关键信息(SPS/PPS/IDR)进行高亮显示
-                if (info.type == 5 || info.type == 7 || info.type == 8) {
-                    std::cout << "             ^--- 关键信息 (" << info.desc << ")" << std::endl;
-                }
-                naluCount++;
-            }
-            // 跳过当前的起始码，继续搜索
-            idx += startCodeLen;
-        } else {
-            // 未找到起始码，向前移动一个字节
-            idx++;
+    if (hevc) hevcAnalyzer.printReport();
+    else h264Analyzer.printReport();
+}
+
+/**
+ * @brief 打开 NALU 索引
+ * 
+ * 旁路索引文件存在且与源文件的大小、修改时间、开头内容都一致时直接读取，否则并行扫描重新建立并保存。
+ * 
+ * @param filePath H.264文件路径
+ * @param threads 扫描线程数，<= 0 表示 CPU 核数
+ * @param rebuild 是否忽略已有索引强制重建
+ * @param index 输出的索引
+ * @return bool 是否成功
+ */
+bool openNaluIndex(const std::string& filePath, int threads, bool rebuild, NaluIndex& index) {
+    const std::string indexPath = NaluIndex::sidecarPath(filePath);
+    std::string error;
+
+    auto start = std::chrono::steady_clock::now();
+    if (!rebuild) {
+        if (index.load(indexPath, filePath, &error)) {
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "[*] 读取索引 " << indexPath << ": " << index.entries().size() << " 个 NALU, 用时 "
+                      << std::fixed << std::setprecision(1) << ms << " ms" << std::endl;
+            return true;
         }
+        std::cout << "[*] " << indexPath << ": " << error << "，重新扫描" << std::endl;
     }
 
-    // 如果没有找到任何NALU，说明可能不是Annex B格式
-    if (naluCount == 0) {
-        std::cout << "[!] 未找到 NALU Start Code。这可能不是 Annex B 格式的 H.264 文件 (可能是 mp4 模式?)" << std::endl;
+    if (!index.build(filePath, threads, &error)) {
+        std::cerr << "[!] 无法建立索引: " << filePath << " (" << error << ")" << std::endl;
+        return false;
     }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double mb = index.fileSize() / (1024.0 * 1024.0);
+    std::cout << "[*] 扫描 " << filePath << ": " << std::fixed << std::setprecision(2) << mb << " MB, "
+              << index.threadsUsed() << " 个线程, 用时 " << seconds << " s ("
+              << (seconds > 0 ? mb / seconds : 0.0) << " MB/s)" << std::endl;
+
+    if (!index.save(indexPath, &error)) {
+        // 保存失败不影响本次使用，只是下次还要重新扫描
+        std::cerr << "[!] 无法保存索引 " << indexPath << " (" << error << ")" << std::endl;
+    } else {
+        std::cout << "[+] 索引已保存: " << indexPath << std::endl;
+    }
+    return true;
+}
+
+/**
+ * @brief 定位到第 keyNumber 个 IDR，可选地把这个 GOP 写成独立的 H.264 文件
+ * 
+ * GOP 从 IDR 所在访问单元开始，到下一个 IDR 访问单元为止。
+ * 如果这个访问单元前面没有 SPS/PPS，就把文件中在它之前最近的 SPS/PPS 写在前面，
+ * 保证输出文件可以单独解码。
+ * 
+ * @param keyNumber IDR 序号 (从 0 开始)
+ * @param outputPath 输出文件路径，为空时只打印位置
+ */
+bool seekToIdr(const std::string& filePath, const NaluIndex& index, size_t keyNumber, const std::string& outputPath) {
+    const std::vector<NaluIndexEntry>& entries = index.entries();
+    const std::vector<size_t> keys = index.keyEntries();
+    std::cout << "[*] 共 " << index.auCount() << " 个访问单元, " << keys.size() << " 个 IDR" << std::endl;
+    if (keyNumber >= keys.size()) {
+        std::cerr << "[!] IDR 序号超出范围: " << keyNumber << std::endl;
+        return false;
+    }
+
+    const size_t first = keys[keyNumber];
+    const size_t last = (keyNumber + 1 < keys.size()) ? keys[keyNumber + 1] : entries.size();
+    const uint64_t begin = entries[first].offset;
+    const uint64_t end = (last < entries.size()) ? entries[last].offset : index.fileSize();
+    const uint32_t auCount = (last < entries.size() ? entries[last].auId : index.auCount()) - entries[first].auId;
+    std::cout << "[+] IDR #" << keyNumber << ": 访问单元 " << entries[first].auId << ", 偏移 0x" << std::hex
+              << std::uppercase << begin << std::dec << ", GOP " << auCount << " 帧 / " << (end - begin) << " 字节"
+              << std::endl;
+    if (outputPath.empty()) return true;
+
+    // 找 IDR 之前最近的 SPS/PPS，已经在 IDR 访问单元里的不需要补
+    const NaluIndexEntry* sps = nullptr;
+    const NaluIndexEntry* pps = nullptr;
+    bool auHasSps = false;
+    bool auHasPps = false;
+    for (size_t i = first; i < last && entries[i].auId == entries[first].auId; i++) {
+        if (entries[i].type == 7) auHasSps = true;
+        if (entries[i].type == 8) auHasPps = true;
+    }
+    for (size_t i = first; i-- > 0 && ((!auHasSps && !sps) || (!auHasPps && !pps));) {
+        if (!auHasSps && !sps && entries[i].type == 7) sps = &entries[i];
+        if (!auHasPps && !pps && entries[i].type == 8) pps = &entries[i];
+    }
+
+    MappedFile file;
+    if (!file.open(filePath.c_str()) || file.size() != index.fileSize()) {
+        std::cerr << "[!] 无法映射文件: " << filePath << std::endl;
+        return false;
+    }
+    FILE* out = fopen(outputPath.c_str(), "wb");
+    if (!out) {
+        std::cerr << "[!] 无法创建输出文件: " << outputPath << std::endl;
+        return false;
+    }
+    bool ok = true;
+    for (const NaluIndexEntry* ps : {sps, pps}) {
+        if (ps) ok = ok && fwrite(file.data() + ps->offset, 1, ps->startCodeLen + ps->size, out) == ps->startCodeLen + ps->size;
+    }
+    ok = ok && fwrite(file.data() + begin, 1, static_cast<size_t>(end - begin), out) == end - begin;
+    ok = fclose(out) == 0 && ok;
+    if (!ok) {
+        std::cerr << "[!] 写入失败: " << outputPath << std::endl;
+        return false;
+    }
+    std::cout << "[+] 已写出 GOP: " << outputPath << (sps || pps ? " (补充了前面的 SPS/PPS)" : "") << std::endl;
+    return true;
 }
 
 /**
@@ -345,8 +617,10 @@ bool hasSuffix(const std::string &str, const std::string &suffix) {
  * @brief 程序主入口
  * 
  * 程序功能：
- * 1. 如果输入文件是.h264/.264文件，直接进行分析
- * 2. 如果是其他视频文件，先提取H.264流再分析
+ * 1. 如果输入文件是.h264/.264 (H.264) 或 .h265/.265/.hevc (HEVC) 文件，直接进行分析
+ * 2. 如果是其他视频文件，按视频流的编码格式提取裸流再分析
+ * 
+ * 裸流的编码格式由后缀判断，可以用 --h264 / --hevc 强制指定。
  * 
  * @param argc 命令行参数数量
  * @param argv 命令行参数数组
@@ -354,39 +628,100 @@ bool hasSuffix(const std::string &str, const std::string &suffix) {
  */
 int main(int argc, char* argv[]) {
 
-    // 检查命令行参数
-    if(argc < 3){
-        std::cout << "Usage: " << argv[0] << " <input_file> <output_file>" << std::endl;
+    // 解析命令行参数
+    int maxNalus = 20;
+    int maxFrames = 30;
+    bool useMmap = true;
+    bool buildIndex = false;
+    long seekIdr = -1;
+    int threads = 0;
+    int forceCodec = -1;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc) {
+            maxNalus = std::atoi(argv[++i]);
+        } else if (arg == "--frames" && i + 1 < argc) {
+            maxFrames = std::atoi(argv[++i]);
+        } else if (arg == "--no-mmap") {
+            useMmap = false;
+        } else if (arg == "--index") {
+            buildIndex = true;
+        } else if (arg == "--seek-idr" && i + 1 < argc) {
+            seekIdr = std::atol(argv[++i]);
+        } else if (arg == "-j" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (arg == "--h264") {
+            forceCodec = STREAM_H264;
+        } else if (arg == "--hevc") {
+            forceCodec = STREAM_HEVC;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    // 检查命令行参数 (输入已经是 .h264 时可以不给输出文件)
+    if (positional.empty()) {
+        std::cout << "Usage: " << argv[0] << " [-n <nalus_to_print>] [--frames <frames_to_print>] [--no-mmap] [--h264|--hevc] <input_file> <output_file>" << std::endl;
+        std::cout << "       " << argv[0] << " --index [-j <threads>] <file.h264>" << std::endl;
+        std::cout << "       " << argv[0] << " --seek-idr <n> [-j <threads>] <file.h264> [gop_output.h264]" << std::endl;
         return 1;
     }
 
     // 获取命令行参数
-    std::string targetFile = argv[1];
-    std::string outputH264 = argv[2];
+    std::string targetFile = positional[0];
+    std::string outputH264 = positional.size() > 1 ? positional[1] : "";
+
+    std::cout << "=== H.264 / HEVC 学习助手 (C++ API 版) ===" << std::endl;
+
+    // 判断是否为裸流文件
+    bool isH264 = hasSuffix(targetFile, ".h264") || hasSuffix(targetFile, ".264");
+    bool isHevc = hasSuffix(targetFile, ".h265") || hasSuffix(targetFile, ".265") || hasSuffix(targetFile, ".hevc");
+    if (forceCodec >= 0) {
+        isH264 = forceCodec == STREAM_H264;
+        isHevc = forceCodec == STREAM_HEVC;
+    }
 
-    std::cout << "=== H.264 学习助手 (C++ API 版) ===" << std::endl;
+    // 索引模式：建立旁路索引，或借助索引直接定位 IDR
+    if (buildIndex || seekIdr >= 0) {
+        if (isHevc) {
+            // 索引按 H.264 的 1 字节 NALU 头划分访问单元
+            std::cerr << "[!] --index / --seek-idr 只支持 H.264 裸流" << std::endl;
+            return 1;
+        }
+        NaluIndex index;
+        if (!openNaluIndex(targetFile, threads, buildIndex, index)) return 1;
+        if (buildIndex) {
+            std::cout << "[*] " << index.entries().size() << " 个 NALU, " << index.auCount() << " 个访问单元, "
+                      << index.keyEntries().size() << " 个 IDR" << std::endl;
+        }
+        if (seekIdr >= 0 && !seekToIdr(targetFile, index, static_cast<size_t>(seekIdr), outputH264)) return 1;
+        return 0;
+    }
 
     // 检查文件是否存在
     std::ifstream f(targetFile.c_str());
     bool fileExists = f.good();
     f.close();
 
-    // 判断是否为H.264文件
-    bool isH264 = hasSuffix(targetFile, ".h264") || hasSuffix(targetFile, ".264");
-
     // 注意：av_register_all() 在 FFmpeg 4.0 之后已弃用，因此这里不需要调用
 
-    if (isH264 && fileExists) {
-        // 如果已经是H.264裸流文件，直接分析
-        analyzeH264Stream(targetFile);
+    if ((isH264 || isHevc) && fileExists) {
+        // 如果已经是裸流文件，直接分析
+        analyzeAnnexBStream(targetFile, isHevc ? STREAM_HEVC : STREAM_H264, maxNalus, useMmap, maxFrames);
     } else if (fileExists) {
-        // 使用 API 提取并分析
-        if (extractH264(targetFile, outputH264)) {
-            analyzeH264Stream(outputH264);
+        if (outputH264.empty()) {
+            std::cout << "[!] 需要指定输出的裸流文件" << std::endl;
+            return 1;
+        }
+        // 使用 API 提取并分析，编码格式以容器中的视频流为准
+        StreamCodec codec = STREAM_H264;
+        if (extractVideoStream(targetFile, outputH264, &codec)) {
+            analyzeAnnexBStream(outputH264, codec, maxNalus, useMmap, maxFrames);
         }
     } else {
         std::cout << "[!] 文件 " << targetFile << " 不存在。请提供有效的视频文件路径。" << std::endl;
     }
 
     return 0;
-}
\ No newline at end of file
+}
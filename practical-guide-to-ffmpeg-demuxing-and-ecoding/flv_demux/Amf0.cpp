@@ -0,0 +1,165 @@
+#include "Amf0.h"
+#include "FLVParser.h"
+
+#include <cstring>
+
+/// Object / Array 最大嵌套层数，防止恶意数据把栈耗尽
+static const int MAX_DEPTH = 32;
+
+static size_t skipValue(const uint8_t* p, size_t size, int depth);
+
+// 属性列表：UI16 长度的属性名 + 值，直到空属性名 + 0x09
+static size_t skipProperties(const uint8_t* p, size_t size, int depth) {
+    size_t pos = 0;
+    while (size - pos >= 2) {
+        const size_t keyLen = readUI16(p + pos);
+        if (keyLen == 0) {
+            if (size - pos < 3 || p[pos + 2] != AMF0_OBJECT_END) return 0;
+            return pos + 3;
+        }
+        pos += 2 + keyLen;
+        if (pos >= size) return 0;
+        const size_t n = skipValue(p + pos, size - pos, depth + 1);
+        if (n == 0) return 0;
+        pos += n;
+    }
+    return 0;
+}
+
+static size_t skipValue(const uint8_t* p, size_t size, int depth) {
+    if (size == 0 || depth > MAX_DEPTH) return 0;
+    size_t n = 0;
+    switch (p[0]) {
+        case AMF0_NUMBER: n = 9; break;
+        case AMF0_BOOLEAN: n = 2; break;
+        case AMF0_STRING:
+            if (size < 3) return 0;
+            n = 3 + readUI16(p + 1);
+            break;
+        case AMF0_LONG_STRING:
+            if (size < 5) return 0;
+            n = 5 + static_cast<size_t>(readUI32(p + 1));
+            break;
+        case AMF0_NULL:
+        case AMF0_UNDEFINED: n = 1; break;
+        case AMF0_REFERENCE: n = 3; break;
+        case AMF0_DATE: n = 11; break;
+        case AMF0_OBJECT: {
+            const size_t body = skipProperties(p + 1, size - 1, depth);
+            return body == 0 ? 0 : 1 + body;
+        }
+        case AMF0_ECMA_ARRAY: {
+            if (size < 5) return 0;
+            const size_t body = skipProperties(p + 5, size - 5, depth);
+            return body == 0 ? 0 : 5 + body;
+        }
+        case AMF0_STRICT_ARRAY: {
+            if (size < 5) return 0;
+            const uint32_t count = readUI32(p + 1);
+            size_t pos = 5;
+            for (uint32_t i = 0; i < count; i++) {
+                if (pos >= size) return 0;
+                const size_t v = skipValue(p + pos, size - pos, depth + 1);
+                if (v == 0) return 0;
+                pos += v;
+            }
+            return pos;
+        }
+        default: return 0;
+    }
+    return n <= size ? n : 0;
+}
+
+size_t amf0SkipValue(const uint8_t* p, size_t size) {
+    return skipValue(p, size, 0);
+}
+
+double amf0ReadDouble(const uint8_t* p) {
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; i++) bits = (bits << 8) | p[i];
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+double Amf0Value::number(double def) const {
+    if ((type() == AMF0_NUMBER && avail_ >= 9) || (type() == AMF0_DATE && avail_ >= 11)) return amf0ReadDouble(p_ + 1);
+    return def;
+}
+
+bool Amf0Value::boolean(bool def) const {
+    if (type() == AMF0_BOOLEAN && avail_ >= 2) return p_[1] != 0;
+    if (type() == AMF0_NUMBER && avail_ >= 9) return amf0ReadDouble(p_ + 1) != 0;
+    return def;
+}
+
+bool Amf0Value::string(const char** data, size_t* len) const {
+    size_t header, n;
+    if (type() == AMF0_STRING && avail_ >= 3) {
+        header = 3;
+        n = readUI16(p_ + 1);
+    } else if (type() == AMF0_LONG_STRING && avail_ >= 5) {
+        header = 5;
+        n = readUI32(p_ + 1);
+    } else {
+        return false;
+    }
+    if (avail_ - header < n) return false;
+    *data = reinterpret_cast<const char*>(p_ + header);
+    *len = n;
+    return true;
+}
+
+std::string Amf0Value::str() const {
+    const char* data;
+    size_t len;
+    return string(&data, &len) ? std::string(data, len) : std::string();
+}
+
+uint32_t Amf0Value::count() const {
+    if ((type() == AMF0_STRICT_ARRAY || type() == AMF0_ECMA_ARRAY) && avail_ >= 5) return readUI32(p_ + 1);
+    return 0;
+}
+
+Amf0Value Amf0Value::get(const char* key) const {
+    const size_t want = strlen(key);
+    Amf0Value found;
+    forEachProperty([&](const char* name, size_t len, const Amf0Value& value) {
+        if (len != want || memcmp(name, key, len) != 0) return true;
+        found = value;
+        return false;
+    });
+    return found;
+}
+
+void amf0WriteUI32(std::vector<uint8_t>& out, uint32_t value) {
+    const uint8_t b[4] = {static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+                          static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)};
+    out.insert(out.end(), b, b + 4);
+}
+
+void amf0WriteNumber(std::vector<uint8_t>& out, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    out.push_back(AMF0_NUMBER);
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<uint8_t>(bits >> shift));
+    }
+}
+
+void amf0WriteKey(std::vector<uint8_t>& out, const std::string& key) {
+    out.push_back(static_cast<uint8_t>(key.size() >> 8));
+    out.push_back(static_cast<uint8_t>(key.size()));
+    out.insert(out.end(), key.begin(), key.end());
+}
+
+void amf0WriteString(std::vector<uint8_t>& out, const std::string& value) {
+    out.push_back(AMF0_STRING);
+    amf0WriteKey(out, value);
+}
+
+void amf0WriteObjectEnd(std::vector<uint8_t>& out) {
+    out.push_back(0);
+    out.push_back(0);
+    out.push_back(AMF0_OBJECT_END);
+}
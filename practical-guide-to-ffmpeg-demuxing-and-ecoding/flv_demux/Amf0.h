@@ -0,0 +1,149 @@
+#ifndef AMF0_H
+#define AMF0_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// AMF0 类型标记 (Script Tag 的 Data 就是若干个 AMF0 值)
+enum Amf0Marker {
+    AMF0_NUMBER = 0x00,        ///< 8 字节大端 double
+    AMF0_BOOLEAN = 0x01,       ///< 1 字节
+    AMF0_STRING = 0x02,        ///< UI16 长度 + UTF-8
+    AMF0_OBJECT = 0x03,        ///< 属性列表，以 00 00 09 结尾
+    AMF0_MOVIECLIP = 0x04,     ///< 保留，不会出现
+    AMF0_NULL = 0x05,
+    AMF0_UNDEFINED = 0x06,
+    AMF0_REFERENCE = 0x07,     ///< UI16 引用序号
+    AMF0_ECMA_ARRAY = 0x08,    ///< UI32 个数 (仅供参考) + 属性列表，以 00 00 09 结尾
+    AMF0_OBJECT_END = 0x09,
+    AMF0_STRICT_ARRAY = 0x0A,  ///< UI32 个数 + 若干值
+    AMF0_DATE = 0x0B,          ///< double 毫秒 + SI16 时区
+    AMF0_LONG_STRING = 0x0C,   ///< UI32 长度 + UTF-8
+};
+
+/**
+ * @brief 跳过 p 处的一个 AMF0 值 (包括类型标记)
+ * @return size_t 这个值占用的字节数，数据不完整或类型不支持时返回 0
+ */
+size_t amf0SkipValue(const uint8_t* p, size_t size);
+
+/// 读取 8 字节大端 double
+double amf0ReadDouble(const uint8_t* p);
+
+/**
+ * @brief 一个 AMF0 值的只读视图
+ *
+ * 不拷贝也不分配内存，只记住值在数据中的位置，读取时才解码。
+ * Object / 数组的成员按需查找或遍历，不关心的成员 (例如几万项的 keyframes 数组) 只跳过不解码。
+ * 视图指向的数据必须在使用期间有效 (例如只在 Tag 回调内使用)。
+ */
+class Amf0Value {
+public:
+    Amf0Value() = default;
+
+    /// p 处的一个值，avail 为 p 之后可用的字节数
+    Amf0Value(const uint8_t* p, size_t avail) : p_(p), avail_(avail) {}
+
+    bool valid() const { return p_ != nullptr && avail_ > 0; }
+
+    /// Amf0Marker，无效时为 -1
+    int type() const { return valid() ? p_[0] : -1; }
+
+    /// 整个值编码后的长度 (包括类型标记)，数据损坏时返回 0
+    size_t encodedSize() const { return valid() ? amf0SkipValue(p_, avail_) : 0; }
+
+    /// Number / Date (毫秒，时区字段规范要求写 0，忽略)，其它类型返回 def
+    double number(double def = 0) const;
+
+    /// Boolean，Number 按非 0 处理，其它类型返回 def
+    bool boolean(bool def = false) const;
+
+    /// String / Long String，data 指向原始数据，不拷贝
+    bool string(const char** data, size_t* len) const;
+
+    /// String / Long String 拷贝成 std::string，其它类型返回空串
+    std::string str() const;
+
+    /// Strict Array 的元素个数，ECMA Array 声明的个数 (仅供参考)
+    uint32_t count() const;
+
+    /// Object / ECMA Array 中按属性名查找，找不到返回无效值
+    Amf0Value get(const char* key) const;
+
+    /**
+     * @brief 遍历 Object / ECMA Array 的属性
+     * @param f bool(const char* key, size_t keyLen, const Amf0Value& value)，返回 false 提前结束
+     * @return bool 不是 Object / ECMA Array 或数据损坏、被截断时返回 false
+     */
+    template <typename F>
+    bool forEachProperty(F f) const;
+
+    /**
+     * @brief 遍历 Strict Array 的元素
+     * @param f bool(uint32_t index, const Amf0Value& value)，返回 false 提前结束
+     */
+    template <typename F>
+    bool forEachElement(F f) const;
+
+private:
+    const uint8_t* p_ = nullptr;
+    size_t avail_ = 0;
+};
+
+template <typename F>
+bool Amf0Value::forEachProperty(F f) const {
+    size_t pos;
+    if (type() == AMF0_OBJECT) pos = 1;
+    else if (type() == AMF0_ECMA_ARRAY && avail_ >= 5) pos = 5;
+    else return false;
+
+    while (avail_ - pos >= 2) {
+        const size_t keyLen = (static_cast<size_t>(p_[pos]) << 8) | p_[pos + 1];
+        if (keyLen == 0) return avail_ - pos >= 3 && p_[pos + 2] == AMF0_OBJECT_END;
+        const size_t valuePos = pos + 2 + keyLen;
+        if (valuePos >= avail_) return false;
+        const Amf0Value value(p_ + valuePos, avail_ - valuePos);
+        if (!f(reinterpret_cast<const char*>(p_ + pos + 2), keyLen, value)) return true;
+        const size_t n = value.encodedSize();
+        if (n == 0) return false;
+        pos = valuePos + n;
+    }
+    return false;
+}
+
+template <typename F>
+bool Amf0Value::forEachElement(F f) const {
+    if (type() != AMF0_STRICT_ARRAY || avail_ < 5) return false;
+    const uint32_t n = count();
+    size_t pos = 5;
+    for (uint32_t i = 0; i < n; i++) {
+        if (pos >= avail_) return false;
+        const Amf0Value value(p_ + pos, avail_ - pos);
+        if (!f(i, value)) return true;
+        const size_t size = value.encodedSize();
+        if (size == 0) return false;
+        pos += size;
+    }
+    return true;
+}
+
+// ==========================================
+// 编码：追加到 out 末尾
+// ==========================================
+
+void amf0WriteNumber(std::vector<uint8_t>& out, double value);
+
+/// 带类型标记的字符串 (长度不超过 65535)
+void amf0WriteString(std::vector<uint8_t>& out, const std::string& value);
+
+/// Object / ECMA Array 的属性名 (没有类型标记)
+void amf0WriteKey(std::vector<uint8_t>& out, const std::string& key);
+
+/// Object / ECMA Array 的结束标记 00 00 09
+void amf0WriteObjectEnd(std::vector<uint8_t>& out);
+
+void amf0WriteUI32(std::vector<uint8_t>& out, uint32_t value);
+
+#endif // AMF0_H
@@ -0,0 +1,236 @@
+#include "FLVParser.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+/// PreviousTagSize (4) + Tag Header (11)
+static const size_t TAG_PREFIX_SIZE = 15;
+
+/// DataOffset 超过这个值认为文件头已损坏 (正常为 9)
+static const uint32_t MAX_HEADER_SIZE = 1024 * 1024;
+
+std::string formatTime(int64_t ms) {
+    char buf[64];
+    const char* sign = ms < 0 ? "-" : "";
+    if (ms < 0) ms = -ms;
+    snprintf(buf, sizeof(buf), "%s%lld.%03llds", sign, static_cast<long long>(ms / 1000),
+             static_cast<long long>(ms % 1000));
+    return {buf};
+}
+
+bool parseVideoInfo(const FlvTag& tag, FlvVideoInfo& info) {
+    info = FlvVideoInfo();
+    if (tag.capturedSize == 0) return false;
+
+    // 第1个字节：FrameType (高4位) + CodecID (低4位)
+    info.frameType = (tag.data[0] >> 4) & 0x0F;
+    info.codecId = tag.data[0] & 0x0F;
+
+    // 如果是 H.264 (AVC)：AVCPacketType (1字节) + CompositionTime (3字节)
+    if (info.codecId == 7 && tag.capturedSize >= 5) {
+        info.avcPacketType = tag.data[1];
+        info.cts = readSI24(tag.data + 2);
+    }
+    // PTS = DTS + CTS
+    // 注意：如果 AVCPacketType 为 0 (Header)，CTS 通常为 0
+    info.pts = static_cast<int64_t>(tag.dts) + info.cts;
+    return true;
+}
+
+bool parseAudioInfo(const FlvTag& tag, FlvAudioInfo& info) {
+    info = FlvAudioInfo();
+    if (tag.capturedSize == 0) return false;
+
+    // 第1个字节：SoundFormat(4bit) Rate(2bit) Size(1bit) Type(1bit)
+    static const int RATES[] = {5500, 11000, 22050, 44100};
+    const uint8_t val = tag.data[0];
+    info.format = (val >> 4) & 0x0F;
+    info.sampleRate = RATES[(val >> 2) & 0x03];
+    info.sampleBits = (val & 0x02) ? 16 : 8;
+    info.channels = (val & 0x01) ? 2 : 1;
+
+    if (info.format == 10 && tag.capturedSize >= 2) {
+        info.aacPacketType = tag.data[1];
+    }
+    return true;
+}
+
+FLVParser::FLVParser(HeaderCallback onHeader, TagCallback onTag, size_t maxBufferedTag)
+    : onHeader_(std::move(onHeader)), onTag_(std::move(onTag)), maxBufferedTag_(maxBufferedTag) {
+}
+
+bool FLVParser::fail(const std::string& reason) {
+    failed_ = true;
+    error_ = reason;
+    return false;
+}
+
+bool FLVParser::parseHeader(const uint8_t* p) {
+    // Signature Check
+    if (p[0] != 'F' || p[1] != 'L' || p[2] != 'V') {
+        return fail("不是有效的 FLV 文件 (Signature 错误)");
+    }
+    FlvHeader header;
+    header.version = p[3];
+    header.hasAudio = (p[4] & 0x04) != 0;
+    header.hasVideo = (p[4] & 0x01) != 0;
+    header.headerSize = readUI32(p + 5);
+    if (header.headerSize > MAX_HEADER_SIZE) {
+        return fail("Header Size 异常: " + std::to_string(header.headerSize));
+    }
+    if (onHeader_) onHeader_(header);
+    headerDone_ = true;
+
+    // 跳过 Header 可能存在的填充字节，通常 headerSize=9
+    const uint32_t size = std::max<uint32_t>(9, header.headerSize);
+    skip_ = size - 9;
+    offset_ += size;
+    return true;
+}
+
+void FLVParser::emitTag(const uint8_t* prefix, const uint8_t* data, uint32_t capturedSize) {
+    FlvTag tag;
+    tag.index = tagCount_++;
+    tag.offset = offset_ + 4;
+    tag.prevTagSize = readUI32(prefix);
+    tag.type = prefix[4];
+    tag.dataSize = readUI24(prefix + 5);
+    // 时间戳计算：Timestamp(低24位) | TimestampExtended(高8位)
+    tag.dts = (static_cast<uint32_t>(prefix[11]) << 24) | readUI24(prefix + 8);
+    tag.streamId = readUI24(prefix + 12);
+    tag.data = data;
+    tag.capturedSize = capturedSize;
+    offset_ += TAG_PREFIX_SIZE + tag.dataSize;
+    if (onTag_) onTag_(tag);
+}
+
+size_t FLVParser::consumeTags(const uint8_t* data, size_t size) {
+    size_t pos = 0;
+    while (size - pos >= TAG_PREFIX_SIZE) {
+        const uint8_t* p = data + pos;
+        const uint32_t dataSize = readUI24(p + 5);
+        if (size - pos < TAG_PREFIX_SIZE + dataSize) break;
+        emitTag(p, p + TAG_PREFIX_SIZE, dataSize);
+        pos += TAG_PREFIX_SIZE + dataSize;
+    }
+    return pos;
+}
+
+bool FLVParser::feed(const uint8_t* data, size_t size) {
+    if (failed_) return false;
+    fed_ += size;
+
+    while (size > 0) {
+        // 1. 丢弃 Header 填充或超出缓冲上限的 Tag Data
+        if (skip_ > 0) {
+            const size_t n = static_cast<size_t>(std::min<uint64_t>(skip_, size));
+            skip_ -= n;
+            data += n;
+            size -= n;
+            if (skip_ == 0 && truncatedPending_) {
+                truncatedPending_ = false;
+                emitTag(stash_.data(), stash_.data() + TAG_PREFIX_SIZE,
+                        static_cast<uint32_t>(stash_.size() - TAG_PREFIX_SIZE));
+                stash_.clear();
+            }
+            continue;
+        }
+
+        // 2. FLV Header 只有 9 字节，总是先凑到 stash_ 里
+        if (!headerDone_) {
+            const size_t n = std::min(9 - stash_.size(), size);
+            stash_.insert(stash_.end(), data, data + n);
+            data += n;
+            size -= n;
+            if (stash_.size() == 9) {
+                if (!parseHeader(stash_.data())) return false;
+                stash_.clear();
+            }
+            continue;
+        }
+
+        // 3. 没有跨块的残留时，完整的 Tag 直接在调用方的数据上解析
+        if (stash_.empty()) {
+            const size_t used = consumeTags(data, size);
+            data += used;
+            size -= used;
+            if (size == 0) break;
+        }
+
+        // 4. 跨块的 Tag：先凑齐 15 字节的前缀，知道长度后再凑 Tag Data (最多 maxBufferedTag_)
+        if (stash_.size() < TAG_PREFIX_SIZE) {
+            const size_t n = std::min(TAG_PREFIX_SIZE - stash_.size(), size);
+            stash_.insert(stash_.end(), data, data + n);
+            data += n;
+            size -= n;
+            if (stash_.size() < TAG_PREFIX_SIZE) continue;
+        }
+        const uint32_t dataSize = readUI24(stash_.data() + 5);
+        const size_t captured = std::min<size_t>(dataSize, maxBufferedTag_);
+        const size_t target = TAG_PREFIX_SIZE + captured;
+        if (stash_.capacity() < target) stash_.reserve(target);
+        const size_t n = std::min(target - stash_.size(), size);
+        stash_.insert(stash_.end(), data, data + n);
+        data += n;
+        size -= n;
+        if (stash_.size() == target) {
+            if (captured == dataSize) {
+                emitTag(stash_.data(), stash_.data() + TAG_PREFIX_SIZE, dataSize);
+                stash_.clear();
+            } else {
+                // Tag 太大，剩下的部分跳过，跳完再交出
+                skip_ = dataSize - captured;
+                truncatedPending_ = true;
+            }
+        }
+    }
+    return true;
+}
+
+bool FLVParser::finish() {
+    if (failed_) return false;
+    if (!headerDone_) return fail("数据太短，没有完整的 FLV Header");
+    // 最后一个 PreviousTagSize (4 字节) 后面没有 Tag，不算截断
+    trailing_ = fed_ > offset_ ? fed_ - offset_ : 0;
+    if (trailing_ <= 4) trailing_ = 0;
+    return true;
+}
+
+bool FLVParser::parseFile(const std::string& filename, bool useMmap, size_t windowSize, std::string* error) {
+    bool ok = true;
+    bool mapped = false;
+    if (useMmap) {
+        MappedFile file;
+        if (file.open(filename.c_str())) {
+            mapped = true;
+            ok = feed(file.data(), file.size());
+        }
+        // 映射失败时退回窗口读取
+    }
+
+    if (!mapped) {
+        FILE* f = fopen(filename.c_str(), "rb");
+        if (!f) {
+            if (error) *error = "无法打开文件 " + filename;
+            return false;
+        }
+        // 每次直接读满一个大窗口，不需要 stdio 再缓冲一遍
+        setvbuf(f, nullptr, _IONBF, 0);
+
+        std::vector<uint8_t> window(std::max<size_t>(windowSize, 64 * 1024));
+        size_t n;
+        while (ok && (n = fread(window.data(), 1, window.size(), f)) > 0) {
+            ok = feed(window.data(), n);
+        }
+        if (ok && ferror(f)) ok = fail("读取文件失败");
+        fclose(f);
+    }
+
+    ok = ok && finish();
+    if (!ok && error) *error = error_;
+    return ok;
+}
@@ -0,0 +1,191 @@
+#ifndef FLVPARSER_H
+#define FLVPARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// ==========================================
+// 1. 辅助工具：大端序读取与格式化
+// ==========================================
+
+// 读取 4 字节无符号整数 (Big Endian)
+inline uint32_t readUI32(const uint8_t* buffer) {
+    return (static_cast<uint32_t>(buffer[0]) << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3];
+}
+
+// 读取 3 字节无符号整数 (Big Endian)
+inline uint32_t readUI24(const uint8_t* buffer) {
+    return (buffer[0] << 16) | (buffer[1] << 8) | buffer[2];
+}
+
+// 读取 3 字节有符号整数 (CompositionTime 是 SI24)
+inline int32_t readSI24(const uint8_t* buffer) {
+    uint32_t val = (buffer[0] << 16) | (buffer[1] << 8) | buffer[2];
+    // 如果第 24 位是 1，说明是负数，需要进行符号扩展
+    if (val & 0x800000) {
+        val |= 0xFF000000;
+    }
+    return static_cast<int32_t>(val);
+}
+
+// 读取 2 字节无符号整数
+inline uint16_t readUI16(const uint8_t* buffer) {
+    return static_cast<uint16_t>((buffer[0] << 8) | buffer[1]);
+}
+
+// 格式化输出时间戳
+std::string formatTime(int64_t ms);
+
+// ==========================================
+// 2. Header / Tag 结构
+// ==========================================
+
+enum FlvTagType {
+    FLV_TAG_AUDIO = 0x08,
+    FLV_TAG_VIDEO = 0x09,
+    FLV_TAG_SCRIPT = 0x12,
+};
+
+/// FLV 文件头 (9 字节)
+struct FlvHeader {
+    int version = 0;
+    bool hasAudio = false;
+    bool hasVideo = false;
+    uint32_t headerSize = 0;   ///< DataOffset，通常为 9
+};
+
+/**
+ * @brief 一个 Tag
+ *
+ * data 直接指向映射的文件或读取缓冲，不做拷贝，只在回调期间有效。
+ * 跨 feed() 的 Tag 会被拷贝到解析器内部缓冲，超过缓冲上限时只保留开头 capturedSize 字节。
+ */
+struct FlvTag {
+    uint64_t index = 0;        ///< Tag 序号
+    uint64_t offset = 0;       ///< Tag Header 在文件中的偏移
+    uint32_t prevTagSize = 0;  ///< Tag 前面的 PreviousTagSize 字段
+    uint8_t type = 0;          ///< FlvTagType
+    uint32_t dataSize = 0;
+    uint32_t dts = 0;          ///< Timestamp | TimestampExtended << 24
+    uint32_t streamId = 0;     ///< 总是 0
+    const uint8_t* data = nullptr;
+    uint32_t capturedSize = 0; ///< data 中可用的字节数，小于 dataSize 说明 Tag Data 被截断
+};
+
+/// 视频 Tag Data 开头的字段
+struct FlvVideoInfo {
+    int frameType = 0;         ///< 1: 关键帧, 2: 普通帧
+    int codecId = 0;           ///< 7: AVC
+    int avcPacketType = -1;    ///< 0: Sequence Header, 1: NALU, 2: End of Sequence; 非 AVC 为 -1
+    int32_t cts = 0;           ///< CompositionTime
+    int64_t pts = 0;           ///< DTS + CTS
+};
+
+/// 音频 Tag Data 开头的字段
+struct FlvAudioInfo {
+    int format = 0;            ///< 10: AAC, 2: MP3
+    int sampleRate = 0;        ///< 由 SoundRate 映射 (AAC 忽略此字段，实际信息在 Sequence Header 中)
+    int sampleBits = 0;        ///< 8 / 16
+    int channels = 0;          ///< 1 / 2
+    int aacPacketType = -1;    ///< 0: Sequence Header, 1: Raw Data; 非 AAC 为 -1
+};
+
+/// 解析视频 Tag 的第 1 个字节和 AVC 包头，Data 为空时返回 false
+bool parseVideoInfo(const FlvTag& tag, FlvVideoInfo& info);
+
+/// 解析音频 Tag 的第 1 个字节和 AAC 包类型，Data 为空时返回 false
+bool parseAudioInfo(const FlvTag& tag, FlvAudioInfo& info);
+
+// ==========================================
+// 3. 核心解析逻辑
+// ==========================================
+
+/**
+ * @brief FLV Tag 遍历
+ *
+ * 核心是可恢复的状态机 feed()：数据可以按任意大小、任意边界分块送入
+ * (管道、socket、直播拉流)，每凑齐一个完整 Tag 立即回调。
+ * 完整落在本次数据块里的 Tag 直接交出指向调用方数据的指针，不做拷贝；
+ * 只有跨块的那一个 Tag 才拷贝到内部缓冲，缓冲最多 maxBufferedTag 字节，
+ * 更大的 Tag (例如带巨大关键帧表的 Script Tag) 只保留开头部分，其余跳过，内存占用有上限。
+ *
+ * parseFile() 在此之上读取文件：优先把整个文件映射到内存一次 feed，
+ * 映射失败或关闭时用一块可复用的大缓冲分窗口 fread 后 feed。
+ */
+class FLVParser {
+public:
+    using HeaderCallback = std::function<void(const FlvHeader&)>;
+    using TagCallback = std::function<void(const FlvTag&)>;
+
+    /// 跨块 Tag 的默认缓冲上限
+    static const size_t DEFAULT_MAX_BUFFERED_TAG = 4 * 1024 * 1024;
+
+    FLVParser(HeaderCallback onHeader, TagCallback onTag, size_t maxBufferedTag = DEFAULT_MAX_BUFFERED_TAG);
+
+    /**
+     * @brief 送入下一块数据，数据中凑齐的 Tag 立即回调
+     * @return bool 数据格式错误时返回 false，原因见 error()，之后的 feed 都会失败
+     */
+    bool feed(const uint8_t* data, size_t size);
+
+    /**
+     * @brief 数据结束，统计末尾不完整的字节
+     * @return bool 连 FLV Header 都不完整时返回 false
+     */
+    bool finish();
+
+    const std::string& error() const { return error_; }
+
+    /// 已经送入的字节数
+    uint64_t bytesFed() const { return fed_; }
+
+    /// 内部缓冲中尚未凑齐的字节数
+    size_t bufferedBytes() const { return stash_.size(); }
+
+    /**
+     * @brief 解析整个文件
+     * @param useMmap 是否使用内存映射，false 时按窗口读取
+     * @param windowSize 读取窗口大小
+     * @param error 失败时写入原因
+     */
+    bool parseFile(const std::string& filename, bool useMmap, size_t windowSize, std::string* error);
+
+    uint64_t tagCount() const { return tagCount_; }
+
+    /// 已解析的字节数 (到最后一个完整 Tag 为止)
+    uint64_t bytesParsed() const { return offset_; }
+
+    /// 数据末尾不完整的字节数 (被截断的最后一个 Tag)，finish() 之后有效
+    uint64_t trailingBytes() const { return trailing_; }
+
+private:
+    bool parseHeader(const uint8_t* p);
+
+    /// 处理 data 开头所有完整的 Tag，返回用掉的字节数
+    size_t consumeTags(const uint8_t* data, size_t size);
+
+    /// prefix 为 PreviousTagSize + Tag Header 共 15 字节
+    void emitTag(const uint8_t* prefix, const uint8_t* data, uint32_t capturedSize);
+
+    bool fail(const std::string& reason);
+
+    HeaderCallback onHeader_;
+    TagCallback onTag_;
+    size_t maxBufferedTag_;
+    bool headerDone_ = false;
+    bool failed_ = false;
+    std::string error_;
+    uint64_t fed_ = 0;
+    uint64_t offset_ = 0;          ///< 下一个未处理单元的文件偏移
+    uint64_t tagCount_ = 0;
+    uint64_t trailing_ = 0;
+
+    std::vector<uint8_t> stash_;   ///< 跨块的 Header 或 Tag
+    uint64_t skip_ = 0;            ///< 还要丢弃的字节 (Header 填充或超出缓冲上限的 Tag Data)
+    bool truncatedPending_ = false; ///< stash_ 中的 Tag 等 skip_ 跳完后交出
+};
+
+#endif // FLVPARSER_H
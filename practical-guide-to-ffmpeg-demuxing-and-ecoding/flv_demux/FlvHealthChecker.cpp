@@ -0,0 +1,227 @@
+#include "FlvHealthChecker.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+/// 每类问题在报告里最多列出的条数
+static const size_t MAX_LISTED_EVENTS = 8;
+
+/// 码率表最多输出的行数，时间长时每行合并多秒
+static const uint32_t MAX_BITRATE_ROWS = 30;
+
+static void printLine(std::ostream& os, const char* fmt, ...) {
+    char line[512];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    os << line << '\n';
+}
+
+static const char* tagTypeName(uint8_t type) {
+    switch (type) {
+        case FLV_TAG_AUDIO: return "audio";
+        case FLV_TAG_VIDEO: return "video";
+        case FLV_TAG_SCRIPT: return "script";
+        default: return "unknown";
+    }
+}
+
+FlvHealthChecker::FlvHealthChecker(const Options& options) : options_(options) {
+}
+
+void FlvHealthChecker::record(EventKind kind, const FlvTag& tag, int64_t from, int64_t to) {
+    counts_[kind]++;
+    if (events_[kind].size() < MAX_LISTED_EVENTS) {
+        events_[kind].push_back({tag.index, tag.offset, tag.type, from, to});
+    }
+}
+
+void FlvHealthChecker::addTag(const FlvTag& tag) {
+    // PreviousTagSize：第一个为 0，之后等于 11 + 上一个 Tag 的 DataSize
+    if (tag.prevTagSize != expectedPrevTagSize_ && !(firstTag_ && tag.prevTagSize == 0)) {
+        record(EVENT_PREV_TAG_SIZE, tag, expectedPrevTagSize_, tag.prevTagSize);
+    }
+    firstTag_ = false;
+    expectedPrevTagSize_ = 11 + tag.dataSize;
+
+    if (tag.type != FLV_TAG_VIDEO && tag.type != FLV_TAG_AUDIO) return;
+    const bool video = tag.type == FLV_TAG_VIDEO;
+    StreamStats& s = video ? video_ : audio_;
+
+    s.tags++;
+    s.bytes += tag.dataSize;
+    // Sequence Header 不是一帧
+    bool frame = true;
+    if (video) {
+        FlvVideoInfo v;
+        if (parseVideoInfo(tag, v) && v.avcPacketType == 0) frame = false;
+    } else {
+        FlvAudioInfo a;
+        if (parseAudioInfo(tag, a) && a.aacPacketType == 0) frame = false;
+    }
+    if (frame) s.frames++;
+
+    Second& sec = seconds_[tag.dts / 1000];
+    (video ? sec.videoBytes : sec.audioBytes) += tag.dataSize;
+
+    checkTimestamp(s, tag);
+    checkDrift(tag);
+}
+
+void FlvHealthChecker::checkTimestamp(StreamStats& s, const FlvTag& tag) {
+    if (!s.seen) {
+        s.seen = true;
+        s.firstDts = s.lastDts = s.maxDts = tag.dts;
+        return;
+    }
+    const int64_t delta = static_cast<int64_t>(tag.dts) - s.lastDts;
+    if (std::llabs(delta) >= options_.jumpMs) {
+        record(EVENT_JUMP, tag, s.lastDts, tag.dts);
+    } else if (delta < 0) {
+        record(EVENT_REGRESSION, tag, s.lastDts, tag.dts);
+    } else if (delta > options_.gapMs) {
+        record(EVENT_GAP, tag, s.lastDts, tag.dts);
+    }
+    s.lastDts = tag.dts;
+    s.maxDts = std::max(s.maxDts, tag.dts);
+}
+
+void FlvHealthChecker::checkDrift(const FlvTag& tag) {
+    if (!audio_.seen || !video_.seen) return;
+
+    // 正数：音频领先视频；负数：视频领先音频
+    const int64_t drift = static_cast<int64_t>(audio_.lastDts) - video_.lastDts;
+    driftSum_ += std::llabs(drift);
+    driftSamples_++;
+    if (drift > maxAudioAhead_) {
+        maxAudioAhead_ = drift;
+        maxAudioAheadAt_ = video_.lastDts;
+    } else if (-drift > maxVideoAhead_) {
+        maxVideoAhead_ = -drift;
+        maxVideoAheadAt_ = video_.lastDts;
+    }
+
+    // 连续超过阈值的一段只算一次
+    const bool over = std::llabs(drift) > options_.driftMs;
+    if (over && !inDrift_) record(EVENT_DRIFT, tag, video_.lastDts, audio_.lastDts);
+    inDrift_ = over;
+}
+
+uint64_t FlvHealthChecker::problemCount() const {
+    uint64_t n = 0;
+    for (int k = 0; k < EVENT_KIND_COUNT; k++) n += counts_[k];
+    if (trailingBytes_ > 0) n++;
+    return n;
+}
+
+void FlvHealthChecker::printStream(std::ostream& os, const char* name, const StreamStats& s, bool video) const {
+    if (!s.seen) {
+        printLine(os, "%s: 没有数据", name);
+        return;
+    }
+    const uint32_t span = s.maxDts - s.firstDts;
+    char rate[64] = "";
+    // N 帧只覆盖 N-1 个帧间隔
+    if (video && span > 0 && s.frames > 1) {
+        snprintf(rate, sizeof(rate), ", %.2f fps", (s.frames - 1) * 1000.0 / span);
+    }
+    printLine(os, "%s: %llu tags, %s - %s%s, avg %.0f kbps", name, static_cast<unsigned long long>(s.tags),
+              formatTime(s.firstDts).c_str(), formatTime(s.maxDts).c_str(), rate,
+              span > 0 ? s.bytes * 8.0 / span : 0.0);
+}
+
+void FlvHealthChecker::printEvents(std::ostream& os, EventKind kind) const {
+    for (const Event& e : events_[kind]) {
+        if (kind == EVENT_PREV_TAG_SIZE) {
+            printLine(os, "    #%llu @ %llu: %lld (应为 %lld)", static_cast<unsigned long long>(e.index),
+                      static_cast<unsigned long long>(e.offset), static_cast<long long>(e.to),
+                      static_cast<long long>(e.from));
+        } else if (kind == EVENT_DRIFT) {
+            printLine(os, "    #%llu @ %llu: video %s / audio %s (%+lldms)", static_cast<unsigned long long>(e.index),
+                      static_cast<unsigned long long>(e.offset), formatTime(e.from).c_str(),
+                      formatTime(e.to).c_str(), static_cast<long long>(e.to - e.from));
+        } else {
+            printLine(os, "    %s #%llu @ %llu: %s -> %s (%+lldms)", tagTypeName(e.type),
+                      static_cast<unsigned long long>(e.index), static_cast<unsigned long long>(e.offset),
+                      formatTime(e.from).c_str(), formatTime(e.to).c_str(), static_cast<long long>(e.to - e.from));
+        }
+    }
+    if (counts_[kind] > events_[kind].size()) {
+        printLine(os, "    ... 另有 %llu 处", static_cast<unsigned long long>(counts_[kind] - events_[kind].size()));
+    }
+}
+
+void FlvHealthChecker::printBitrateTable(std::ostream& os) const {
+    if (seconds_.empty()) return;
+    const uint32_t first = seconds_.begin()->first;
+    const uint32_t last = seconds_.rbegin()->first;
+    const uint32_t span = last - first + 1;
+    const uint32_t bin = (span + MAX_BITRATE_ROWS - 1) / MAX_BITRATE_ROWS;
+
+    // 每行 1 秒时平均值就是峰值，不用单独列出
+    printLine(os, "Bitrate (kbps, 每行 %u 秒):", bin);
+    if (bin > 1) printLine(os, "  %-21s %8s %8s %8s %8s", "time", "video", "max", "audio", "max");
+    else printLine(os, "  %-21s %8s %8s", "time", "video", "audio");
+    auto it = seconds_.begin();
+    for (uint32_t start = first; start <= last; start += bin) {
+        const uint32_t end = std::min(last, start + bin - 1);
+        uint64_t videoBytes = 0, audioBytes = 0, videoMax = 0, audioMax = 0;
+        // 没有数据的秒不在 map 里，按 0 计入平均值
+        for (; it != seconds_.end() && it->first <= end; ++it) {
+            videoBytes += it->second.videoBytes;
+            audioBytes += it->second.audioBytes;
+            videoMax = std::max(videoMax, it->second.videoBytes);
+            audioMax = std::max(audioMax, it->second.audioBytes);
+        }
+        const double seconds = end - start + 1;
+        char range[64];
+        snprintf(range, sizeof(range), "%s-%s", formatTime(start * 1000LL).c_str(),
+                 formatTime((end + 1) * 1000LL).c_str());
+        if (bin > 1) {
+            printLine(os, "  %-21s %8.0f %8.0f %8.0f %8.0f", range, videoBytes * 8 / 1000.0 / seconds,
+                      videoMax * 8 / 1000.0, audioBytes * 8 / 1000.0 / seconds, audioMax * 8 / 1000.0);
+        } else {
+            printLine(os, "  %-21s %8.0f %8.0f", range, videoBytes * 8 / 1000.0, audioBytes * 8 / 1000.0);
+        }
+        if (end == last) break;
+    }
+}
+
+void FlvHealthChecker::printReport(std::ostream& os) const {
+    os << "\n========= Health Report =========\n";
+    printStream(os, "Video", video_, true);
+    printStream(os, "Audio", audio_, false);
+
+    printLine(os, "DTS 倒退: %llu", static_cast<unsigned long long>(counts_[EVENT_REGRESSION]));
+    printEvents(os, EVENT_REGRESSION);
+    printLine(os, "DTS 间隙 (> %ums): %llu", options_.gapMs, static_cast<unsigned long long>(counts_[EVENT_GAP]));
+    printEvents(os, EVENT_GAP);
+    printLine(os, "DTS 跳变 (>= %ums): %llu", options_.jumpMs, static_cast<unsigned long long>(counts_[EVENT_JUMP]));
+    printEvents(os, EVENT_JUMP);
+
+    if (driftSamples_ > 0) {
+        printLine(os, "A/V 交织漂移: 平均 %.0fms, 音频最多领先 %lldms (视频 %s 处), 视频最多领先 %lldms (视频 %s 处)",
+                  driftSum_ / driftSamples_, static_cast<long long>(maxAudioAhead_),
+                  formatTime(maxAudioAheadAt_).c_str(), static_cast<long long>(maxVideoAhead_),
+                  formatTime(maxVideoAheadAt_).c_str());
+        printLine(os, "A/V 漂移超过 %ums: %llu 段", options_.driftMs,
+                  static_cast<unsigned long long>(counts_[EVENT_DRIFT]));
+        printEvents(os, EVENT_DRIFT);
+    }
+
+    printLine(os, "PreviousTagSize 不一致: %llu", static_cast<unsigned long long>(counts_[EVENT_PREV_TAG_SIZE]));
+    printEvents(os, EVENT_PREV_TAG_SIZE);
+    if (trailingBytes_ > 0) {
+        printLine(os, "文件结尾不完整: %llu 字节 (文件可能被截断)", static_cast<unsigned long long>(trailingBytes_));
+    }
+
+    printBitrateTable(os);
+
+    const uint64_t problems = problemCount();
+    if (problems == 0) os << "Result: OK\n";
+    else printLine(os, "Result: 发现 %llu 处问题", static_cast<unsigned long long>(problems));
+    os.flush();
+}
@@ -0,0 +1,110 @@
+#ifndef FLVHEALTHCHECKER_H
+#define FLVHEALTHCHECKER_H
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include "FLVParser.h"
+
+/**
+ * @brief FLV 流健康检查
+ *
+ * 在 FLVParser 的 Tag 回调里调用 addTag()，边解析边汇总，不保存逐 Tag 数据：
+ *   - 每秒音频 / 视频码率
+ *   - DTS 倒退、间隙 (gap) 和大跳变 (jump)
+ *   - 音视频交织漂移：按文件顺序，最近的音频 DTS 和视频 DTS 相差多少
+ *   - PreviousTagSize 是否等于 11 + 上一个 Tag 的 DataSize
+ *   - 文件末尾是否有不完整的 Tag (截断)
+ * 最后 printReport() 输出一份几十行的报告，用来快速判断一段录制有没有问题。
+ */
+class FlvHealthChecker {
+public:
+    struct Options {
+        uint32_t gapMs = 1000;     ///< 同一路流相邻 DTS 前进超过这个值算间隙
+        uint32_t jumpMs = 10000;   ///< 前进或后退超过这个值算跳变 (时间戳重置、回绕等)
+        uint32_t driftMs = 500;    ///< 音视频 DTS 相差超过这个值算交织漂移
+    };
+
+    explicit FlvHealthChecker(const Options& options);
+
+    void addTag(const FlvTag& tag);
+
+    /// 解析结束后传入 FLVParser::trailingBytes()，非 0 时算一处问题
+    void setTrailingBytes(uint64_t bytes) { trailingBytes_ = bytes; }
+
+    /// 发现的问题个数：时间戳异常 + 漂移段数 + PreviousTagSize 不一致 + 结尾截断
+    uint64_t problemCount() const;
+
+    void printReport(std::ostream& os) const;
+
+private:
+    enum EventKind {
+        EVENT_REGRESSION,
+        EVENT_GAP,
+        EVENT_JUMP,
+        EVENT_DRIFT,
+        EVENT_PREV_TAG_SIZE,
+        EVENT_KIND_COUNT,
+    };
+
+    /// 报告里列出的一处问题
+    struct Event {
+        uint64_t index;
+        uint64_t offset;
+        uint8_t type;          ///< 出问题的 Tag 类型
+        int64_t from;          ///< 倒退 / 间隙 / 跳变：前一个 DTS；漂移：视频 DTS；PreviousTagSize：期望值
+        int64_t to;            ///< 倒退 / 间隙 / 跳变：当前 DTS；漂移：音频 DTS；PreviousTagSize：实际值
+    };
+
+    struct StreamStats {
+        bool seen = false;
+        uint64_t tags = 0;
+        uint64_t frames = 0;   ///< 不含 Sequence Header
+        uint64_t bytes = 0;
+        uint32_t firstDts = 0;
+        uint32_t lastDts = 0;
+        uint32_t maxDts = 0;
+    };
+
+    /// 一秒内 (按 DTS) 的数据量
+    struct Second {
+        uint64_t videoBytes = 0;
+        uint64_t audioBytes = 0;
+    };
+
+    void checkTimestamp(StreamStats& s, const FlvTag& tag);
+
+    void checkDrift(const FlvTag& tag);
+
+    void record(EventKind kind, const FlvTag& tag, int64_t from, int64_t to);
+
+    void printStream(std::ostream& os, const char* name, const StreamStats& s, bool video) const;
+
+    void printEvents(std::ostream& os, EventKind kind) const;
+
+    void printBitrateTable(std::ostream& os) const;
+
+    Options options_;
+    StreamStats video_;
+    StreamStats audio_;
+    std::map<uint32_t, Second> seconds_;
+
+    uint64_t counts_[EVENT_KIND_COUNT] = {};
+    std::vector<Event> events_[EVENT_KIND_COUNT];   ///< 每类只保留前几条
+
+    bool firstTag_ = true;
+    uint32_t expectedPrevTagSize_ = 0;
+    uint64_t trailingBytes_ = 0;
+
+    bool inDrift_ = false;
+    int64_t maxAudioAhead_ = 0;
+    int64_t maxVideoAhead_ = 0;
+    uint32_t maxAudioAheadAt_ = 0;   ///< 出现最大漂移时的视频 DTS
+    uint32_t maxVideoAheadAt_ = 0;
+    double driftSum_ = 0;
+    uint64_t driftSamples_ = 0;
+};
+
+#endif // FLVHEALTHCHECKER_H
@@ -0,0 +1,242 @@
+#include "FlvKeyframeIndex.h"
+#include "Amf0.h"
+#include "FlvMetaData.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+/// onMetaData 超过这个大小就不改写 (正常只有几百字节，带索引的几百 KB)
+static const uint32_t MAX_META_SIZE = 16 * 1024 * 1024;
+
+void FlvKeyframeIndex::addTag(const FlvTag& tag) {
+    if (firstTagOffset_ == 0) firstTagOffset_ = tag.offset;
+
+    if (tag.type == FLV_TAG_SCRIPT) {
+        if (!hasMetaData_ && isOnMetaData(tag.data, tag.capturedSize)) {
+            hasMetaData_ = true;
+            metaOffset_ = tag.offset;
+            metaSize_ = tag.dataSize;
+        }
+        return;
+    }
+    if (tag.type != FLV_TAG_VIDEO) return;
+
+    FlvVideoInfo v;
+    if (!parseVideoInfo(tag, v) || v.frameType != 1 || v.avcPacketType == 0) return;
+    // 二分查找要求时间单调，倒退的关键帧不收
+    if (!entries_.empty() && tag.dts < entries_.back().dts) {
+        skipped_++;
+        return;
+    }
+    entries_.push_back({tag.dts, tag.offset});
+}
+
+const FlvKeyframeIndex::Entry* FlvKeyframeIndex::seek(uint32_t timeMs) const {
+    if (entries_.empty()) return nullptr;
+    auto it = std::upper_bound(entries_.begin(), entries_.end(), timeMs,
+                               [](uint32_t t, const Entry& e) { return t < e.dts; });
+    return it == entries_.begin() ? &entries_.front() : &*(it - 1);
+}
+
+/**
+ * @brief 生成新的 onMetaData Data
+ *
+ * old 为原来的 onMetaData (可以为空)，除 keyframes 和 filesize 外的属性原样保留，这两个按新文件重写。
+ * 新 Data 的长度只和关键帧个数有关，与 delta、fileSize 无关，所以可以先按 0 算出长度再生成一次。
+ */
+static bool buildMetaData(const std::vector<uint8_t>& old, const std::vector<FlvKeyframeIndex::Entry>& entries,
+                          uint64_t shiftFrom, int64_t delta, uint64_t fileSize, std::vector<uint8_t>& out,
+                          std::string* error) {
+    out.clear();
+    amf0WriteString(out, "onMetaData");
+    out.push_back(AMF0_ECMA_ARRAY);
+    const size_t countPos = out.size();
+    amf0WriteUI32(out, 0);
+
+    uint32_t count = 0;
+    size_t tail = old.size();
+    if (!old.empty()) {
+        const uint8_t* p = old.data();
+        const size_t size = old.size();
+        size_t pos = 13;
+        if (size > pos + 4 && p[pos] == AMF0_ECMA_ARRAY) {
+            pos += 5;
+        } else if (size > pos && p[pos] == AMF0_OBJECT) {
+            pos += 1;
+        } else {
+            if (error) *error = "onMetaData 不是 ECMA Array / Object，无法改写";
+            return false;
+        }
+        // 逐个属性拷贝，丢掉旧的 keyframes / filesize；没有结束标记的 (被截断的) 也接受
+        while (size - pos >= 2) {
+            const size_t keyLen = readUI16(p + pos);
+            if (keyLen == 0) {
+                pos += std::min<size_t>(3, size - pos);
+                break;
+            }
+            const size_t valuePos = pos + 2 + keyLen;
+            const size_t valueSize = valuePos < size ? amf0SkipValue(p + valuePos, size - valuePos) : 0;
+            if (valueSize == 0) {
+                if (error) *error = "onMetaData 中的 AMF0 数据损坏";
+                return false;
+            }
+            const bool replaced = (keyLen == 9 && memcmp(p + pos + 2, "keyframes", 9) == 0) ||
+                                  (keyLen == 8 && memcmp(p + pos + 2, "filesize", 8) == 0);
+            if (!replaced) {
+                out.insert(out.end(), p + pos, p + valuePos + valueSize);
+                count++;
+            }
+            pos = valuePos + valueSize;
+        }
+        tail = pos;
+    }
+
+    amf0WriteKey(out, "filesize");
+    amf0WriteNumber(out, static_cast<double>(fileSize));
+    count++;
+
+    // keyframes: { filepositions: [...], times: [...] }，和 FFmpeg flvenc 写的格式相同
+    amf0WriteKey(out, "keyframes");
+    out.push_back(AMF0_OBJECT);
+    amf0WriteKey(out, "filepositions");
+    out.push_back(AMF0_STRICT_ARRAY);
+    amf0WriteUI32(out, static_cast<uint32_t>(entries.size()));
+    for (const auto& e : entries) {
+        const uint64_t pos = e.offset >= shiftFrom ? e.offset + delta : e.offset;
+        amf0WriteNumber(out, static_cast<double>(pos));
+    }
+    amf0WriteKey(out, "times");
+    out.push_back(AMF0_STRICT_ARRAY);
+    amf0WriteUI32(out, static_cast<uint32_t>(entries.size()));
+    for (const auto& e : entries) {
+        amf0WriteNumber(out, e.dts / 1000.0);
+    }
+    amf0WriteObjectEnd(out);
+    amf0WriteObjectEnd(out);
+    count++;
+
+    // 原 onMetaData 后面如果还有别的 AMF0 值，原样保留
+    if (tail < old.size()) out.insert(out.end(), old.begin() + tail, old.end());
+
+    out[countPos] = static_cast<uint8_t>(count >> 24);
+    out[countPos + 1] = static_cast<uint8_t>(count >> 16);
+    out[countPos + 2] = static_cast<uint8_t>(count >> 8);
+    out[countPos + 3] = static_cast<uint8_t>(count);
+    return true;
+}
+
+// 文件长度，读写位置回到开头；大于 2GB 的文件也要能取到
+static bool getFileSize(FILE* f, uint64_t* size) {
+#ifdef _WIN32
+    if (_fseeki64(f, 0, SEEK_END) != 0) return false;
+    const int64_t pos = _ftelli64(f);
+#else
+    if (fseeko(f, 0, SEEK_END) != 0) return false;
+    const int64_t pos = ftello(f);
+#endif
+    if (pos < 0) return false;
+    *size = static_cast<uint64_t>(pos);
+    rewind(f);
+    return true;
+}
+
+// 从 in 复制 n 字节到 out，n 为 UINT64_MAX 时复制到文件结尾
+static bool copyBytes(FILE* in, FILE* out, uint64_t n, std::vector<uint8_t>& buffer) {
+    while (n > 0) {
+        const size_t want = static_cast<size_t>(std::min<uint64_t>(n, buffer.size()));
+        const size_t got = fread(buffer.data(), 1, want, in);
+        if (got > 0 && fwrite(buffer.data(), 1, got, out) != got) return false;
+        if (got < want) return n == UINT64_MAX && !ferror(in);
+        if (n != UINT64_MAX) n -= got;
+    }
+    return true;
+}
+
+bool FlvKeyframeIndex::writeWithKeyframes(const std::string& src, const std::string& dst, std::string* error) const {
+    if (firstTagOffset_ == 0) {
+        if (error) *error = "文件中没有 Tag";
+        return false;
+    }
+    if (src == dst) {
+        if (error) *error = "输出文件不能和输入文件相同";
+        return false;
+    }
+    if (hasMetaData_ && metaSize_ > MAX_META_SIZE) {
+        if (error) *error = "onMetaData 太大: " + std::to_string(metaSize_);
+        return false;
+    }
+
+    FILE* in = fopen(src.c_str(), "rb");
+    if (!in) {
+        if (error) *error = "无法打开文件 " + src;
+        return false;
+    }
+    FILE* out = fopen(dst.c_str(), "wb");
+    if (!out) {
+        fclose(in);
+        if (error) *error = "无法创建输出文件 " + dst;
+        return false;
+    }
+
+    std::vector<uint8_t> buffer(1024 * 1024);
+    std::vector<uint8_t> old;
+    std::vector<uint8_t> body;
+    std::string reason;
+
+    uint64_t srcSize = 0;
+    bool ok = getFileSize(in, &srcSize);
+    if (!ok) reason = "无法获取文件大小 " + src;
+
+    // 新的 Script Tag 放在原 onMetaData 的位置，没有 onMetaData 时放在第一个 Tag 前面
+    const uint64_t insertAt = hasMetaData_ ? metaOffset_ : firstTagOffset_;
+    if (ok && !copyBytes(in, out, insertAt, buffer)) {
+        reason = "复制文件失败";
+        ok = false;
+    }
+
+    if (ok && hasMetaData_) {
+        // 旧的 Tag Header + Data + 后面的 PreviousTagSize，新 Tag 会重写这几部分
+        uint8_t header[11];
+        old.resize(metaSize_);
+        uint8_t prevTagSize[4];
+        ok = fread(header, 1, sizeof(header), in) == sizeof(header) && fread(old.data(), 1, old.size(), in) == old.size();
+        if (ok && fread(prevTagSize, 1, sizeof(prevTagSize), in) != sizeof(prevTagSize)) ok = !ferror(in);
+        if (!ok) reason = "读取 onMetaData 失败";
+    }
+
+    if (ok) {
+        ok = buildMetaData(old, entries_, insertAt, 0, 0, body, &reason);
+    }
+    if (ok) {
+        // Script Tag 长度变化量，位于它后面的 Tag 都要后移这么多
+        const int64_t delta = hasMetaData_ ? static_cast<int64_t>(body.size()) - metaSize_
+                                           : static_cast<int64_t>(11 + body.size() + 4);
+        ok = buildMetaData(old, entries_, insertAt, delta, srcSize + delta, body, &reason);
+        if (ok && body.size() > 0xFFFFFF) {
+            reason = "关键帧太多，onMetaData 超过 Tag 的最大长度";
+            ok = false;
+        }
+    }
+    if (ok) {
+        const uint32_t size = static_cast<uint32_t>(body.size());
+        const uint8_t header[11] = {FLV_TAG_SCRIPT, static_cast<uint8_t>(size >> 16), static_cast<uint8_t>(size >> 8),
+                                    static_cast<uint8_t>(size), 0, 0, 0, 0, 0, 0, 0};
+        std::vector<uint8_t> prevTagSize;
+        amf0WriteUI32(prevTagSize, 11 + size);
+        ok = fwrite(header, 1, sizeof(header), out) == sizeof(header) &&
+             fwrite(body.data(), 1, body.size(), out) == body.size() &&
+             fwrite(prevTagSize.data(), 1, prevTagSize.size(), out) == prevTagSize.size() &&
+             copyBytes(in, out, UINT64_MAX, buffer);
+        if (!ok) reason = "写入输出文件失败";
+    }
+
+    fclose(in);
+    ok = fclose(out) == 0 && ok;
+    if (!ok) {
+        if (reason.empty()) reason = "写入输出文件失败";
+        remove(dst.c_str());
+        if (error) *error = reason;
+    }
+    return ok;
+}
@@ -0,0 +1,57 @@
+#ifndef FLVKEYFRAMEINDEX_H
+#define FLVKEYFRAMEINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "FLVParser.h"
+
+/**
+ * @brief 关键帧索引 (时间戳 -> 文件偏移)
+ *
+ * 在 FLVParser 的 Tag 回调里调用 addTag()，解析一遍文件的同时建好索引，
+ * 之后 seek() 对按时间排好序的数组二分查找，不需要再扫描文件。
+ *
+ * writeWithKeyframes() 像 yamdi / flvtool2 一样把索引写进 onMetaData 的
+ * keyframes { filepositions, times }，播放器和 HTTP 拖动服务器读到后可以直接定位。
+ */
+class FlvKeyframeIndex {
+public:
+    struct Entry {
+        uint32_t dts;          ///< 毫秒
+        uint64_t offset;       ///< Tag Header 在文件中的偏移
+    };
+
+    /// 记录视频关键帧 (不含 AVC Sequence Header) 以及第一个 onMetaData 的位置
+    void addTag(const FlvTag& tag);
+
+    const std::vector<Entry>& entries() const { return entries_; }
+
+    /// DTS 比前一个关键帧小而没有收进索引的关键帧个数
+    uint64_t skipped() const { return skipped_; }
+
+    /**
+     * @brief 二分查找 DTS <= timeMs 的最后一个关键帧
+     * @return const Entry* 第一个关键帧之前的时间返回第一个关键帧，索引为空时返回 nullptr
+     */
+    const Entry* seek(uint32_t timeMs) const;
+
+    /**
+     * @brief 复制 src 到 dst，并把关键帧索引写进 onMetaData
+     *
+     * 已有 onMetaData 时保留原有属性，替换其中的 keyframes 和 filesize；没有时在第一个 Tag 前插入一个。
+     * Script Tag 变长后，后面的 Tag 整体后移，filepositions 按 dst 中的偏移写入。
+     */
+    bool writeWithKeyframes(const std::string& src, const std::string& dst, std::string* error) const;
+
+private:
+    std::vector<Entry> entries_;
+    uint64_t skipped_ = 0;
+    uint64_t firstTagOffset_ = 0;  ///< 0 表示还没有 Tag
+    bool hasMetaData_ = false;
+    uint64_t metaOffset_ = 0;
+    uint32_t metaSize_ = 0;
+};
+
+#endif // FLVKEYFRAMEINDEX_H
@@ -0,0 +1,137 @@
+#include "FlvMetaData.h"
+#include "Amf0.h"
+#include "FLVParser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+/// 读取文件开头时每次读取的字节数，onMetaData 通常在前几百字节
+static const size_t META_READ_SIZE = 64 * 1024;
+
+/// 带大索引的 onMetaData 可能有几 MB，读取时允许缓冲到这么大
+static const size_t MAX_META_SIZE = 16 * 1024 * 1024;
+
+bool isOnMetaData(const uint8_t* data, size_t size) {
+    return size >= 13 && data[0] == AMF0_STRING && readUI16(data + 1) == 10 && memcmp(data + 3, "onMetaData", 10) == 0;
+}
+
+static bool keyIs(const char* key, size_t len, const char* name) {
+    return strlen(name) == len && memcmp(key, name, len) == 0;
+}
+
+// keyframes: { filepositions: [...], times: [...] }
+static void decodeKeyframes(const Amf0Value& value, std::vector<FlvKeyframeIndex::Entry>& out) {
+    const Amf0Value positions = value.get("filepositions");
+    const Amf0Value times = value.get("times");
+    const uint32_t n = std::min(positions.count(), times.count());
+    out.assign(n, FlvKeyframeIndex::Entry{0, 0});
+    times.forEachElement([&](uint32_t i, const Amf0Value& v) {
+        if (i >= n) return false;
+        out[i].dts = static_cast<uint32_t>(std::llround(v.number() * 1000));
+        return true;
+    });
+    positions.forEachElement([&](uint32_t i, const Amf0Value& v) {
+        if (i >= n) return false;
+        out[i].offset = static_cast<uint64_t>(v.number());
+        return true;
+    });
+}
+
+bool parseOnMetaData(const uint8_t* data, size_t size, FlvMetaData& meta,
+                     std::vector<FlvKeyframeIndex::Entry>* keyframes) {
+    meta = FlvMetaData();
+    if (keyframes) keyframes->clear();
+    if (!isOnMetaData(data, size)) return false;
+    meta.present = true;
+
+    // 第 1 个值是名字 "onMetaData"，第 2 个值是 ECMA Array (也有编码器写成 Object)
+    const Amf0Value root(data + 13, size - 13);
+    root.forEachProperty([&](const char* key, size_t len, const Amf0Value& v) {
+        // 先按属性名长度分流，避免每个属性都和所有字段名比较一遍
+        switch (len) {
+            case 5:
+                if (keyIs(key, len, "width")) meta.width = v.number();
+                break;
+            case 6:
+                if (keyIs(key, len, "height")) meta.height = v.number();
+                else if (keyIs(key, len, "stereo")) meta.stereo = v.boolean();
+                break;
+            case 7:
+                if (keyIs(key, len, "encoder")) meta.encoder = v.str();
+                break;
+            case 8:
+                if (keyIs(key, len, "duration")) meta.duration = v.number();
+                else if (keyIs(key, len, "filesize")) meta.fileSize = v.number();
+                break;
+            case 9:
+                if (keyIs(key, len, "framerate")) meta.frameRate = v.number();
+                else if (keyIs(key, len, "keyframes")) {
+                    meta.hasKeyframes = true;
+                    meta.keyframeCount = v.get("times").count();
+                    if (keyframes) decodeKeyframes(v, *keyframes);
+                }
+                break;
+            case 12:
+                if (keyIs(key, len, "videocodecid")) meta.videoCodecId = static_cast<int>(v.number(-1));
+                else if (keyIs(key, len, "audiocodecid")) meta.audioCodecId = static_cast<int>(v.number(-1));
+                break;
+            case 13:
+                if (keyIs(key, len, "videodatarate")) meta.videoDataRate = v.number();
+                else if (keyIs(key, len, "audiodatarate")) meta.audioDataRate = v.number();
+                break;
+            case 15:
+                if (keyIs(key, len, "audiosamplerate")) meta.audioSampleRate = v.number();
+                else if (keyIs(key, len, "audiosamplesize")) meta.audioSampleSize = v.number();
+                break;
+            default:
+                break;
+        }
+        return true;
+    });
+    return true;
+}
+
+bool readFileMetaData(const std::string& path, FlvMetaData& meta, std::string* error,
+                      std::vector<FlvKeyframeIndex::Entry>* keyframes) {
+    meta = FlvMetaData();
+    if (keyframes) keyframes->clear();
+
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        if (error) *error = "无法打开文件 " + path;
+        return false;
+    }
+
+    // onMetaData 按规范是第一个 Tag，看到音视频 Tag 就不用再往下读了
+    bool done = false;
+    FLVParser parser(nullptr,
+        [&](const FlvTag& tag) {
+            if (done) return;
+            if (tag.type == FLV_TAG_SCRIPT) {
+                if (isOnMetaData(tag.data, tag.capturedSize)) {
+                    parseOnMetaData(tag.data, tag.capturedSize, meta, keyframes);
+                    done = true;
+                }
+            } else {
+                done = true;
+            }
+        },
+        MAX_META_SIZE);
+
+    std::vector<uint8_t> buffer(META_READ_SIZE);
+    bool ok = true;
+    size_t n;
+    while (ok && !done && (n = fread(buffer.data(), 1, buffer.size(), f)) > 0) {
+        ok = parser.feed(buffer.data(), n);
+    }
+    if (ok && !done && ferror(f)) ok = false;
+    fclose(f);
+
+    if (!ok || (!done && !parser.finish())) {
+        if (error) *error = parser.error().empty() ? "读取文件失败" : parser.error();
+        return false;
+    }
+    return true;
+}
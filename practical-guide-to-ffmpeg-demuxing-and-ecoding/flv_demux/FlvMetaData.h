@@ -0,0 +1,53 @@
+#ifndef FLVMETADATA_H
+#define FLVMETADATA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "FlvKeyframeIndex.h"
+
+/// onMetaData 中常用的字段，缺失的数值为 0 (codec id 为 -1)
+struct FlvMetaData {
+    bool present = false;
+    double duration = 0;           ///< 秒
+    double fileSize = 0;
+    double width = 0;
+    double height = 0;
+    double frameRate = 0;
+    double videoDataRate = 0;      ///< kbps
+    double audioDataRate = 0;      ///< kbps
+    double audioSampleRate = 0;
+    double audioSampleSize = 0;
+    int videoCodecId = -1;         ///< 7: AVC
+    int audioCodecId = -1;         ///< 10: AAC
+    bool stereo = false;
+    std::string encoder;
+    bool hasKeyframes = false;     ///< 是否带 keyframes 索引
+    uint32_t keyframeCount = 0;    ///< keyframes.times 的个数，只读数组头，不解码数组
+};
+
+/// Script Tag 的 Data 是否以 "onMetaData" 开头
+bool isOnMetaData(const uint8_t* data, size_t size);
+
+/**
+ * @brief 解码 onMetaData Script Tag 的 Data
+ *
+ * 一次遍历 ECMA Array，只解码认识的字段，其它的 (包括 keyframes) 只跳过。
+ * keyframes 不为空时才把 keyframes 的 filepositions / times 解码出来。
+ * @return bool 不是 onMetaData 时返回 false；数据被截断时返回已经解出来的部分
+ */
+bool parseOnMetaData(const uint8_t* data, size_t size, FlvMetaData& meta,
+                     std::vector<FlvKeyframeIndex::Entry>* keyframes = nullptr);
+
+/**
+ * @brief 只读取文件开头直到 onMetaData 为止，不扫描整个文件
+ *
+ * 遇到第一个音视频 Tag 还没有 onMetaData 时停止，meta.present 为 false。
+ * @return bool 文件打不开或不是 FLV 时返回 false
+ */
+bool readFileMetaData(const std::string& path, FlvMetaData& meta, std::string* error,
+                      std::vector<FlvKeyframeIndex::Entry>* keyframes = nullptr);
+
+#endif // FLVMETADATA_H
@@ -0,0 +1,249 @@
+#include "FlvTagWriter.h"
+
+#include <algorithm>
+#include <cstdarg>
+
+static const char* tagTypeName(uint8_t type) {
+    switch (type) {
+        case FLV_TAG_AUDIO: return "audio";
+        case FLV_TAG_VIDEO: return "video";
+        case FLV_TAG_SCRIPT: return "script";
+        default: return "unknown";
+    }
+}
+
+bool FlvTagWriter::parseFormat(const std::string& name, Format& format) {
+    if (name == "text") format = FORMAT_TEXT;
+    else if (name == "csv") format = FORMAT_CSV;
+    else if (name == "jsonl") format = FORMAT_JSONL;
+    else if (name == "quiet") format = FORMAT_QUIET;
+    else return false;
+    return true;
+}
+
+FlvTagWriter::FlvTagWriter(Format format, FILE* out) : format_(format), out_(out) {
+    buf_.reserve(OUTPUT_BUFFER_SIZE + 1024);
+}
+
+FlvTagWriter::~FlvTagWriter() {
+    flush();
+}
+
+void FlvTagWriter::appendf(const char* fmt, ...) {
+    char line[512];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (n > 0) buf_.append(line, std::min<size_t>(static_cast<size_t>(n), sizeof(line) - 1));
+}
+
+void FlvTagWriter::appendJsonString(const std::string& s) {
+    buf_ += '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            buf_ += '\\';
+            buf_ += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            appendf("\\u%04x", c);
+        } else {
+            buf_ += c;
+        }
+    }
+    buf_ += '"';
+}
+
+void FlvTagWriter::appendMetaDataJson(const FlvMetaData& meta) {
+    appendf("\"duration\":%.3f,\"width\":%.0f,\"height\":%.0f,\"framerate\":%.3f,\"videodatarate\":%.1f,"
+            "\"audiodatarate\":%.1f,\"videocodecid\":%d,\"audiocodecid\":%d,\"audiosamplerate\":%.0f,"
+            "\"stereo\":%s,\"filesize\":%.0f,\"keyframes\":%u,\"encoder\":",
+            meta.duration, meta.width, meta.height, meta.frameRate, meta.videoDataRate, meta.audioDataRate,
+            meta.videoCodecId, meta.audioCodecId, meta.audioSampleRate, meta.stereo ? "true" : "false", meta.fileSize,
+            meta.keyframeCount);
+    appendJsonString(meta.encoder);
+}
+
+bool FlvTagWriter::flush() {
+    if (!buf_.empty()) {
+        ok_ = fwrite(buf_.data(), 1, buf_.size(), out_) == buf_.size() && ok_;
+        buf_.clear();
+    }
+    ok_ = fflush(out_) == 0 && ok_;
+    return ok_;
+}
+
+void FlvTagWriter::writeHeader(const FlvHeader& header) {
+    if (format_ == FORMAT_TEXT) {
+        appendf("========= FLV File Header =========\n");
+        appendf("Version: %d\n", header.version);
+        appendf("Contains: %s%s\n", header.hasAudio ? "Audio " : "", header.hasVideo ? "Video" : "");
+        appendf("Header Size: %u\n", header.headerSize);
+        appendf("===================================\n");
+    } else if (format_ == FORMAT_CSV) {
+        appendf("index,offset,prev_tag_size,type,size,dts,pts,cts,frame_type,codec_id,packet_type,"
+                "sound_format,sample_rate,sample_bits,channels\n");
+    }
+}
+
+void FlvTagWriter::writeTag(const FlvTag& tag) {
+    switch (format_) {
+        case FORMAT_TEXT: writeText(tag); break;
+        case FORMAT_CSV: writeCsv(tag); break;
+        case FORMAT_JSONL: writeJson(tag); break;
+        case FORMAT_QUIET: return;
+    }
+    if (buf_.size() >= OUTPUT_BUFFER_SIZE) flush();
+}
+
+void FlvTagWriter::writeText(const FlvTag& tag) {
+    // 打印基础信息
+    appendf("\n[Tag #%llu] Type: ", static_cast<unsigned long long>(tag.index));
+    switch (tag.type) {
+        case FLV_TAG_AUDIO: appendf("Audio"); break;
+        case FLV_TAG_VIDEO: appendf("Video"); break;
+        case FLV_TAG_SCRIPT: appendf("Script"); break;
+        default: appendf("Unknown(%d)", tag.type); break;
+    }
+    appendf(" | Size: %u | DTS: %ums (%s)", tag.dataSize, tag.dts, formatTime(tag.dts).c_str());
+    if (tag.capturedSize < tag.dataSize) appendf(" (Data 只缓冲了前 %u 字节)", tag.capturedSize);
+
+    // 详细解析
+    if (tag.type == FLV_TAG_VIDEO) {
+        FlvVideoInfo v;
+        if (parseVideoInfo(tag, v)) {
+            const char* frameDesc = v.frameType == 1 ? "KeyFrame (IDR)" : v.frameType == 2 ? "InterFrame" : "Other";
+            if (v.codecId == 7) appendf("\n    -> Video Info: AVC(H.264), %s", frameDesc);
+            else appendf("\n    -> Video Info: Other(%d), %s", v.codecId, frameDesc);
+
+            if (v.avcPacketType >= 0) {
+                appendf("\n    -> AVC Packet: ");
+                if (v.avcPacketType == 0) {
+                    appendf("Sequence Header (AVCDecoderConfigurationRecord) [SPS/PPS info]");
+                } else if (v.avcPacketType == 1) {
+                    appendf("NALU | CTS: %dms | PTS: %lldms (%s)", v.cts, static_cast<long long>(v.pts),
+                            formatTime(v.pts).c_str());
+                } else if (v.avcPacketType == 2) {
+                    appendf("End of Sequence");
+                }
+            }
+        }
+    } else if (tag.type == FLV_TAG_AUDIO) {
+        FlvAudioInfo a;
+        if (parseAudioInfo(tag, a)) {
+            if (a.format == 10) appendf("\n    -> Audio Info: AAC");
+            else if (a.format == 2) appendf("\n    -> Audio Info: MP3");
+            else appendf("\n    -> Audio Info: Format_%d", a.format);
+            appendf(" | %dHz | %d-bit | %s", a.sampleRate, a.sampleBits, a.channels == 2 ? "Stereo" : "Mono");
+
+            if (a.aacPacketType >= 0) {
+                appendf("\n    -> AAC Packet: ");
+                if (a.aacPacketType == 0) appendf("Sequence Header (AudioSpecificConfig)");
+                else if (a.aacPacketType == 1) appendf("Raw Data");
+            }
+        }
+    } else if (tag.type == FLV_TAG_SCRIPT) {
+        FlvMetaData meta;
+        if (parseOnMetaData(tag.data, tag.capturedSize, meta)) {
+            appendf(" -> MetaData Info");
+            appendf("\n    -> Duration: %s | %.0fx%.0f | %.2f fps | Video %.0f kbps | Audio %.0f kbps",
+                    formatTime(static_cast<int64_t>(meta.duration * 1000)).c_str(), meta.width, meta.height,
+                    meta.frameRate, meta.videoDataRate, meta.audioDataRate);
+            if (!meta.encoder.empty()) appendf(" | Encoder: %.200s", meta.encoder.c_str());
+            if (meta.hasKeyframes) appendf(" | Keyframes: %u", meta.keyframeCount);
+        } else {
+            appendf(" -> Script Data");
+        }
+    }
+    appendf("\n");
+}
+
+void FlvTagWriter::writeCsv(const FlvTag& tag) {
+    appendf("%llu,%llu,%u,%s,%u,%u,", static_cast<unsigned long long>(tag.index),
+            static_cast<unsigned long long>(tag.offset), tag.prevTagSize, tagTypeName(tag.type), tag.dataSize, tag.dts);
+    FlvVideoInfo v;
+    FlvAudioInfo a;
+    if (tag.type == FLV_TAG_VIDEO && parseVideoInfo(tag, v)) {
+        appendf("%lld,%d,%d,%d,", static_cast<long long>(v.pts), v.cts, v.frameType, v.codecId);
+        if (v.avcPacketType >= 0) appendf("%d", v.avcPacketType);
+        appendf(",,,,\n");
+    } else if (tag.type == FLV_TAG_AUDIO && parseAudioInfo(tag, a)) {
+        appendf("%u,0,,,", tag.dts);
+        if (a.aacPacketType >= 0) appendf("%d", a.aacPacketType);
+        appendf(",%d,%d,%d,%d\n", a.format, a.sampleRate, a.sampleBits, a.channels);
+    } else {
+        appendf("%u,0,,,,,,,\n", tag.dts);
+    }
+}
+
+void FlvTagWriter::writeJson(const FlvTag& tag) {
+    appendf("{\"index\":%llu,\"offset\":%llu,\"prev_tag_size\":%u,\"type\":\"%s\",\"size\":%u,\"dts\":%u",
+            static_cast<unsigned long long>(tag.index), static_cast<unsigned long long>(tag.offset), tag.prevTagSize,
+            tagTypeName(tag.type), tag.dataSize, tag.dts);
+    if (tag.capturedSize < tag.dataSize) appendf(",\"captured_size\":%u", tag.capturedSize);
+    FlvVideoInfo v;
+    FlvAudioInfo a;
+    if (tag.type == FLV_TAG_VIDEO && parseVideoInfo(tag, v)) {
+        appendf(",\"pts\":%lld,\"cts\":%d,\"frame_type\":%d,\"codec_id\":%d", static_cast<long long>(v.pts), v.cts,
+                v.frameType, v.codecId);
+        if (v.avcPacketType >= 0) appendf(",\"packet_type\":%d", v.avcPacketType);
+    } else if (tag.type == FLV_TAG_AUDIO && parseAudioInfo(tag, a)) {
+        appendf(",\"sound_format\":%d,\"sample_rate\":%d,\"sample_bits\":%d,\"channels\":%d", a.format, a.sampleRate,
+                a.sampleBits, a.channels);
+        if (a.aacPacketType >= 0) appendf(",\"packet_type\":%d", a.aacPacketType);
+    } else if (tag.type == FLV_TAG_SCRIPT) {
+        FlvMetaData meta;
+        if (parseOnMetaData(tag.data, tag.capturedSize, meta)) {
+            appendf(",\"metadata\":{");
+            appendMetaDataJson(meta);
+            appendf("}");
+        }
+    }
+    appendf("}\n");
+}
+
+void FlvTagWriter::writeMetaData(const std::string& path, const FlvMetaData& meta) {
+    switch (format_) {
+        case FORMAT_TEXT:
+            appendf("%s: ", path.c_str());
+            if (!meta.present) {
+                appendf("没有 onMetaData\n");
+                break;
+            }
+            appendf("%s | %.0fx%.0f | %.2f fps | Video %.0f kbps | Audio %.0f kbps",
+                    formatTime(static_cast<int64_t>(meta.duration * 1000)).c_str(), meta.width, meta.height,
+                    meta.frameRate, meta.videoDataRate, meta.audioDataRate);
+            if (meta.hasKeyframes) appendf(" | Keyframes: %u", meta.keyframeCount);
+            appendf("\n");
+            break;
+        case FORMAT_CSV:
+            if (!metaHeaderWritten_) {
+                appendf("path,has_metadata,duration,width,height,framerate,videodatarate,audiodatarate,"
+                        "videocodecid,audiocodecid,keyframes\n");
+                metaHeaderWritten_ = true;
+            }
+            // 路径里可能有逗号，按 CSV 规则加引号
+            buf_ += '"';
+            for (char c : path) {
+                if (c == '"') buf_ += '"';
+                buf_ += c;
+            }
+            buf_ += '"';
+            appendf(",%d,%.3f,%.0f,%.0f,%.3f,%.1f,%.1f,%d,%d,%u\n", meta.present ? 1 : 0, meta.duration, meta.width,
+                    meta.height, meta.frameRate, meta.videoDataRate, meta.audioDataRate, meta.videoCodecId,
+                    meta.audioCodecId, meta.keyframeCount);
+            break;
+        case FORMAT_JSONL:
+            appendf("{\"path\":");
+            appendJsonString(path);
+            appendf(",\"has_metadata\":%s", meta.present ? "true" : "false");
+            if (meta.present) {
+                appendf(",");
+                appendMetaDataJson(meta);
+            }
+            appendf("}\n");
+            break;
+        case FORMAT_QUIET:
+            return;
+    }
+    if (buf_.size() >= OUTPUT_BUFFER_SIZE) flush();
+}
@@ -0,0 +1,76 @@
+#ifndef FLVTAGWRITER_H
+#define FLVTAGWRITER_H
+
+#include <cstdio>
+#include <string>
+
+#include "FLVParser.h"
+#include "FlvMetaData.h"
+
+/**
+ * @brief 逐 Tag 输出
+ *
+ * 支持原来的可读文本、CSV、JSON Lines 三种格式，以及只输出汇总的安静模式。
+ * onMetaData Script Tag 会解码出时长、分辨率、帧率、码率等字段一起输出。
+ * 每行先格式化到内部缓冲，攒够 OUTPUT_BUFFER_SIZE 再一次 fwrite，
+ * 不会像 std::endl 那样每个 Tag 刷新一次。
+ */
+class FlvTagWriter {
+public:
+    enum Format {
+        FORMAT_TEXT,
+        FORMAT_CSV,
+        FORMAT_JSONL,
+        FORMAT_QUIET,
+    };
+
+    static const size_t OUTPUT_BUFFER_SIZE = 1024 * 1024;
+
+    /// "text" / "csv" / "jsonl" / "quiet"
+    static bool parseFormat(const std::string& name, Format& format);
+
+    /// @param out 输出文件，由调用方负责关闭
+    FlvTagWriter(Format format, FILE* out);
+
+    ~FlvTagWriter();
+
+    FlvTagWriter(const FlvTagWriter&) = delete;
+
+    FlvTagWriter& operator=(const FlvTagWriter&) = delete;
+
+    Format format() const { return format_; }
+
+    /// 文本格式打印文件头信息，CSV 输出列名
+    void writeHeader(const FlvHeader& header);
+
+    void writeTag(const FlvTag& tag);
+
+    /// --metadata 模式：每个文件一行 onMetaData 摘要 (CSV 第一次调用前先输出列名)
+    void writeMetaData(const std::string& path, const FlvMetaData& meta);
+
+    /// 写出缓冲中的内容，写失败时返回 false
+    bool flush();
+
+private:
+    void writeText(const FlvTag& tag);
+
+    void writeCsv(const FlvTag& tag);
+
+    void writeJson(const FlvTag& tag);
+
+    void appendf(const char* fmt, ...);
+
+    /// 追加带引号并转义的 JSON 字符串
+    void appendJsonString(const std::string& s);
+
+    /// JSON 中 onMetaData 的字段 (不含外层括号)
+    void appendMetaDataJson(const FlvMetaData& meta);
+
+    Format format_;
+    FILE* out_;
+    std::string buf_;
+    bool ok_ = true;
+    bool metaHeaderWritten_ = false;
+};
+
+#endif // FLVTAGWRITER_H
@@ -1,265 +1,319 @@
 /**
  * FLV Parser (FLV 格式分析器)
  * 包含：Header 解析, Tag 遍历, H.264/AAC 详细信息提取, DTS/PTS 计算
+ *
+ * Tag 在内存映射 (或可复用的读取缓冲) 上原地解析，不为每个 Tag 分配内存；
+ * 逐 Tag 信息可以输出为文本、CSV、JSON Lines，或者只输出汇总。
+ *
+ * --metadata 模式只读取每个文件开头的 onMetaData，可以一次快速查看成千上万个文件的时长、帧率、码率。
+ * --health 模式汇总每秒码率、时间戳异常、音视频交织漂移和 PreviousTagSize 一致性，输出一份简短报告。
+ * 可以顺便建立关键帧索引 (时间戳 -> 文件偏移)，并像 yamdi 一样写回 onMetaData 的 keyframes。
+ *
+ * 文件名为 "-" 时从标准输入边读边解析，可以接管道或 socket 实时查看直播流：
+ *   ffmpeg -i rtmp://... -c copy -f flv - | ./flv_demux --format jsonl -
  */
 
 #include <iostream>
-#include <fstream>
-#include <utility>
-#include <vector>
 #include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
 #include <cstdint>
+#include <cstdio>
 #include <string>
+#include <vector>
 
-// ==========================================
-// 1. 辅助工具：大端序读取与格式化
-// ==========================================
-
-// 读取 4 字节无符号整数 (Big Endian)
-uint32_t readUI32(const uint8_t* buffer) {
-    return (buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3];
-}
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "FLVParser.h"
+#include "FlvHealthChecker.h"
+#include "FlvKeyframeIndex.h"
+#include "FlvMetaData.h"
+#include "FlvTagWriter.h"
+
+/// 读取窗口大小 (内存映射失败或关闭时使用)
+const size_t READ_WINDOW_SIZE = 8 * 1024 * 1024;
+
+/// 从标准输入读取时每次最多读取的字节数
+const size_t STREAM_READ_SIZE = 64 * 1024;
+
+/// 按 Tag 类型汇总的统计
+struct TagTypeStats {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
 
-// 读取 3 字节无符号整数 (Big Endian)
-uint32_t readUI24(const uint8_t* buffer) {
-    return (buffer[0] << 16) | (buffer[1] << 8) | buffer[2];
+void printUsage(const char* prog) {
+    std::cout << "Usage: " << prog << " [--format text|csv|jsonl|quiet] [-o <output_file>] [--no-mmap] <file.flv | ->"
+              << std::endl;
+    std::cout << "  --format   逐 Tag 输出格式，默认 text；quiet 只输出汇总" << std::endl;
+    std::cout << "  -o         逐 Tag 输出写入文件，默认标准输出" << std::endl;
+    std::cout << "  --no-mmap  不使用内存映射，按 8MB 窗口读取" << std::endl;
+    std::cout << "  文件名为 - 时从标准输入实时读取，可选 --read-size <bytes> (默认 64KB)" << std::endl;
+    std::cout << "  --max-tag-buffer <bytes>  跨块 Tag 的最大缓冲 (默认 4MB)，更大的 Tag 只保留开头" << std::endl;
+    std::cout << "  --metadata <files...>     只读取每个文件的 onMetaData，每个文件输出一行" << std::endl;
+    std::cout << "  --health                  健康检查报告 (默认不再逐 Tag 输出)，发现问题时返回 2" << std::endl;
+    std::cout << "  --gap-ms <ms> / --jump-ms <ms> / --drift-ms <ms>  间隙、跳变、A/V 漂移的阈值 (默认 1000 / 10000 / 500)"
+              << std::endl;
+    std::cout << "  --keyframes               打印关键帧索引 (时间 -> 文件偏移)" << std::endl;
+    std::cout << "  --seek <seconds>          在关键帧索引中查找该时间对应的拖动位置" << std::endl;
+    std::cout << "  --inject-keyframes <out.flv>  把关键帧索引写进 onMetaData 的 keyframes 另存为新文件" << std::endl;
 }
 
-// 读取 3 字节有符号整数 (CompositionTime 是 SI24)
-int32_t readSI24(const uint8_t* buffer) {
-    uint32_t val = (buffer[0] << 16) | (buffer[1] << 8) | buffer[2];
-    // 如果第 24 位是 1，说明是负数，需要进行符号扩展
-    if (val & 0x800000) {
-        val |= 0xFF000000;
+/**
+ * @brief --metadata 模式：逐个文件读取 onMetaData
+ *
+ * 每个文件只读到 onMetaData 为止；keyframes 数组只在需要打印时才解码。
+ */
+int printMetaData(const std::vector<std::string>& files, FlvTagWriter& writer, std::ostream& log,
+                  bool printKeyframes) {
+    auto start = std::chrono::steady_clock::now();
+    int failed = 0;
+    std::vector<FlvKeyframeIndex::Entry> keyframes;
+    for (const auto& path : files) {
+        FlvMetaData meta;
+        std::string error;
+        if (!readFileMetaData(path, meta, &error, printKeyframes ? &keyframes : nullptr)) {
+            std::cerr << "Error: " << path << ": " << error << std::endl;
+            failed++;
+            continue;
+        }
+        writer.writeMetaData(path, meta);
+        if (printKeyframes) {
+            writer.flush();
+            for (size_t i = 0; i < keyframes.size(); i++) {
+                log << "  #" << i << "  " << formatTime(keyframes[i].dts) << "  offset " << keyframes[i].offset
+                    << std::endl;
+            }
+        }
     }
-    return static_cast<int32_t>(val);
-}
-
-// 读取 2 字节无符号整数
-uint16_t readUI16(const uint8_t* buffer) {
-    return (buffer[0] << 8) | buffer[1];
-}
-
-// 格式化输出时间戳
-std::string formatTime(uint32_t ms) {
-    char buf[64];
-    uint32_t sec = ms / 1000;
-    uint32_t msec = ms % 1000;
-    snprintf(buf, sizeof(buf), "%u.%03us", sec, msec);
-    return {buf};
+    bool writeOk = writer.flush();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    log << "Files: " << files.size() << " (" << failed << " failed) in " << std::fixed << std::setprecision(3)
+        << seconds << " s" << std::endl;
+    if (!writeOk) {
+        std::cerr << "Error: 写入输出失败" << std::endl;
+        return -1;
+    }
+    return failed > 0 ? 1 : 0;
 }
 
-// ==========================================
-// 2. 核心解析逻辑
-// ==========================================
-
-class FLVParser {
-public:
-    FLVParser(std::string  filename) : filename_(std::move(filename)) {}
-
-    bool run() {
-        std::ifstream file(filename_, std::ios::binary);
-        if (!file.is_open()) {
-            std::cerr << "Error: 无法打开文件 " << filename_ << std::endl;
+/**
+ * @brief 从标准输入读取直到 EOF，每次读到数据立即 feed
+ *
+ * 用 read() 而不是 fread()：管道或 socket 里有多少就返回多少，
+ * 不会为了凑满缓冲一直等待，Tag 一到齐就能输出。
+ */
+bool parseStream(FLVParser& parser, FlvTagWriter& writer, size_t readSize, std::string* error) {
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    std::vector<uint8_t> buffer(std::max<size_t>(readSize, 1));
+    while (true) {
+#ifdef _WIN32
+        const int n = _read(0, buffer.data(), static_cast<unsigned int>(buffer.size()));
+#else
+        const ssize_t n = read(0, buffer.data(), buffer.size());
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        if (n < 0) {
+            if (error) *error = "读取标准输入失败";
             return false;
         }
-
-        if (!parseHeader(file)) {
+        if (n == 0) break;
+        if (!parser.feed(buffer.data(), static_cast<size_t>(n))) {
+            if (error) *error = parser.error();
             return false;
         }
-
-        parseBody(file);
-
-        file.close();
-        return true;
+        // 实时查看时每块数据的输出立即写出
+        writer.flush();
     }
-
-private:
-    std::string filename_;
-
-    // 解析 FLV Header (9字节)
-    static bool parseHeader(std::ifstream& file) {
-        uint8_t buffer[9];
-        if (!file.read((char*)buffer, 9)) return false;
-
-        // Signature Check [cite: 58]
-        if (buffer[0] != 'F' || buffer[1] != 'L' || buffer[2] != 'V') {
-            std::cerr << "Error: 不是有效的 FLV 文件 (Signature 错误)" << std::endl;
-            return false;
-        }
-
-        uint8_t version = buffer[3];
-        uint8_t flags = buffer[4];
-        uint32_t headerSize = readUI32(buffer + 5); // DataOffset
-
-        bool hasAudio = flags & 0x04;
-        bool hasVideo = flags & 0x01;
-
-        std::cout << "========= FLV File Header =========" << std::endl;
-        std::cout << "Version: " << (int)version << std::endl;
-        std::cout << "Contains: " << (hasAudio ? "Audio " : "") << (hasVideo ? "Video" : "") << std::endl;
-        std::cout << "Header Size: " << headerSize << std::endl;
-        std::cout << "===================================" << std::endl;
-
-        // 跳过 Header 可能存在的填充字节，通常 headerSize=9
-        file.seekg(headerSize, std::ios::beg);
-        return true;
+    if (!parser.finish()) {
+        if (error) *error = parser.error();
+        return false;
     }
+    return true;
+}
 
-    // 循环解析 Tag
-    static void parseBody(std::ifstream& file) {
-        uint8_t prevTagSizeBuf[4];
-        uint8_t tagHeaderBuf[11];
-        int tagIndex = 0;
-
-        while (true) {
-            // 1. 读取 PreviousTagSize [cite: 19]
-            if (!file.read((char*)prevTagSizeBuf, 4)) break; // EOF check
-            uint32_t prevTagSize = readUI32(prevTagSizeBuf);
-
-            // 2. 读取 Tag Header 
-            if (!file.read((char*)tagHeaderBuf, 11)) break;
-
-            uint8_t tagType = tagHeaderBuf[0];
-            uint32_t dataSize = readUI24(tagHeaderBuf + 1);
-
-            // 时间戳计算：Timestamp(低24位) | TimestampExtended(高8位) 
-            uint32_t timestamp = readUI24(tagHeaderBuf + 4);
-            uint8_t timestampExt = tagHeaderBuf[7];
-            uint32_t dts = (timestampExt << 24) | timestamp; // DTS (Decoding Time Stamp)
-
-            uint32_t streamID = readUI24(tagHeaderBuf + 8); // Always 0
-
-            // 3. 读取 Tag Data
-            std::vector<uint8_t> data(dataSize);
-            file.read((char*)data.data(), dataSize);
-
-            // 打印基础信息
-            std::cout << "\n[Tag #" << tagIndex++ << "] Type: ";
-            switch (tagType) {
-                case 0x08: std::cout << "Audio"; break;
-                case 0x09: std::cout << "Video"; break;
-                case 0x12: std::cout << "Script"; break;
-                default:   std::cout << "Unknown(" << (int)tagType << ")"; break;
-            }
-            std::cout << " | Size: " << dataSize
-                      << " | DTS: " << dts << "ms (" << formatTime(dts) << ")";
+// ==========================================
+// 主程序入口
+// ==========================================
 
-            // 4. 详细解析
-            if (tagType == 0x09) {
-                parseVideoTag(data, dts);
-            } else if (tagType == 0x08) {
-                parseAudioTag(data);
-            } else if (tagType == 0x12) {
-                // Script Tag 解析比较复杂(AMF格式)，此处仅做简单标记
-                std::cout << " -> MetaData Info";
+int main(int argc, char* argv[]) {
+    // 默认测试文件名，可以在这里修改
+    std::string filename = "test.flv";
+    std::string outputPath;
+    FlvTagWriter::Format format = FlvTagWriter::FORMAT_TEXT;
+    bool formatGiven = false;
+    bool useMmap = true;
+    size_t readSize = STREAM_READ_SIZE;
+    size_t maxTagBuffer = FLVParser::DEFAULT_MAX_BUFFERED_TAG;
+    bool printKeyframes = false;
+    double seekSeconds = -1;
+    std::string injectPath;
+    bool metadataOnly = false;
+    std::vector<std::string> files;
+    bool health = false;
+    FlvHealthChecker::Options healthOptions;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            if (!FlvTagWriter::parseFormat(argv[++i], format)) {
+                printUsage(argv[0]);
+                return -1;
             }
-            std::cout << std::endl;
+            formatGiven = true;
+        } else if (arg == "-o" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (arg == "--no-mmap") {
+            useMmap = false;
+        } else if (arg == "--read-size" && i + 1 < argc) {
+            readSize = static_cast<size_t>(std::atol(argv[++i]));
+        } else if (arg == "--max-tag-buffer" && i + 1 < argc) {
+            maxTagBuffer = static_cast<size_t>(std::atol(argv[++i]));
+        } else if (arg == "--health") {
+            health = true;
+        } else if (arg == "--gap-ms" && i + 1 < argc) {
+            healthOptions.gapMs = static_cast<uint32_t>(std::atol(argv[++i]));
+        } else if (arg == "--jump-ms" && i + 1 < argc) {
+            healthOptions.jumpMs = static_cast<uint32_t>(std::atol(argv[++i]));
+        } else if (arg == "--drift-ms" && i + 1 < argc) {
+            healthOptions.driftMs = static_cast<uint32_t>(std::atol(argv[++i]));
+        } else if (arg == "--metadata") {
+            metadataOnly = true;
+        } else if (arg == "--keyframes") {
+            printKeyframes = true;
+        } else if (arg == "--seek" && i + 1 < argc) {
+            seekSeconds = std::atof(argv[++i]);
+        } else if (arg == "--inject-keyframes" && i + 1 < argc) {
+            injectPath = argv[++i];
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            files.push_back(arg);
         }
     }
-
-    // 解析视频 Tag Data [cite: 226]
-    static void parseVideoTag(const std::vector<uint8_t>& data, uint32_t dts) {
-        if (data.empty()) return;
-
-        // 第1个字节：FrameType (高4位) + CodecID (低4位) [cite: 232]
-        uint8_t val = data[0];
-        uint8_t frameType = (val >> 4) & 0x0F;
-        uint8_t codecID = val & 0x0F;
-
-        std::string frameDesc;
-        switch (frameType) {
-            case 1: frameDesc = "KeyFrame (IDR)"; break; // 关键帧
-            case 2: frameDesc = "InterFrame"; break;     // 普通帧
-            default: frameDesc = "Other"; break;
-        }
-
-        std::string codecDesc;
-        if (codecID == 7) codecDesc = "AVC(H.264)";
-        else codecDesc = "Other(" + std::to_string(codecID) + ")";
-
-        std::cout << "\n    -> Video Info: " << codecDesc << ", " << frameDesc;
-
-        // 如果是 H.264 (AVC) [cite: 234]
-        if (codecID == 7 && data.size() >= 5) {
-            // data[1] = AVCPacketType
-            // data[2-4] = CompositionTime (CTS)
-            uint8_t avcPacketType = data[1];
-            int32_t cts = readSI24(&data[2]); // Composition Time Offset
-
-            // PTS = DTS + CTS 
-            // 注意：如果 AVCPacketType 为 0 (Header)，CTS 通常为 0
-            int64_t pts = dts + cts;
-
-            std::cout << "\n    -> AVC Packet: ";
-            if (avcPacketType == 0) {
-                std::cout << "Sequence Header (AVCDecoderConfigurationRecord)";
-                std::cout << " [SPS/PPS info]";
-            } else if (avcPacketType == 1) {
-                std::cout << "NALU";
-                std::cout << " | CTS: " << cts << "ms";
-                std::cout << " | PTS: " << pts << "ms (" << formatTime(pts) << ")";
-            } else if (avcPacketType == 2) {
-                std::cout << "End of Sequence";
-            }
+    if (!files.empty()) filename = files.back();
+    if (files.empty()) files.push_back(filename);
+    // 健康检查时几百万行逐 Tag 输出没人看，除非明确指定了格式
+    if (health && !formatGiven) format = FlvTagWriter::FORMAT_QUIET;
+
+    // 改写需要再读一遍输入文件，标准输入做不到
+    if (!injectPath.empty() && filename == "-") {
+        std::cerr << "Error: --inject-keyframes 不支持标准输入" << std::endl;
+        return -1;
+    }
+    const bool buildIndex = printKeyframes || seekSeconds >= 0 || !injectPath.empty();
+
+    FILE* out = stdout;
+    if (!outputPath.empty()) {
+        out = fopen(outputPath.c_str(), "wb");
+        if (!out) {
+            std::cerr << "Error: 无法创建输出文件 " << outputPath << std::endl;
+            return -1;
         }
     }
+    // CSV / JSON Lines 写到标准输出时，提示和汇总改走标准错误，保证输出可以直接被程序读取
+    const bool structured = format == FlvTagWriter::FORMAT_CSV || format == FlvTagWriter::FORMAT_JSONL;
+    std::ostream& log = (structured && out == stdout) ? std::cerr : std::cout;
+
+    FlvTagWriter writer(format, out);
+    if (metadataOnly) {
+        int ret = printMetaData(files, writer, log, printKeyframes);
+        if (out != stdout && fclose(out) != 0) ret = -1;
+        return ret;
+    }
 
-    // 解析音频 Tag Data [cite: 197]
-    static void parseAudioTag(const std::vector<uint8_t>& data) {
-        if (data.empty()) return;
-
-        // 第1个字节：SoundFormat(4bit) Rate(2bit) Size(1bit) Type(1bit) [cite: 204]
-        uint8_t val = data[0];
-        uint8_t format = (val >> 4) & 0x0F;
-        uint8_t rateIndex = (val >> 2) & 0x03;
-        uint8_t sizeIndex = (val >> 1) & 0x01;
-        uint8_t typeIndex = val & 0x01;
-
-        std::string fmtStr;
-        if (format == 10) fmtStr = "AAC";
-        else if (format == 2) fmtStr = "MP3";
-        else fmtStr = "Format_" + std::to_string(format);
-
-        // 采样率映射 (注意：AAC 通常忽略此字段，实际信息在 Sequence Header 中)
-        int rates[] = {5500, 11000, 22050, 44100};
+    log << "Opening file: " << filename << "..." << std::endl;
+    TagTypeStats audio, video, script, other;
+    uint32_t lastDts = 0;
+    FlvKeyframeIndex keyframes;
+    FlvHealthChecker checker(healthOptions);
+
+    FLVParser parser(
+        [&](const FlvHeader& header) {
+            writer.writeHeader(header);
+        },
+        [&](const FlvTag& tag) {
+            TagTypeStats& s = tag.type == FLV_TAG_AUDIO ? audio
+                              : tag.type == FLV_TAG_VIDEO ? video
+                              : tag.type == FLV_TAG_SCRIPT ? script : other;
+            s.count++;
+            s.bytes += tag.dataSize;
+            if (tag.type != FLV_TAG_SCRIPT) lastDts = tag.dts;
+            writer.writeTag(tag);
+            if (buildIndex) keyframes.addTag(tag);
+            if (health) checker.addTag(tag);
+        },
+        maxTagBuffer);
+
+    auto start = std::chrono::steady_clock::now();
+    std::string error;
+    bool ok = filename == "-" ? parseStream(parser, writer, readSize, &error)
+                              : parser.parseFile(filename, useMmap, READ_WINDOW_SIZE, &error);
+    bool writeOk = writer.flush();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (out != stdout) writeOk = fclose(out) == 0 && writeOk;
+
+    if (!ok) {
+        std::cerr << "Error: " << error << std::endl;
+        return -1;
+    }
+    if (!writeOk) {
+        std::cerr << "Error: 写入输出失败" << std::endl;
+        return -1;
+    }
 
-        std::cout << "\n    -> Audio Info: " << fmtStr
-                  << " | " << rates[rateIndex] << "Hz"
-                  << " | " << (sizeIndex ? "16-bit" : "8-bit")
-                  << " | " << (typeIndex ? "Stereo" : "Mono");
+    // 汇总
+    double mb = parser.bytesParsed() / (1024.0 * 1024.0);
+    log << "\n========= Summary =========" << std::endl;
+    log << "Tags: " << parser.tagCount() << " (Video " << video.count << " / " << video.bytes << " bytes, Audio "
+        << audio.count << " / " << audio.bytes << " bytes, Script " << script.count;
+    if (other.count > 0) log << ", Unknown " << other.count;
+    log << ")" << std::endl;
+    log << "Last DTS: " << lastDts << "ms (" << formatTime(lastDts) << ")" << std::endl;
+    log << "Parsed: " << std::fixed << std::setprecision(2) << mb << " MB in " << seconds << " s ("
+        << (seconds > 0 ? mb / seconds : 0.0) << " MB/s)" << std::endl;
+    if (parser.trailingBytes() > 0) {
+        log << "Warning: 文件末尾有 " << parser.trailingBytes() << " 字节不完整的 Tag (文件可能被截断)" << std::endl;
+    }
 
-        // 如果是 AAC [cite: 218]
-        if (format == 10 && data.size() >= 2) {
-            uint8_t aacPacketType = data[1];
-            std::cout << "\n    -> AAC Packet: ";
-            if (aacPacketType == 0) {
-                std::cout << "Sequence Header (AudioSpecificConfig)";
-            } else if (aacPacketType == 1) {
-                std::cout << "Raw Data";
+    if (buildIndex) {
+        const auto& entries = keyframes.entries();
+        log << "Keyframes: " << entries.size();
+        if (keyframes.skipped() > 0) log << " (另有 " << keyframes.skipped() << " 个 DTS 倒退的关键帧未收入索引)";
+        log << std::endl;
+        if (printKeyframes) {
+            for (size_t i = 0; i < entries.size(); i++) {
+                log << "  #" << i << "  " << formatTime(entries[i].dts) << "  offset " << entries[i].offset << std::endl;
             }
         }
+        if (seekSeconds >= 0) {
+            const auto* e = keyframes.seek(static_cast<uint32_t>(seekSeconds * 1000));
+            if (e) log << "Seek " << seekSeconds << "s -> " << formatTime(e->dts) << " @ offset " << e->offset << std::endl;
+            else log << "Seek: 没有关键帧" << std::endl;
+        }
     }
-};
-
-// ==========================================
-// 3. 主程序入口
-// ==========================================
-
-int main(int argc, char* argv[]) {
-    // 默认测试文件名，可以在这里修改
-    std::string filename = "test.flv";
-
-    if (argc > 1) {
-        filename = argv[1];
+    if (!injectPath.empty()) {
+        if (!keyframes.writeWithKeyframes(filename, injectPath, &error)) {
+            std::cerr << "Error: " << error << std::endl;
+            return -1;
+        }
+        log << "已写入带关键帧索引的文件: " << injectPath << std::endl;
     }
-
-    std::cout << "Opening file: " << filename << "..." << std::endl;
-
-    FLVParser parser(filename);
-    if (!parser.run()) {
-        return -1;
+    if (health) {
+        checker.setTrailingBytes(parser.trailingBytes());
+        checker.printReport(log);
+        if (checker.problemCount() > 0) return 2;
     }
 
     return 0;
-}
\ No newline at end of file
+}